@@ -0,0 +1,300 @@
+#include "Arduino.h"
+#include "WebLogic.h"
+
+// ----------------------------------------------------------------------------------------------------
+// ------------------------------------------- Parsing ------------------------------------------------
+// ----------------------------------------------------------------------------------------------------
+
+/**
+   Split a string based on a separator, get the element given by index
+*/
+String getValue(String data, char separator, int index)
+{
+  int found = 0;
+  int strIndex[] = {0, -1};
+  int maxIndex = data.length() - 1;
+  for (int i = 0; i <= maxIndex && found <= index; i++) {
+    if (data.charAt(i) == separator || i == maxIndex) {
+      found++;
+      strIndex[0] = strIndex[1] + 1;
+      strIndex[1] = (i == maxIndex) ? i + 1 : i;
+    }
+  }
+  return found > index ? data.substring(strIndex[0], strIndex[1]) : "";
+}
+
+/**
+   Split a string based on a separator, get the element given by index, return an integer value
+*/
+int getIntValue(String data, char separator, int index) {
+  String result = getValue(data, separator, index);
+  return atoi(result.c_str());
+}
+
+// ----------------------------------------------------------------------------------------------------
+// ------------------------------------------- HTML builders ------------------------------------------
+// ----------------------------------------------------------------------------------------------------
+
+/**
+   Get the bootstrap top row navbar, including the Bootstrap links
+*/
+String getNavBar() {
+  String navbar = "<nav class=\"navbar navbar-inverse navbar-fixed-top\">";
+  navbar += "<div class=\"container-fluid\"><div class=\"navbar-header\"><button type=\"button\" class=\"navbar-toggle collapsed\" data-toggle=\"collapse\" data-target=\"#navbar\" aria-expanded=\"false\" aria-controls=\"navbar\">";
+  navbar += "<span class=\"sr-only\">Toggle navigation</span><span class=\"icon-bar\"></span><span class=\"icon-bar\"></span><span class=\"icon-bar\"></span></button>";
+  navbar += "<a class=\"navbar-brand\" href=\"#\">Arduino Nixie Clock Time Module</a></div><div id=\"navbar\" class=\"navbar-collapse collapse\"><ul class=\"nav navbar-nav navbar-right\">";
+  navbar += "<li><a href=\"/\">Summary</a></li><li><a href=\"/time\">Configure Time Server</a></li><li><a href=\"/wlan_config\">Configure WLAN settings</a></li><li><a href=\"/clockconfig\">Configure clock settings</a></li><li><a href=\"/alarms\">Alarms</a></li><li><a href=\"/timers\">Timers</a></li><li><a href=\"/rejuvenate\">Rejuvenate</a></li><li><a href=\"/selftest\">Self test</a></li><li><a href=\"/dashboard\">Dashboard</a></li><li><a href=\"/power\">Power</a></li><li><a href=\"/config\">Backup</a></li></ul></div></div></nav>";
+  return navbar;
+} 
+
+/**
+   Get the header for a 2 column table
+*/
+String getTableHead2Col(String tableHeader, String col1Header, String col2Header) {
+  String tableHead = "<div class=\"container\" role=\"main\"><h3 class=\"sub-header\">";
+  tableHead += tableHeader;
+  tableHead += "</h3><div class=\"table-responsive\"><table class=\"table table-striped\"><thead><tr><th>";
+  tableHead += col1Header;
+  tableHead += "</th><th>";
+  tableHead += col2Header;
+  tableHead += "</th></tr></thead><tbody>";
+
+  return tableHead;
+}
+
+String getTableRow2Col(String col1Val, String col2Val) {
+  String tableRow = "<tr><td>";
+  tableRow += col1Val;
+  tableRow += "</td><td>";
+  tableRow += col2Val;
+  tableRow += "</td></tr>";
+
+  return tableRow;
+}
+
+String getTableRow2Col(String col1Val, int col2Val) {
+  String tableRow = "<tr><td>";
+  tableRow += col1Val;
+  tableRow += "</td><td>";
+  tableRow += col2Val;
+  tableRow += "</td></tr>";
+
+  return tableRow;
+}
+
+String getTableFoot() {
+  return "</tbody></table></div></div>";
+}
+
+/**
+   Get the header for an input form
+*/
+String getFormHead(String formTitle) {
+  String tableHead = "<div class=\"container\" role=\"main\"><h3 class=\"sub-header\">";
+  tableHead += formTitle;
+  tableHead += "</h3><form class=\"form-horizontal\">";
+
+  return tableHead;
+}
+
+/**
+   Get the header for an input form
+*/
+String getFormFoot() {
+  return "</form></div>";
+}
+
+String getHTMLFoot() {
+  return "</body></html>";
+}
+
+/**
+   Get a tag that sends the browser to the url after a few seconds, for pages waiting on background work
+*/
+String getRefresh(String url, int secs) {
+  return "<meta http-equiv=\"refresh\" content=\"" + String(secs) + ";url=" + url + "\">";
+}
+
+String getRadioGroupHeader(String header) {
+  String result = "<div class=\"form-group\"><label class=\"control-label col-xs-3\">";
+  result += header;
+  result += "</label>";
+  return result;
+}
+
+String getRadioButton(String group_name, String text, String value, boolean checked) {
+  String result = "<div class=\"col-xs-1\">";
+  if (checked) {
+    result += "<label class=\"radio-inline\"><input checked type=\"radio\" name=\"";
+  } else {
+    result += "<label class=\"radio-inline\"><input type=\"radio\" name=\"";
+  }
+  result += group_name;
+  result += "\" value=\"";
+  result += value;
+  result += "\"> ";
+  result += text;
+  result += "</label></div>";
+  return result;
+}
+
+String getRadioGroupFooter() {
+  String result = "</div>";
+  return result;
+}
+
+String getCheckBox(String checkbox_name, String value, String text, boolean checked) {
+  String result = "<div class=\"form-group\"><div class=\"col-xs-offset-3 col-xs-9\"><label class=\"checkbox-inline\">";
+  if (checked) {
+    result += "<input checked type=\"checkbox\" name=\"";
+  } else {
+    result += "<input type=\"checkbox\" name=\"";
+  }
+
+  result += checkbox_name;
+  result += "\" value=\"";
+  result += value;
+  result += "\"> ";
+  result += text;
+  result += "</label></div></div>";
+
+  return result;
+}
+
+String getInlineCheckBox(String checkbox_name, String text, boolean checked) {
+  String result = "<label class=\"checkbox-inline\">";
+  if (checked) {
+    result += "<input checked type=\"checkbox\" name=\"";
+  } else {
+    result += "<input type=\"checkbox\" name=\"";
+  }
+
+  result += checkbox_name;
+  result += "\" value=\"on\"> ";
+  result += text;
+  result += "</label>";
+
+  return result;
+}
+
+String getDropDownHeader(String heading, String group_name, boolean wide) {
+  String result = "<div class=\"form-group\"><label class=\"control-label col-xs-3\">";
+  result += heading;
+  if (wide) {
+    result += "</label><div class=\"col-xs-8\"><select class=\"form-control\" name=\"";
+  } else {
+    result += "</label><div class=\"col-xs-2\"><select class=\"form-control\" name=\"";
+  }
+  result += group_name;
+  result += "\">";
+  return result;
+}
+
+String getDropDownOption (String value, String text, boolean checked) {
+  String result = "";
+  if (checked) {
+    result += "<option selected value=\"";
+  } else {
+    result += "<option value=\"";
+  }
+  result += value;
+  result += "\">";
+  result += text;
+  result += "</option>";
+  return result;
+}
+
+String getDropDownFooter() {
+  return "</select></div></div>";
+}
+
+String getNumberInput(String heading, String input_name, unsigned int minVal, unsigned int maxVal, unsigned int value, boolean disabled) {
+  String result = "<div class=\"form-group\"><label class=\"control-label col-xs-3\" for=\"";
+  result += input_name;
+  result += "\">";
+  result += heading;
+  result += "</label><div class=\"col-xs-2\"><input type=\"number\" class=\"form-control\" name=\"";
+  result += input_name;
+  result += "\" id=\"";
+  result += input_name;
+  result += "\" min=\"";
+  result += minVal;
+  result += "\" max=\"";
+  result += maxVal;
+  result += "\" value=\"";
+  result += value;
+  if (disabled) {
+    result += " disabled";
+  }
+  result += "\"></div></div>";
+
+  return result;
+}
+
+String getNumberInputWide(String heading, String input_name, byte minVal, byte maxVal, byte value, boolean disabled) {
+  String result = "<div class=\"form-group\"><label class=\"control-label col-xs-8\" for=\"";
+  result += input_name;
+  result += "\">";
+  result += heading;
+  result += "</label><div class=\"col-xs-2\"><input type=\"number\" class=\"form-control\" name=\"";
+  result += input_name;
+  result += "\" id=\"";
+  result += input_name;
+  result += "\" min=\"";
+  result += minVal;
+  result += "\" max=\"";
+  result += maxVal;
+  result += "\" value=\"";
+  result += value;
+  if (disabled) {
+    result += " disabled";
+  }
+  result += "\"></div></div>";
+
+  return result;
+}
+
+String getTextInput(String heading, String input_name, String value, boolean disabled) {
+  String result = "<div class=\"form-group\"><label class=\"control-label col-xs-3\" for=\"";
+  result += input_name;
+  result += "\">";
+  result += heading;
+  result += "</label><div class=\"col-xs-2\"><input type=\"text\" class=\"form-control\" name=\"";
+  result += input_name;
+  result += "\" id=\"";
+  result += input_name;
+  result += "\" value=\"";
+  result += value;
+  if (disabled) {
+    result += " disabled";
+  }
+  result += "\"></div></div>";
+
+  return result;
+}
+
+String getTextInputWide(String heading, String input_name, String value, boolean disabled) {
+  String result = "<div class=\"form-group\"><label class=\"control-label col-xs-3\" for=\"";
+  result += input_name;
+  result += "\">";
+  result += heading;
+  result += "</label><div class=\"col-xs-8\"><input type=\"text\" class=\"form-control\" name=\"";
+  result += input_name;
+  result += "\" id=\"";
+  result += input_name;
+  result += "\" value=\"";
+  result += value;
+  if (disabled) {
+    result += " disabled";
+  }
+  result += "\"></div></div>";
+
+  return result;
+}
+
+String getSubmitButton(String buttonText) {
+  String result = "<div class=\"form-group\"><div class=\"col-xs-offset-3 col-xs-9\"><input type=\"submit\" class=\"btn btn-primary\" value=\"";
+  result += buttonText;
+  result += "\"></div></div>";
+  return result;
+}
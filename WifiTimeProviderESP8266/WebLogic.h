@@ -0,0 +1,39 @@
+#ifndef WebLogic_h
+#define WebLogic_h
+
+#include "Arduino.h"
+
+// The string work behind the web pages: splitting the values the clock
+// and the time server send, and building the page fragments. Nothing in
+// here touches the WiFi, the clock or the module globals, so these can be
+// built and timed away from the module.
+
+// Parsing
+String getValue(String data, char separator, int index);
+int getIntValue(String data, char separator, int index);
+
+// Page fragments
+String getNavBar();
+String getTableHead2Col(String tableHeader, String col1Header, String col2Header);
+String getTableRow2Col(String col1Val, String col2Val);
+String getTableRow2Col(String col1Val, int col2Val);
+String getTableFoot();
+String getFormHead(String formTitle);
+String getFormFoot();
+String getHTMLFoot();
+String getRefresh(String url, int secs);
+String getRadioGroupHeader(String header);
+String getRadioButton(String group_name, String text, String value, boolean checked);
+String getRadioGroupFooter();
+String getCheckBox(String checkbox_name, String value, String text, boolean checked);
+String getInlineCheckBox(String checkbox_name, String text, boolean checked);
+String getDropDownHeader(String heading, String group_name, boolean wide);
+String getDropDownOption(String value, String text, boolean checked);
+String getDropDownFooter();
+String getNumberInput(String heading, String input_name, unsigned int minVal, unsigned int maxVal, unsigned int value, boolean disabled);
+String getNumberInputWide(String heading, String input_name, byte minVal, byte maxVal, byte value, boolean disabled);
+String getTextInput(String heading, String input_name, String value, boolean disabled);
+String getTextInputWide(String heading, String input_name, String value, boolean disabled);
+String getSubmitButton(String buttonText);
+
+#endif
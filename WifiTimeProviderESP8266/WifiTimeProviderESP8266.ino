@@ -24,7 +24,9 @@
 #include <Wire.h>
 #include <EEPROM.h>
 #include <time.h>
+#include <DS3231.h>
 #include "I2CDefs.h"
+#include "WebLogic.h"
   
 #define SOFTWARE_VERSION "v54"
 #define DEFAULT_TIME_SERVER_URL "http://time-zone-server.scapp.io/getTime/Europe/Zurich"
@@ -52,11 +54,112 @@ long lastI2CUpdateTime = 0;
 byte preferredI2CSlaveAddress = 0xFF;
 byte preferredAddressFoundBy = 0; // 0 = not found, 1 = found by default, 2 = found by ping
 
+// I2C bus speed, negotiated with the clock
+#define I2C_FAST_MODE_MAX_ERRORS 3    // consecutive errors in fast mode before we drop back to standard
+#define I2C_RENEGOTIATE_MS 300000     // handshake again after this long without errors
+#define I2C_RENEGOTIATE_RETRY_MS 5000 // sooner if a clock that knows the handshake didn't answer it
+boolean i2cFastMode = false;
+byte i2cConsecutiveErrors = 0;
+unsigned long i2cErrorCount = 0;      // all I2C errors since we started
+unsigned long i2cLastErrorTime = 0;
+unsigned long i2cLastNegotiateTime = 0;
+boolean i2cHandshakeOK = false;       // the clock answered the last handshake
+boolean i2cHandshakeSeen = false;     // the clock has answered a handshake since we started
+boolean i2cClockRestarted = false;    // its status sequence went back, so it lost what we agreed
+byte i2cLastReceivedSeq = 0;
+
+// Confirmation of option writes
+#define I2C_APPLY_TIMEOUT_MS 250      // how long we give the clock to save an option
+boolean clockHasStatus = false;       // true if the clock can tell us when an option has been saved
+byte optionWriteFailures = 0;         // option writes that failed since the last config page
+
+// RTC proxy: clocks that ask for it leave all RTC traffic to us
+#define RTC_I2C_ADDRESS 0x68
+#define RTC_PROXY_POLL_MS 1000        // how often we check whether the time was set on the clock
+#define RTC_PUSH_MS 60000             // how often we send the RTC time when we have no time server
+DS3231 Clock;
+boolean clockUsesRTCProxy = false;    // true if the clock wants us to handle the RTC
+boolean useRTC = false;               // true if we found an RTC on the bus
+boolean timeServerOK = false;         // true if the last time server request worked
+unsigned long lastRTCProxyPollTime = 0;
+unsigned long lastRTCPushTime = 0;
+
+// Live telemetry: one poll of the clock per interval, streamed to every /events viewer
+#define SSE_MAX_CLIENTS 4
+#define TELEMETRY_INTERVAL_MIN_S 1        // the clock rebuilds its telemetry once a second
+#define TELEMETRY_INTERVAL_MAX_S 60
+WiFiClient sseClients[SSE_MAX_CLIENTS];
+byte telemetryIntervalSecs = 2;
+unsigned long lastTelemetryPollTime = 0;
+boolean telemetrySendAll = true;      // a new viewer needs every value, not just what changed
+
+// What we last streamed, so we only send what changed
+long lastTelemHV = 0;
+long lastTelemBrightness = 0;
+long lastTelemImpressions = 0;
+long lastTelemFlags = 0;
+long lastTelemTimeOK = 0;
+long lastTelemSyncAge = 0;
+long lastTelemI2CErrors = 0;
+
 String timeServerURL = "";
 
+// Time server connection, kept open between syncs when the server allows it
+#define TIME_SERVER_SMOOTHING 8       // samples the latency average runs over
+WiFiClient timeServerWiFiClient;
+HTTPClient timeServerHttp;
+unsigned long timeServerRequests = 0;
+unsigned long timeServerConnects = 0; // requests that needed a new connection
+long timeServerLatency = 0;           // mS the last good request took
+long timeServerLatencyAve = 0;
+long timeServerJitter = 0;            // average difference from the average latency
+
+// Slow work the page handlers leave to the loop, so that a page never waits on the network
+#define TIME_SERVER_TIMEOUT_MS 2000   // longest a time sync can hold up the loop
+#define WLAN_CONNECT_TIMEOUT_MS 10000
+boolean timeSyncRequested = false;    // /updatetime wants the time sent now
+String lastTimeString = "";           // what the time server said on the last sync
+String pendingSSID = "";              // credentials we are trying, saved once they work
+String pendingPassword = "";
+boolean wlanConnectPending = false;
+boolean wlanConnectFailed = false;
+unsigned long wlanConnectStartTime = 0;
+
+// Power management: the radio sleeps between DTIM beacons, and with light
+// sleep the CPU does too while the loop idles. The time sync runs on its
+// schedule as before, incoming connections wake us at the next beacon.
+#define POWER_MODE_MODEM_SLEEP 0      // the SDK default, the radio sleeps between beacons
+#define POWER_MODE_LIGHT_SLEEP 1      // the CPU sleeps too while we wait for work
+#define POWER_MODE_ALWAYS_ON   2      // radio always listening, lowest latency
+#define POWER_MODE_MAX         2
+#define POWER_LISTEN_INTERVAL  3      // wake for every 3rd DTIM beacon
+#define POWER_IDLE_MS          50     // how long the loop idles each time round in light sleep
+#define POWER_BUSY_MS          2000   // no idling this long after a page, the browser fetches the rest straight after
+#define POWER_REQUEST_MICROS   1000   // handleClient() took longer than this, so it served a request
+#define EEPROM_POWER_MODE      352    // after the time server URL
+byte powerMode = POWER_MODE_MODEM_SLEEP;
+unsigned long long awakeMicros = 0;   // time spent running the loop, not idling
+unsigned long lastRequestMillis = 0;  // when handleClient() last served a request
+
+// Config snapshot: the clock options and alarms plus our own EEPROM settings
+// in one binary file, for setting clocks up in bulk. The option block carries
+// the I2C protocol number, a CRC-16 over everything before it comes last.
+#define SNAP_MAGIC_0           'N'
+#define SNAP_MAGIC_1           'X'
+#define SNAP_VERSION           1
+#define SNAP_OPTIONS_OFFSET    3      // after the magic and the snapshot version
+#define SNAP_ALARMS_OFFSET     (SNAP_OPTIONS_OFFSET + I2C_DATA_SIZE)
+#define SNAP_ESP_OFFSET        (SNAP_ALARMS_OFFSET + I2C_ALARM_COUNT * I2C_ALARM_SIZE)
+#define SNAP_ESP_SIZE          (EEPROM_POWER_MODE + 1)   // our EEPROM settings, as stored
+#define SNAP_CRC_OFFSET        (SNAP_ESP_OFFSET + SNAP_ESP_SIZE)
+#define SNAP_SIZE              (SNAP_CRC_OFFSET + 2)
+byte snapshot[SNAP_SIZE];
+unsigned long snapshotLength = 0;     // bytes uploaded, can be more than fit
+
 ADC_MODE(ADC_VCC);
 
-// Clock config
+// Clock config, and the option block it came in
+byte clockOptionBlock[I2C_DATA_SIZE];
 byte configHourMode;
 byte configBlankLead;
 byte configScrollback;
@@ -76,8 +179,29 @@ byte configUseFade;
 byte configUseLDR;
 byte configBlankMode;
 byte configSlotsMode;
+byte configRollMode;
 unsigned int configMinDim;
 
+// Alarms as read from the clock: hour, minute, day mask, action for each
+byte configAlarms[I2C_ALARM_COUNT][I2C_ALARM_SIZE];
+const char* alarmDayNames[7] = {"Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"};
+
+// Countdown preset we last sent to the clock, to fill in the form. The
+// clock starts up with 5 minutes.
+byte countdownMins = 5;
+byte countdownSecs = 0;
+
+// Cathode rejuvenation progress as read from the clock
+byte rejuvBlock[I2C_REJUV_SIZE];
+const char* rejuvStateNames[5] = {"Idle", "Waiting for blanking", "Burning", "Paused", "Done"};
+
+// Last self test result as read from the clock
+byte selfTestBlock[I2C_SELF_TEST_SIZE];
+
+// How long the clock took to get through each stage of its boot
+byte bootTimesBlock[I2C_BOOT_SIZE];
+const char* bootStageNames[I2C_BOOT_STAGE_COUNT] = {"HV on", "Time read", "Setup done", "First frame", "HV ready"};
+
 ESP8266WebServer server(80);
 
 // ----------------------------------------------------------------------------------------------------
@@ -98,6 +222,7 @@ void setup()
   String esid = getSSIDFromEEPROM();
   String epass = getPasswordFromEEPROM();
   timeServerURL = getTimeServerURLFromEEPROM();
+  powerMode = getPowerModeFromEEPROM();
 
   // Try to connect, if we have valid credentials
   boolean wlanConnected = false;
@@ -114,16 +239,10 @@ void setup()
   if (wlanConnected) {
     debugMsg("WiFi connected, stop softAP");
     WiFi.mode(WIFI_STA);
+    applyPowerMode();
   } else {
     debugMsg("WiFi not connected, start softAP");
-    WiFi.mode(WIFI_AP_STA);
-    
-    // You can add the password parameter if you want the AP to be password protected
-    if (strlen(ap_password) > 0) {
-      WiFi.softAP(ap_ssid, ap_password);
-    } else {
-      WiFi.softAP(ap_ssid);
-    }
+    startSoftAP();
   }
 
   IPAddress apIP = WiFi.softAPIP();
@@ -142,10 +261,30 @@ void setup()
   server.on("/reset",       resetPageHandler);
   server.on("/updatetime",  updateTimePageHandler);
   server.on("/clockconfig", clockConfigPageHandler);
+  server.on("/alarms",      alarmsPageHandler);
+  server.on("/timers",      timersPageHandler);
+  server.on("/rejuvenate",  rejuvenatePageHandler);
+  server.on("/selftest",    selfTestPageHandler);
+  server.on("/events",      eventsHandler);
+  server.on("/dashboard",   dashboardPageHandler);
+  server.on("/power",       powerPageHandler);
+  server.on("/config",      configPageHandler);
+  server.on("/config.bin",  HTTP_GET, configDownloadHandler);
+  server.on("/config.bin",  HTTP_POST, configUploadDoneHandler, configUploadHandler);
   server.on("/local.css",   localCSSHandler);
   server.onNotFound(handleNotFound);
 
   scanI2CBus();
+  negotiateI2CSpeed(true);
+
+  // Give the clock the battery backed time before we have anything better
+  if (clockUsesRTCProxy) {
+    Wire.beginTransmission(RTC_I2C_ADDRESS);
+    useRTC = (Wire.endTransmission() == 0);
+    if (useRTC) {
+      sendRTCTimeToI2C();
+    }
+  }
   
   server.begin();
   debugMsg("HTTP server started");
@@ -156,7 +295,12 @@ void setup()
 // ----------------------------------------------------------------------------------------------------
 void loop()
 {
+  unsigned long loopStartMicros = micros();
+
   server.handleClient();
+  if ((micros() - loopStartMicros) > POWER_REQUEST_MICROS) {
+    lastRequestMillis = millis();
+  }
 
   if (WiFi.status() == WL_CONNECTED) {
     if (lastMillis > millis()) {
@@ -166,15 +310,24 @@ void loop()
     
     // See if it is time to update the Clock
     if (((millis() - lastI2CUpdateTime) > 60000) || 
-         (lastI2CUpdateTime==0)
+         (lastI2CUpdateTime==0) ||
+         timeSyncRequested
        ) {
+      timeSyncRequested = false;
 
       // Try to recover the current time
       String timeStr = getTimeFromTimeZoneServer();
+      lastTimeString = timeStr;
 
       // Send the time to the I2C client, but only if there was no error
       if (!timeStr.startsWith("ERROR:")) {
         sendTimeToI2C(timeStr);
+        timeServerOK = true;
+
+        // The clock doesn't talk to the RTC itself, so keep it up to date for it
+        if (clockUsesRTCProxy && useRTC) {
+          setRTCFromTimeString(timeStr);
+        }
         
         // all OK, flash 10 millisecond per second
         blinkOnTime = 5;
@@ -182,6 +335,7 @@ void loop()
         debugMsg("Normal time serve mode");
       } else {
         // connected, but time server not found, flash middle speed
+        timeServerOK = false;
         blinkOnTime = 250;
         blinkTopTime = 500;
         debugMsg("Connected, but no time server found");
@@ -194,9 +348,20 @@ void loop()
     }
   } else {
     // offline, flash fast
+    timeServerOK = false;
     blinkOnTime = 100;
     blinkTopTime = 200;
   }
+
+  serviceWLANConnect();
+
+  serviceI2CSpeed();
+
+  if (clockUsesRTCProxy) {
+    serviceRTCProxy();
+  }
+
+  serviceTelemetry();
   
   if (((millis() - lastMillis) > blinkTopTime) && blueLedState) {
     lastMillis = millis();
@@ -213,6 +378,15 @@ void loop()
     setBlueLED(blueLedState);
 #endif    
   }
+
+  awakeMicros += micros() - loopStartMicros;
+
+  // In light sleep, give the SDK idle time the CPU can sleep in, unless
+  // there is work on. Modem sleep doesn't need it, the radio sleeps between
+  // beacons on its own. The soft AP can't sleep.
+  if ((powerMode == POWER_MODE_LIGHT_SLEEP) && (WiFi.getMode() == WIFI_STA) && !isBusy()) {
+    delay(POWER_IDLE_MS);
+  }
 }
 
 // ----------------------------------------------------------------------------------------------------
@@ -237,7 +411,7 @@ void rootPageHandler()
     response_message += getTableRow2Col("WLAN MAC", WiFi.macAddress());
     response_message += getTableRow2Col("WLAN SSID", WiFi.SSID());
     response_message += getTableRow2Col("Time server URL", timeServerURL);
-    response_message += getTableRow2Col("Time according to server", getTimeFromTimeZoneServer());
+    response_message += getTableRow2Col("Time according to server", (lastTimeString.length() > 0) ? lastTimeString : "Not asked yet");
   }
   else
   {
@@ -257,12 +431,46 @@ void rootPageHandler()
 
   response_message += getTableRow2Col("Uptime", uptimeString);
 
+  const char* powerModeNames[POWER_MODE_MAX + 1] = {"Modem sleep", "Light sleep", "Always on"};
+  response_message += getTableRow2Col("Power mode", powerModeNames[powerMode]);
+  unsigned long awakeSecs = awakeMicros / 1000000;
+  unsigned long awakePerMille = (millis() > 0) ? (awakeMicros / millis()) : 0;
+  response_message += getTableRow2Col("Awake time", String(awakeSecs) + " secs (" + String(awakePerMille / 10) + "." + String(awakePerMille % 10) + "%)");
+
   String lastUpdateString = ""; lastUpdateString += (millis() - lastI2CUpdateTime);
   response_message += getTableRow2Col("Time last update", lastUpdateString);
+  response_message += getTableRow2Col("Time server latency", String(timeServerLatency) + " mS (average " + String(timeServerLatencyAve) + " mS, jitter " + String(timeServerJitter) + " mS)");
+  response_message += getTableRow2Col("Time server connections", String(timeServerConnects) + " for " + String(timeServerRequests) + " requests");
+
+  if (i2cFastMode) {
+    response_message += getTableRow2Col("I2C bus speed", "400kHz (fast mode)");
+  } else {
+    response_message += getTableRow2Col("I2C bus speed", "100kHz (standard mode)");
+  }
+
+  if (!clockUsesRTCProxy) {
+    response_message += getTableRow2Col("RTC", "handled by clock");
+  } else if (useRTC) {
+    response_message += getTableRow2Col("RTC", "handled for clock");
+  } else {
+    response_message += getTableRow2Col("RTC", "not found");
+  }
 
   response_message += getTableRow2Col("Version", SOFTWARE_VERSION);
   response_message += getTableRow2Col("Serial Number", serialNumber);
 
+  if (getClockBootTimesFromI2C()) {
+    for (byte stage = 0 ; stage < I2C_BOOT_STAGE_COUNT ; stage++) {
+      byte idx = I2C_BOOT_FIRST_STAGE + stage * 2;
+      unsigned int stageMillis = bootTimesBlock[idx] * 256 + bootTimesBlock[idx + 1];
+      if (stageMillis == 0) {
+        response_message += getTableRow2Col("Clock boot: " + String(bootStageNames[stage]), "not reached");
+      } else {
+        response_message += getTableRow2Col("Clock boot: " + String(bootStageNames[stage]) + " (ms)", stageMillis);
+      }
+    }
+  }
+
   // Scan I2C bus
   for (int idx = 0 ; idx < 128 ; idx++)
   {
@@ -316,38 +524,15 @@ void rootPageHandler()
 */
 void wlanPageHandler()
 {
-  // Check if there are any GET parameters, if there are, we are configuring
+  // Check if there are any GET parameters, if there are, we are configuring. The loop
+  // finishes the connection, we just show how it is going.
   if (server.hasArg("ssid"))
   {
-    if (server.hasArg("password"))
-    {
-      debugMsg("Connect WiFi");
-      debugMsg("SSID:");
-      debugMsg(server.arg("ssid"));
-      debugMsg("PASSWORD:");
-      debugMsg(server.arg("password"));
-      WiFi.begin(server.arg("ssid").c_str(), server.arg("password").c_str());
-    }
-    else
-    {
-      WiFi.begin(server.arg("ssid").c_str());
-      debugMsg("Connect WiFi");
-      debugMsg("SSID:");
-      debugMsg(server.arg("ssid"));
-    }
-
-    while (WiFi.status() != WL_CONNECTED)
-    {
-      delay(500);
-      debugMsgContinue(".");
-    }
-
-    storeCredentialsInEEPROM(server.arg("ssid"), server.arg("password"));
+    startWLANConnect(server.arg("ssid"), server.hasArg("password") ? server.arg("password") : "");
+  }
 
-    debugMsg("");
-    debugMsg("WiFi connected");
-    debugMsg("IP address: " + formatIPAsString(WiFi.localIP()));
-    debugMsg("SoftAP IP address: " + formatIPAsString(WiFi.softAPIP()));
+  if (server.hasArg("rescan")) {
+    WiFi.scanDelete();
   }
 
   String esid = getSSIDFromEEPROM();
@@ -355,11 +540,35 @@ void wlanPageHandler()
   String response_message = getHTMLHead();
   response_message += getNavBar();
 
+  if (wlanConnectPending) {
+    response_message += "<div class=\"container\" role=\"main\"><div class=\"alert alert-info fade in\">Connecting to " + pendingSSID + "...</div></div>";
+    response_message += getRefresh("/wlan_config", 2);
+  } else if (wlanConnectFailed) {
+    response_message += "<div class=\"container\" role=\"main\"><div class=\"alert alert-danger fade in\"><strong>Error!</strong> Could not connect to " + pendingSSID + ".</div></div>";
+  }
+
   // form header
   response_message += getFormHead("Set Configuration");
 
-  // Get number of visible access points
-  int ap_count = WiFi.scanNetworks();
+  // Get number of visible access points. The scan runs in the background, the results
+  // are kept until someone asks for a rescan.
+  int ap_count = WiFi.scanComplete();
+  if (ap_count == WIFI_SCAN_FAILED) {
+    WiFi.scanNetworks(true);
+    ap_count = WIFI_SCAN_RUNNING;
+  }
+
+  if (ap_count == WIFI_SCAN_RUNNING) {
+    response_message += "<p>Looking for networks...</p>";
+    response_message += getFormFoot();
+    if (!wlanConnectPending) {
+      response_message += getRefresh("/wlan_config", 2);
+    }
+    response_message += getHTMLFoot();
+
+    server.send(200, "text/html", response_message);
+    return;
+  }
 
   // Day blanking
   response_message += getDropDownHeader("WiFi:", "ssid", true);
@@ -399,6 +608,8 @@ void wlanPageHandler()
     response_message += getFormFoot();
   }
 
+  response_message += "<div class=\"container\"><a href=\"/wlan_config?rescan=1\">Look for networks again</a></div>";
+
   response_message += getHTMLFoot();
 
   server.send(200, "text/html", response_message);
@@ -418,6 +629,9 @@ void timeServerPageHandler()
     if (strlen(server.arg("timeserverurl").c_str()) > 4) {
       timeServerURL = server.arg("timeserverurl").c_str();
       storeTimeServerURLInEEPROM(timeServerURL);
+
+      // The open connection is to the old server
+      timeServerWiFiClient.stop();
     }
   }
 
@@ -445,31 +659,121 @@ void timeServerPageHandler()
 // ===================================================================================================================
 
 /**
-   Get the local time from the time server, and send it via I2C right now
+   Page for the power management mode
 */
-void updateTimePageHandler()
+void powerPageHandler()
 {
-  String timeString = getTimeFromTimeZoneServer();
+  if (server.hasArg("powermode")) {
+    byte newPowerMode = atoi(server.arg("powermode").c_str());
+    if ((newPowerMode <= POWER_MODE_MAX) && (newPowerMode != powerMode)) {
+      powerMode = newPowerMode;
+      storePowerModeInEEPROM(powerMode);
+      applyPowerMode();
+    }
+  }
+
+  String response_message = getHTMLHead();
+  response_message += getNavBar();
+
+  response_message += getFormHead("Power management");
+  response_message += getDropDownHeader("Power mode:", "powermode", true);
+  response_message += getDropDownOption(String(POWER_MODE_MODEM_SLEEP), "Modem sleep between beacons", (powerMode == POWER_MODE_MODEM_SLEEP));
+  response_message += getDropDownOption(String(POWER_MODE_LIGHT_SLEEP), "Light sleep, lowest power", (powerMode == POWER_MODE_LIGHT_SLEEP));
+  response_message += getDropDownOption(String(POWER_MODE_ALWAYS_ON), "Always on, fastest pages", (powerMode == POWER_MODE_ALWAYS_ON));
+  response_message += getDropDownFooter();
+  response_message += getSubmitButton("Set");
+  response_message += getFormFoot();
+  response_message += getHTMLFoot();
+
+  server.send(200, "text/html", response_message);
+}
+
+// ===================================================================================================================
+// ===================================================================================================================
 
+/**
+   Download or upload the config snapshot. Scripts can use /config.bin directly:
+     curl -o config.bin http://<clock>/config.bin
+     curl -F file=@config.bin http://<clock>/config.bin
+*/
+void configPageHandler()
+{
   String response_message = getHTMLHead();
   response_message += getNavBar();
 
+  response_message += "<div class=\"container\" role=\"main\"><h3 class=\"sub-header\">Config snapshot</h3>";
+  response_message += "<p>The clock settings and alarms, with the WLAN, time server and power settings of this module. ";
+  response_message += "The file holds the WLAN password.</p>";
+  response_message += "<p><a class=\"btn btn-primary\" href=\"/config.bin\">Download</a></p>";
+  response_message += "<form class=\"form-horizontal\" method=\"post\" action=\"/config.bin\" enctype=\"multipart/form-data\">";
+  response_message += "<div class=\"form-group\"><label class=\"control-label col-xs-3\">Snapshot file:</label>";
+  response_message += "<div class=\"col-xs-8\"><input type=\"file\" name=\"file\"></div></div>";
+  response_message += getSubmitButton("Upload and apply");
+  response_message += getFormFoot();
+  response_message += getHTMLFoot();
 
-  if (timeString.substring(1,6) == "ERROR:") {
-    response_message += "<div class=\"container\" role=\"main\"><h3 class=\"sub-header\">Send time to I2C right now</h3>";
-    response_message += "<div class=\"alert alert-danger fade in\"><strong>Error!</strong> Could not recover the time from time server. ";
-    response_message += timeString;
-    response_message += "</div></div>";
-  } else {
-    boolean result = sendTimeToI2C(timeString);
+  server.send(200, "text/html", response_message);
+}
 
-    response_message += "<div class=\"container\" role=\"main\"><h3 class=\"sub-header\">Send time to I2C right now</h3>";
-    if (result) {
-      response_message += "<div class=\"alert alert-success fade in\"><strong>Success!</strong> Update sent.</div></div>";
-    } else {
-      response_message += "<div class=\"alert alert-danger fade in\"><strong>Error!</strong> Update was not sent.</div></div>";
+void configDownloadHandler()
+{
+  if (!buildConfigSnapshot()) {
+    server.send(503, "text/plain", "The clock did not answer\n");
+    return;
+  }
+
+  server.sendHeader("Content-Disposition", "attachment; filename=\"config.bin\"");
+  server.setContentLength(SNAP_SIZE);
+  server.send(200, "application/octet-stream", "");
+  server.client().write(snapshot, SNAP_SIZE);
+}
+
+/**
+   Collect the uploaded snapshot, it arrives in pieces
+*/
+void configUploadHandler()
+{
+  HTTPUpload& upload = server.upload();
+  if (upload.status == UPLOAD_FILE_START) {
+    snapshotLength = 0;
+  } else if (upload.status == UPLOAD_FILE_WRITE) {
+    for (size_t idx = 0 ; idx < upload.currentSize ; idx++) {
+      if (snapshotLength < SNAP_SIZE) {
+        snapshot[snapshotLength] = upload.buf[idx];
+      }
+      snapshotLength++;
     }
   }
+}
+
+void configUploadDoneHandler()
+{
+  String error = applyConfigSnapshot();
+  snapshotLength = 0;
+
+  if (error.length() == 0) {
+    server.send(200, "text/plain", "Config applied, WLAN changes take effect after a restart\n");
+  } else {
+    server.send(400, "text/plain", error + "\n");
+  }
+}
+
+// ===================================================================================================================
+// ===================================================================================================================
+
+/**
+   Get the local time from the time server, and send it via I2C right now
+*/
+void updateTimePageHandler()
+{
+  timeSyncRequested = true;
+
+  String response_message = getHTMLHead();
+  response_message += getNavBar();
+
+  response_message += "<div class=\"container\" role=\"main\"><h3 class=\"sub-header\">Send time to I2C right now</h3>";
+  response_message += "<div class=\"alert alert-info fade in\">Update requested, the result is on the summary page.</div></div>";
+  response_message += getRefresh("/", 3);
 
   response_message += getHTMLFoot();
 
@@ -504,6 +808,8 @@ void resetPageHandler() {
 */
 void clockConfigPageHandler()
 {
+  optionWriteFailures = 0;
+
   if (server.hasArg("12h24hMode"))
   {
     debugMsg("Got 24h mode param: " + server.arg("12h24hMode"));
@@ -743,6 +1049,17 @@ void clockConfigPageHandler()
 
   // -----------------------------------------------------------------------------
 
+  if (server.hasArg("rollMode")) {
+    debugMsg("Got rollMode param: " + server.arg("rollMode"));
+    byte newRollMode = atoi(server.arg("rollMode").c_str());
+    if (newRollMode != configRollMode) {
+      setClockOptionRollMode(newRollMode);
+      debugMsg("I2C --> Set rollMode: " + newRollMode);
+    }
+  }
+
+  // -----------------------------------------------------------------------------
+
   if (server.hasArg("minDim")) {
     debugMsg("Got minDim param: " + server.arg("minDim"));
     int newMinDim = atoi(server.arg("minDim").c_str());
@@ -760,6 +1077,11 @@ void clockConfigPageHandler()
   String response_message = getHTMLHead();
   response_message += getNavBar();
 
+  if (optionWriteFailures > 0) {
+    response_message += "<div class=\"container\" role=\"main\"><div class=\"alert alert-danger fade in\"><strong>Error!</strong> ";
+    response_message += String(optionWriteFailures) + " setting(s) were not confirmed by the clock.</div></div>";
+  }
+
   // form header
   response_message += getFormHead("Set Configuration");
 
@@ -899,6 +1221,13 @@ void clockConfigPageHandler()
   response_message += getDropDownOption("1", "Scroll In, Scramble Out", (configSlotsMode == 1));
   response_message += getDropDownFooter();
 
+  // Roll Mode
+  response_message += getDropDownHeader("Digit Roll:", "rollMode", true);
+  response_message += getDropDownOption("0", "Off", (configRollMode == 0));
+  response_message += getDropDownOption("1", "Roll Up", (configRollMode == 1));
+  response_message += getDropDownOption("2", "Roll Down", (configRollMode == 2));
+  response_message += getDropDownFooter();
+
   // Min dim
   response_message += getNumberInput("Min Dim:", "minDim", 100, 500, configMinDim, false);
   
@@ -916,119 +1245,605 @@ void clockConfigPageHandler()
 // ===================================================================================================================
 // ===================================================================================================================
 
-/* Called if requested page is not found */
-void handleNotFound()
+/**
+   Page for the clock alarms.
+*/
+void alarmsPageHandler()
 {
-  String message = "File Not Found\n\n";
-  message += "URI: ";
-  message += server.uri();
-  message += "\nMethod: ";
-  message += (server.method() == HTTP_GET) ? "GET" : "POST";
-  message += "\nArguments: ";
-  message += server.args();
-  message += "\n";
+  optionWriteFailures = 0;
 
-  for (uint8_t i = 0; i < server.args(); i++)
-  {
-    message += " " + server.argName(i) + ": " + server.arg(i) + "\n";
+  getClockAlarmsFromI2C();
+
+  for (byte alarm = 0 ; alarm < I2C_ALARM_COUNT ; alarm++) {
+    String prefix = "alarm" + String(alarm);
+
+    // Checkboxes are only sent when they are ticked, so use the hour to see if the form was sent
+    if (server.hasArg(prefix + "hour")) {
+      byte newHour = atoi(server.arg(prefix + "hour").c_str());
+      byte newMinute = atoi(server.arg(prefix + "min").c_str());
+
+      byte newDays = 0;
+      for (byte day = 0 ; day < 7 ; day++) {
+        if (server.hasArg(prefix + "day" + String(day))) {
+          newDays |= (1 << day);
+        }
+      }
+
+      byte newAction = 0;
+      if (server.hasArg(prefix + "unblank")) newAction |= I2C_ALARM_ACTION_UNBLANK;
+      if (server.hasArg(prefix + "flash")) newAction |= I2C_ALARM_ACTION_FLASH;
+      if (server.hasArg(prefix + "effect")) newAction |= I2C_ALARM_ACTION_EFFECT;
+
+      if ((newHour != configAlarms[alarm][0]) || (newMinute != configAlarms[alarm][1]) ||
+          (newDays != configAlarms[alarm][2]) || (newAction != configAlarms[alarm][3])) {
+        debugMsg("I2C --> Set alarm " + String(alarm));
+        setClockAlarm(alarm, newHour, newMinute, newDays, newAction);
+      }
+    }
   }
 
-  server.send(404, "text/plain", message);
+  // Get the alarms again, so that we show what the clock has
+  getClockAlarmsFromI2C();
+
+  String response_message = getHTMLHead();
+  response_message += getNavBar();
+
+  if (optionWriteFailures > 0) {
+    response_message += "<div class=\"container\" role=\"main\"><div class=\"alert alert-danger fade in\"><strong>Error!</strong> ";
+    response_message += String(optionWriteFailures) + " alarm(s) were not confirmed by the clock.</div></div>";
+  }
+
+  response_message += getFormHead("Set Alarms");
+
+  for (byte alarm = 0 ; alarm < I2C_ALARM_COUNT ; alarm++) {
+    String prefix = "alarm" + String(alarm);
+
+    response_message += getNumberInput("Alarm " + String(alarm + 1) + " hour:", prefix + "hour", 0, 23, configAlarms[alarm][0], false);
+    response_message += getNumberInput("Minute:", prefix + "min", 0, 59, configAlarms[alarm][1], false);
+
+    response_message += getRadioGroupHeader("Days:");
+    for (byte day = 0 ; day < 7 ; day++) {
+      response_message += getInlineCheckBox(prefix + "day" + String(day), alarmDayNames[day], (configAlarms[alarm][2] & (1 << day)) != 0);
+    }
+    response_message += getRadioGroupFooter();
+
+    response_message += getRadioGroupHeader("Action:");
+    response_message += getInlineCheckBox(prefix + "unblank", "Display on", (configAlarms[alarm][3] & I2C_ALARM_ACTION_UNBLANK) != 0);
+    response_message += getInlineCheckBox(prefix + "flash", "Flash LEDs", (configAlarms[alarm][3] & I2C_ALARM_ACTION_FLASH) != 0);
+    response_message += getInlineCheckBox(prefix + "effect", "Slots effect", (configAlarms[alarm][3] & I2C_ALARM_ACTION_EFFECT) != 0);
+    response_message += getRadioGroupFooter();
+  }
+
+  response_message += getSubmitButton("Set");
+  response_message += getFormFoot();
+  response_message += getHTMLFoot();
+
+  server.send(200, "text/html", response_message);
 }
 
 // ===================================================================================================================
 // ===================================================================================================================
 
-/* Called if we need to have a local CSS */
-void localCSSHandler()
+/**
+   Page for the stopwatch and countdown timer.
+*/
+void timersPageHandler()
 {
-  String message = ".navbar,.table{margin-bottom:20px}.nav>li,.nav>li>a,article,aside,details,figcaption,figure,footer,header,hgroup,main,menu,nav,section,summary{display:block}.btn,.form-control,.navbar-toggle{background-image:none}.table,label{max-width:100%}.sub-header{padding-bottom:10px;border-bottom:1px solid #eee}.h3,h3{font-size:24px}.table{width:100%}table{background-color:transparent;border-spacing:0;border-collapse:collapse}.table-striped>tbody>tr:nth-of-type(2n+1){background-color:#f9f9f9}.table>caption+thead>tr:first-child>td,.table>caption+thead>tr:first-child>th,.table>colgroup+thead>tr:first-child>td,.table>colgroup+thead>tr:first-child>th,.table>thead:first-child>tr:first-child>td,.table>thead:first-child>tr:first-child>th{border-top:0}.table>thead>tr>th{border-bottom:2px solid #ddd}.table>tbody>tr>td,.table>tbody>tr>th,.table>tfoot>tr>td,.table>tfoot>tr>th,.table>thead>tr>td,.table>thead>tr>th{padding:8px;line-height:1.42857143;vertical-align:top;border-top:1px solid #ddd}th{text-align:left}td,th{padding:0}.navbar>.container .navbar-brand,.navbar>.container-fluid .navbar-brand{margin-left:-15px}.container,.container-fluid{padding-right:15px;padding-left:15px;margin-right:auto;margin-left:auto}.navbar-inverse .navbar-brand{color:#9d9d9d}.navbar-brand{float:left;height:50px;padding:15px;font-size:18px;line-height:20px}a{color:#337ab7;text-decoration:none;background-color:transparent}.navbar-fixed-top{border:0;top:0;border-width:0 0 1px}.navbar-inverse{background-color:#222;border-color:#080808}.navbar-fixed-bottom,.navbar-fixed-top{border-radius:0;position:fixed;right:0;left:0;z-index:1030}.nav>li,.nav>li>a,.navbar,.navbar-toggle{position:relative}.navbar{border-radius:4px;min-height:50px;border:1px solid transparent}.container{width:750px}.navbar-right{float:right!important;margin-right:-15px}.navbar-nav{float:left;margin:7.5px -15px}.nav{padding-left:0;margin-bottom:0;list-style:none}.navbar-nav>li{float:left}.navbar-inverse .navbar-nav>li>a{color:#9d9d9d}.navbar-nav>li>a{padding-top:10px;padding-bottom:10px;line-height:20px}.nav>li>a{padding:10px 15px}.navbar-inverse .navbar-toggle{border-color:#333}.navbar-toggle{display:none;float:right;padding:9px 10px;margin-top:8px;margin-right:15px;margin-bottom:8px;background-color:transparent;border:1px solid transparent;border-radius:4px}button,select{text-transform:none}button{overflow:visible}button,html input[type=button],input[type=reset],input[type=submit]{-webkit-appearance:button;cursor:pointer}.btn-primary{color:#fff;background-color:#337ab7;border-color:#2e6da4}.btn{display:inline-block;padding:6px 12px;margin-bottom:0;font-size:14px;font-weight:400;line-height:1.42857143;text-align:center;white-space:nowrap;vertical-align:middle;-ms-touch-action:manipulation;touch-action:manipulation;cursor:pointer;-webkit-user-select:none;-moz-user-select:none;-ms-user-select:none;user-select:none;border:1px solid transparent;border-radius:4px}button,input,select,textarea{font-family:inherit;font-size:inherit;line-height:inherit}input{line-height:normal}button,input,optgroup,select,textarea{margin:0;font:inherit;color:inherit}.form-control,body{font-size:14px;line-height:1.42857143}.form-horizontal .form-group{margin-right:-15px;margin-left:-15px}.form-group{margin-bottom:15px}.form-horizontal .control-label{padding-top:7px;margin-bottom:0;text-align:right}.form-control{display:block;width:100%;height:34px;padding:6px 12px;color:#555;background-color:#fff;border:1px solid #ccc;border-radius:4px;-webkit-box-shadow:inset 0 1px 1px rgba(0,0,0,.075);box-shadow:inset 0 1px 1px rgba(0,0,0,.075);-webkit-transition:border-color ease-in-out .15s,-webkit-box-shadow ease-in-out .15s;-o-transition:border-color ease-in-out .15s,box-shadow ease-in-out .15s;transition:border-color ease-in-out .15s,box-shadow ease-in-out .15s}.col-xs-8{width:66.66666667%}.col-xs-3{width:25%}.col-xs-1,.col-xs-10,.col-xs-11,.col-xs-12,.col-xs-2,.col-xs-3,.col-xs-4,.col-xs-5,.col-xs-6,.col-xs-7,.col-xs-8,.col-xs-9{float:left}.col-lg-1,.col-lg-10,.col-lg-11,.col-lg-12,.col-lg-2,.col-lg-3,.col-lg-4,.col-lg-5,.col-lg-6,.col-lg-7,.col-lg-8,.col-lg-9,.col-md-1,.col-md-10,.col-md-11,.col-md-12,.col-md-2,.col-md-3,.col-md-4,.col-md-5,.col-md-6,.col-md-7,.col-md-8,.col-md-9,.col-sm-1,.col-sm-10,.col-sm-11,.col-sm-12,.col-sm-2,.col-sm-3,.col-sm-4,.col-sm-5,.col-sm-6,.col-sm-7,.col-sm-8,.col-sm-9,.col-xs-1,.col-xs-10,.col-xs-11,.col-xs-12,.col-xs-2,.col-xs-3,.col-xs-4,.col-xs-5,.col-xs-6,.col-xs-7,.col-xs-8,.col-xs-9{position:relative;min-height:1px;padding-right:15px;padding-left:15px}label{display:inline-block;margin-bottom:5px;font-weight:700}*{-webkit-box-sizing:border-box;-moz-box-sizing:border-box;box-sizing:border-box}body{font-family:\"Helvetica Neue\",Helvetica,Arial,sans-serif;color:#333}html{font-size:10px;font-family:sans-serif;-webkit-text-size-adjust:100%}";
+  boolean sentOK = true;
+
+  if (server.hasArg("cdmins")) {
+    // Always send it: the clock goes back to its default preset when it
+    // restarts, so what we sent last tells us nothing about what it has
+    byte newMins = atoi(server.arg("cdmins").c_str());
+    byte newSecs = atoi(server.arg("cdsecs").c_str());
+    debugMsg("I2C --> Set countdown");
+    if (setClockCountdown(newMins, newSecs)) {
+      countdownMins = newMins;
+      countdownSecs = newSecs;
+    } else {
+      sentOK = false;
+    }
+  }
 
-  server.send(200, "text/css", message);
-}
+  if (server.hasArg("timer") && server.hasArg("command")) {
+    byte timer = atoi(server.arg("timer").c_str());
+    byte command = atoi(server.arg("command").c_str());
+    debugMsg("I2C --> Timer " + String(timer) + " command " + String(command));
+    sentOK &= sendTimerCommand(timer, command);
+  }
 
-// ----------------------------------------------------------------------------------------------------
-// ----------------------------------------- Network handling -----------------------------------------
-// ----------------------------------------------------------------------------------------------------
+  String response_message = getHTMLHead();
+  response_message += getNavBar();
 
-/**
-   Try to connect to the WiFi with the given credentials. Give up after 10 seconds or 20 retries
-   if we can't get in.
-*/
-boolean connectToWLAN(const char* ssid, const char* password) {
-  int retries = 0;
-  debugMsg("Connecting to WLAN");
-  if (password && strlen(password) > 0 ) {
-    WiFi.begin(ssid, password);
-  } else {
-    WiFi.begin(ssid);
+  if (!sentOK) {
+    response_message += "<div class=\"container\" role=\"main\"><div class=\"alert alert-danger fade in\"><strong>Error!</strong> ";
+    response_message += "The clock did not get the command.</div></div>";
   }
 
-  while (WiFi.status() != WL_CONNECTED)
-  {
-    delay(500);
-    debugMsgContinue(".");
-    retries++;
-    if (retries > 20) {
-      return false;
-    }
+  // One form for each timer and one for the preset, so the browser only
+  // sends the fields of the one we submitted: setting the preset must not
+  // start a timer too
+  const byte timers[2] = {I2C_TIMER_STOPWATCH, I2C_TIMER_COUNTDOWN};
+  const char* timerNames[2] = {"Stopwatch", "Countdown"};
+  for (byte idx = 0 ; idx < 2 ; idx++) {
+    response_message += getFormHead(timerNames[idx]);
+    response_message += "<input type=\"hidden\" name=\"timer\" value=\"" + String(timers[idx]) + "\">";
+    response_message += getRadioGroupHeader("Command:");
+    response_message += getRadioButton("command", "Start", String(I2C_TIMER_CMD_START), true);
+    response_message += getRadioButton("command", "Stop", String(I2C_TIMER_CMD_STOP), false);
+    response_message += getRadioButton("command", "Reset", String(I2C_TIMER_CMD_RESET), false);
+    response_message += getRadioGroupFooter();
+    response_message += getSubmitButton("Send");
+    response_message += getFormFoot();
   }
 
-  debugMsg("Connected");
-  return true;
+  response_message += getFormHead("Countdown preset");
+  response_message += getNumberInput("Countdown minutes:", "cdmins", 0, 99, countdownMins, false);
+  response_message += getNumberInput("Seconds:", "cdsecs", 0, 59, countdownSecs, false);
+
+  response_message += getSubmitButton("Set");
+  response_message += getFormFoot();
+  response_message += getHTMLFoot();
+
+  server.send(200, "text/html", response_message);
 }
 
+// ===================================================================================================================
+// ===================================================================================================================
+
 /**
-   Get the local time from the time zone server. Return the error description prefixed by "ERROR:" if something went wrong.
-   Uses the global variable timeServerURL.
+   Page for the cathode rejuvenation program: shows the progress and starts, pauses, resumes or cancels it.
 */
-String getTimeFromTimeZoneServer() {
-  HTTPClient http;
-  String payload;
-
-  http.begin(timeServerURL);
-  String espId = "";espId += ESP.getChipId();
-  http.addHeader("ESP",espId);
-  http.addHeader("ClientID",serialNumber);
+void rejuvenatePageHandler()
+{
+  boolean sentOK = true;
+
+  if (server.hasArg("command")) {
+    byte command = atoi(server.arg("command").c_str());
+    if (command == I2C_REJUV_CMD_START) {
+      // Checkboxes are only sent when they are ticked
+      byte tubes = 0;
+      for (byte tube = 0 ; tube < 6 ; tube++) {
+        if (server.hasArg("tube" + String(tube))) {
+          tubes |= (1 << tube);
+        }
+      }
 
-  int httpCode = http.GET();
+      unsigned int cathodes = 0;
+      for (byte cathode = 0 ; cathode < 10 ; cathode++) {
+        if (server.hasArg("cathode" + String(cathode))) {
+          cathodes |= (1 << cathode);
+        }
+      }
 
-  // file found at server
-  if (httpCode == HTTP_CODE_OK) {
-    payload = http.getString();
-  } else {
-    debugMsg("[HTTP] GET... failed, error: " + http.errorToString(httpCode));
-    if (httpCode > 0) {
-      // RFC error codes don't have a string mapping
-      payload = "ERROR: " + String(httpCode);
+      byte duty = atoi(server.arg("duty").c_str());
+      byte stepMins = atoi(server.arg("stepmins").c_str());
+      debugMsg("I2C --> Start rejuvenation");
+      sentOK = startClockRejuvenation(tubes, cathodes, duty, stepMins);
     } else {
-      // ESP error codes have a string mapping
-      payload = "ERROR: " + String(httpCode) + " ("+ http.errorToString(httpCode) + ")";
+      debugMsg("I2C --> Rejuvenation command " + String(command));
+      sentOK = sendRejuvCommand(command);
     }
-  }    
+  }
 
-  http.end();
+  boolean gotProgress = getClockRejuvFromI2C();
 
-  return payload;
-}
+  String response_message = getHTMLHead();
+  response_message += getNavBar();
 
-// ----------------------------------------------------------------------------------------------------
-// ------------------------------------------ EEPROM functions ----------------------------------------
-// ----------------------------------------------------------------------------------------------------
+  if (!sentOK) {
+    response_message += "<div class=\"container\" role=\"main\"><div class=\"alert alert-danger fade in\"><strong>Error!</strong> ";
+    response_message += "The clock did not get the command.</div></div>";
+  }
 
-String getSSIDFromEEPROM() {
-  String esid = "";
-  for (int i = 0; i < 32; i++)
-  {
-    byte readByte = EEPROM.read(i);
-    if (readByte == 0) {
-      break;
-    } else if ((readByte < 32) || (readByte == 0xFF)) {
-      continue;
+  response_message += getTableHead2Col("Rejuvenation progress", "Name", "Value");
+  if (gotProgress && (rejuvBlock[I2C_REJUV_STATE] <= I2C_REJUV_STATE_DONE)) {
+    response_message += getTableRow2Col("State", rejuvStateNames[rejuvBlock[I2C_REJUV_STATE]]);
+    response_message += getTableRow2Col("Cathodes done", String(rejuvBlock[I2C_REJUV_STEPS_DONE]) + " of " + String(rejuvBlock[I2C_REJUV_STEPS_TOTAL]));
+    if ((rejuvBlock[I2C_REJUV_STATE] != I2C_REJUV_STATE_IDLE) && (rejuvBlock[I2C_REJUV_STATE] != I2C_REJUV_STATE_DONE)) {
+      response_message += getTableRow2Col("Current tube", rejuvBlock[I2C_REJUV_TUBE]);
+      response_message += getTableRow2Col("Current cathode", rejuvBlock[I2C_REJUV_CATHODE]);
+      response_message += getTableRow2Col("Minutes on this cathode", rejuvBlock[I2C_REJUV_STEP_MINS]);
+      response_message += getTableRow2Col("Worst HV sag (V)", rejuvBlock[I2C_REJUV_SAG]);
     }
-    esid += char(readByte);
+    response_message += getTableRow2Col("Cathodes cut short by HV sag", rejuvBlock[I2C_REJUV_SAG_SKIPS]);
+  } else {
+    response_message += getTableRow2Col("State", "Clock does not support rejuvenation");
   }
-  debugMsg("Recovered SSID: " + esid);
+  response_message += getTableFoot();
+
+  response_message += getFormHead("Rejuvenation program");
+
+  response_message += getRadioGroupHeader("Tubes:");
+  for (byte tube = 0 ; tube < 6 ; tube++) {
+    response_message += getInlineCheckBox("tube" + String(tube), String(tube), false);
+  }
+  response_message += getRadioGroupFooter();
+
+  response_message += getRadioGroupHeader("Cathodes:");
+  for (byte cathode = 0 ; cathode < 10 ; cathode++) {
+    response_message += getInlineCheckBox("cathode" + String(cathode), String(cathode), false);
+  }
+  response_message += getRadioGroupFooter();
+
+  response_message += getNumberInput("Duty (%):", "duty", 10, 100, 50, false);
+  response_message += getNumberInput("Minutes per cathode:", "stepmins", 1, 240, 30, false);
+
+  response_message += getRadioGroupHeader("Command:");
+  response_message += getRadioButton("command", "Start", String(I2C_REJUV_CMD_START), true);
+  response_message += getRadioButton("command", "Pause", String(I2C_REJUV_CMD_PAUSE), false);
+  response_message += getRadioButton("command", "Resume", String(I2C_REJUV_CMD_RESUME), false);
+  response_message += getRadioButton("command", "Cancel", String(I2C_REJUV_CMD_CANCEL), false);
+  response_message += getRadioGroupFooter();
+
+  response_message += getSubmitButton("Send");
+  response_message += getFormFoot();
+  response_message += getHTMLFoot();
+
+  server.send(200, "text/html", response_message);
+}
+
+// ===================================================================================================================
+// ===================================================================================================================
+
+/**
+   Page for the clock self test: starts a test and shows the last result.
+*/
+void selfTestPageHandler()
+{
+  boolean started = false;
+  if (server.hasArg("run")) {
+    debugMsg("I2C --> Run self test");
+    started = runClockSelfTest();
+  }
+
+  boolean gotResult = getClockSelfTestFromI2C();
+
+  String response_message = getHTMLHead();
+  response_message += getNavBar();
+
+  if (started) {
+    response_message += "<div class=\"container\" role=\"main\"><div class=\"alert alert-info fade in\">";
+    response_message += "The self test takes a few seconds, reload the page for the result.</div></div>";
+  }
+
+  response_message += getTableHead2Col("Last self test", "Check", "Result");
+  if (!gotResult) {
+    response_message += getTableRow2Col("Self test", "Clock does not support the self test");
+  } else if ((selfTestBlock[I2C_SELF_TEST_STATUS] & I2C_SELF_TEST_RAN) == 0) {
+    response_message += getTableRow2Col("Self test", "Not run since the clock started");
+  } else {
+    byte failed = selfTestBlock[I2C_SELF_TEST_FAILED];
+    unsigned int cathodes = selfTestBlock[I2C_SELF_TEST_CATHODES_HI] * 256 + selfTestBlock[I2C_SELF_TEST_CATHODES_LO];
+    response_message += getTableRow2Col("Result code", failed);
+    response_message += getTableRow2Col("HV under load", getSelfTestResult(failed, I2C_SELF_TEST_HV));
+    response_message += getTableRow2Col("Worst HV sag (V)", selfTestBlock[I2C_SELF_TEST_SAG]);
+    if ((failed & I2C_SELF_TEST_HV) != 0) {
+      response_message += getTableRow2Col("Failed anodes (mask)", selfTestBlock[I2C_SELF_TEST_ANODES]);
+      response_message += getTableRow2Col("Failed cathodes (mask)", cathodes);
+    }
+    response_message += getTableRow2Col("LEDs", getSelfTestResult(failed, I2C_SELF_TEST_LEDS));
+    if ((failed & I2C_SELF_TEST_LEDS) != 0) {
+      response_message += getTableRow2Col("Failed LEDs (mask)", selfTestBlock[I2C_SELF_TEST_LEDS_FAILED]);
+    }
+    if ((selfTestBlock[I2C_SELF_TEST_STATUS] & I2C_SELF_TEST_RTC_SKIPPED) != 0) {
+      response_message += getTableRow2Col("RTC", "On the WiFi module");
+    } else {
+      response_message += getTableRow2Col("RTC", getSelfTestResult(failed, I2C_SELF_TEST_RTC));
+    }
+    response_message += getTableRow2Col("LDR", getSelfTestResult(failed, I2C_SELF_TEST_LDR));
+    response_message += getTableRow2Col("LDR reading", selfTestBlock[I2C_SELF_TEST_LDR_HI] * 256 + selfTestBlock[I2C_SELF_TEST_LDR_LO]);
+    response_message += getTableRow2Col("EEPROM", getSelfTestResult(failed, I2C_SELF_TEST_EEPROM));
+  }
+  response_message += getTableFoot();
+
+  response_message += getFormHead("Run self test");
+  response_message += "<input type=\"hidden\" name=\"run\" value=\"1\">";
+  response_message += getSubmitButton("Run");
+  response_message += getFormFoot();
+  response_message += getHTMLFoot();
+
+  server.send(200, "text/html", response_message);
+}
+
+String getSelfTestResult(byte failed, byte check) {
+  if ((failed & check) != 0) {
+    return "FAIL";
+  } else {
+    return "pass";
+  }
+}
+
+// ===================================================================================================================
+// ===================================================================================================================
+
+/**
+   Server-Sent Events stream of the clock telemetry. We keep the connection and serviceTelemetry()
+   writes to it, so every viewer shares the same poll of the clock.
+*/
+void eventsHandler()
+{
+  byte slot = 0;
+  while ((slot < SSE_MAX_CLIENTS) && sseClients[slot].connected()) {
+    slot++;
+  }
+
+  if (slot == SSE_MAX_CLIENTS) {
+    server.send(503, "text/plain", "Too many live viewers");
+    return;
+  }
+
+  debugMsg("New telemetry viewer in slot " + String(slot));
+  sseClients[slot] = server.client();
+  sseClients[slot].setNoDelay(true);
+  sseClients[slot].print("HTTP/1.1 200 OK\r\nContent-Type: text/event-stream\r\nCache-Control: no-cache\r\nConnection: keep-alive\r\n\r\nretry: 5000\n\n");
+
+  // Give the new viewer everything straight away
+  telemetrySendAll = true;
+  lastTelemetryPollTime = 0;
+}
+
+/**
+   Live view of the clock, filled in from /events.
+*/
+void dashboardPageHandler()
+{
+  if (server.hasArg("interval")) {
+    telemetryIntervalSecs = constrain(atoi(server.arg("interval").c_str()), TELEMETRY_INTERVAL_MIN_S, TELEMETRY_INTERVAL_MAX_S);
+  }
+
+  String response_message = getHTMLHead();
+  response_message += getNavBar();
+
+  response_message += getTableHead2Col("Live clock status", "Name", "Value");
+  response_message += getTableRow2Col("HV (V)", "<span id=\"hv\">-</span>");
+  response_message += getTableRow2Col("Brightness (%)", "<span id=\"brightness\">-</span>");
+  response_message += getTableRow2Col("Impressions per second", "<span id=\"impressions\">-</span>");
+  response_message += getTableRow2Col("Clock flags (1 = blanked, 2 = RTC, 4 = WiFi time)", "<span id=\"flags\">-</span>");
+  response_message += getTableRow2Col("Time server OK", "<span id=\"timeOK\">-</span>");
+  response_message += getTableRow2Col("Seconds since time sent", "<span id=\"syncAge\">-</span>");
+  response_message += getTableRow2Col("I2C errors", "<span id=\"i2cErrors\">-</span>");
+  response_message += getTableFoot();
+
+  response_message += "<script>var es=new EventSource('/events');es.addEventListener('telemetry',function(e){";
+  response_message += "var d=JSON.parse(e.data);for(var k in d){var el=document.getElementById(k);if(el)el.textContent=d[k];}});</script>";
+
+  response_message += getFormHead("Update rate");
+  response_message += getNumberInput("Seconds between updates:", "interval", TELEMETRY_INTERVAL_MIN_S, TELEMETRY_INTERVAL_MAX_S, telemetryIntervalSecs, false);
+  response_message += getSubmitButton("Set");
+  response_message += getFormFoot();
+  response_message += getHTMLFoot();
+
+  server.send(200, "text/html", response_message);
+}
+
+// ===================================================================================================================
+// ===================================================================================================================
+
+/* Called if requested page is not found */
+void handleNotFound()
+{
+  String message = "File Not Found\n\n";
+  message += "URI: ";
+  message += server.uri();
+  message += "\nMethod: ";
+  message += (server.method() == HTTP_GET) ? "GET" : "POST";
+  message += "\nArguments: ";
+  message += server.args();
+  message += "\n";
+
+  for (uint8_t i = 0; i < server.args(); i++)
+  {
+    message += " " + server.argName(i) + ": " + server.arg(i) + "\n";
+  }
+
+  server.send(404, "text/plain", message);
+}
+
+// ===================================================================================================================
+// ===================================================================================================================
+
+/* Called if we need to have a local CSS */
+void localCSSHandler()
+{
+  String message = ".navbar,.table{margin-bottom:20px}.nav>li,.nav>li>a,article,aside,details,figcaption,figure,footer,header,hgroup,main,menu,nav,section,summary{display:block}.btn,.form-control,.navbar-toggle{background-image:none}.table,label{max-width:100%}.sub-header{padding-bottom:10px;border-bottom:1px solid #eee}.h3,h3{font-size:24px}.table{width:100%}table{background-color:transparent;border-spacing:0;border-collapse:collapse}.table-striped>tbody>tr:nth-of-type(2n+1){background-color:#f9f9f9}.table>caption+thead>tr:first-child>td,.table>caption+thead>tr:first-child>th,.table>colgroup+thead>tr:first-child>td,.table>colgroup+thead>tr:first-child>th,.table>thead:first-child>tr:first-child>td,.table>thead:first-child>tr:first-child>th{border-top:0}.table>thead>tr>th{border-bottom:2px solid #ddd}.table>tbody>tr>td,.table>tbody>tr>th,.table>tfoot>tr>td,.table>tfoot>tr>th,.table>thead>tr>td,.table>thead>tr>th{padding:8px;line-height:1.42857143;vertical-align:top;border-top:1px solid #ddd}th{text-align:left}td,th{padding:0}.navbar>.container .navbar-brand,.navbar>.container-fluid .navbar-brand{margin-left:-15px}.container,.container-fluid{padding-right:15px;padding-left:15px;margin-right:auto;margin-left:auto}.navbar-inverse .navbar-brand{color:#9d9d9d}.navbar-brand{float:left;height:50px;padding:15px;font-size:18px;line-height:20px}a{color:#337ab7;text-decoration:none;background-color:transparent}.navbar-fixed-top{border:0;top:0;border-width:0 0 1px}.navbar-inverse{background-color:#222;border-color:#080808}.navbar-fixed-bottom,.navbar-fixed-top{border-radius:0;position:fixed;right:0;left:0;z-index:1030}.nav>li,.nav>li>a,.navbar,.navbar-toggle{position:relative}.navbar{border-radius:4px;min-height:50px;border:1px solid transparent}.container{width:750px}.navbar-right{float:right!important;margin-right:-15px}.navbar-nav{float:left;margin:7.5px -15px}.nav{padding-left:0;margin-bottom:0;list-style:none}.navbar-nav>li{float:left}.navbar-inverse .navbar-nav>li>a{color:#9d9d9d}.navbar-nav>li>a{padding-top:10px;padding-bottom:10px;line-height:20px}.nav>li>a{padding:10px 15px}.navbar-inverse .navbar-toggle{border-color:#333}.navbar-toggle{display:none;float:right;padding:9px 10px;margin-top:8px;margin-right:15px;margin-bottom:8px;background-color:transparent;border:1px solid transparent;border-radius:4px}button,select{text-transform:none}button{overflow:visible}button,html input[type=button],input[type=reset],input[type=submit]{-webkit-appearance:button;cursor:pointer}.btn-primary{color:#fff;background-color:#337ab7;border-color:#2e6da4}.btn{display:inline-block;padding:6px 12px;margin-bottom:0;font-size:14px;font-weight:400;line-height:1.42857143;text-align:center;white-space:nowrap;vertical-align:middle;-ms-touch-action:manipulation;touch-action:manipulation;cursor:pointer;-webkit-user-select:none;-moz-user-select:none;-ms-user-select:none;user-select:none;border:1px solid transparent;border-radius:4px}button,input,select,textarea{font-family:inherit;font-size:inherit;line-height:inherit}input{line-height:normal}button,input,optgroup,select,textarea{margin:0;font:inherit;color:inherit}.form-control,body{font-size:14px;line-height:1.42857143}.form-horizontal .form-group{margin-right:-15px;margin-left:-15px}.form-group{margin-bottom:15px}.form-horizontal .control-label{padding-top:7px;margin-bottom:0;text-align:right}.form-control{display:block;width:100%;height:34px;padding:6px 12px;color:#555;background-color:#fff;border:1px solid #ccc;border-radius:4px;-webkit-box-shadow:inset 0 1px 1px rgba(0,0,0,.075);box-shadow:inset 0 1px 1px rgba(0,0,0,.075);-webkit-transition:border-color ease-in-out .15s,-webkit-box-shadow ease-in-out .15s;-o-transition:border-color ease-in-out .15s,box-shadow ease-in-out .15s;transition:border-color ease-in-out .15s,box-shadow ease-in-out .15s}.col-xs-8{width:66.66666667%}.col-xs-3{width:25%}.col-xs-1,.col-xs-10,.col-xs-11,.col-xs-12,.col-xs-2,.col-xs-3,.col-xs-4,.col-xs-5,.col-xs-6,.col-xs-7,.col-xs-8,.col-xs-9{float:left}.col-lg-1,.col-lg-10,.col-lg-11,.col-lg-12,.col-lg-2,.col-lg-3,.col-lg-4,.col-lg-5,.col-lg-6,.col-lg-7,.col-lg-8,.col-lg-9,.col-md-1,.col-md-10,.col-md-11,.col-md-12,.col-md-2,.col-md-3,.col-md-4,.col-md-5,.col-md-6,.col-md-7,.col-md-8,.col-md-9,.col-sm-1,.col-sm-10,.col-sm-11,.col-sm-12,.col-sm-2,.col-sm-3,.col-sm-4,.col-sm-5,.col-sm-6,.col-sm-7,.col-sm-8,.col-sm-9,.col-xs-1,.col-xs-10,.col-xs-11,.col-xs-12,.col-xs-2,.col-xs-3,.col-xs-4,.col-xs-5,.col-xs-6,.col-xs-7,.col-xs-8,.col-xs-9{position:relative;min-height:1px;padding-right:15px;padding-left:15px}label{display:inline-block;margin-bottom:5px;font-weight:700}*{-webkit-box-sizing:border-box;-moz-box-sizing:border-box;box-sizing:border-box}body{font-family:\"Helvetica Neue\",Helvetica,Arial,sans-serif;color:#333}html{font-size:10px;font-family:sans-serif;-webkit-text-size-adjust:100%}";
+
+  server.send(200, "text/css", message);
+}
+
+// ----------------------------------------------------------------------------------------------------
+// ----------------------------------------- Network handling -----------------------------------------
+// ----------------------------------------------------------------------------------------------------
+
+/**
+   Try to connect to the WiFi with the given credentials. Give up after 10 seconds or 20 retries
+   if we can't get in.
+*/
+boolean connectToWLAN(const char* ssid, const char* password) {
+  int retries = 0;
+  debugMsg("Connecting to WLAN");
+  if (password && strlen(password) > 0 ) {
+    WiFi.begin(ssid, password);
+  } else {
+    WiFi.begin(ssid);
+  }
+
+  while (WiFi.status() != WL_CONNECTED)
+  {
+    delay(500);
+    debugMsgContinue(".");
+    retries++;
+    if (retries > 20) {
+      return false;
+    }
+  }
+
+  debugMsg("Connected");
+  return true;
+}
+
+/**
+   Start connecting to a new WLAN. The loop finishes it in serviceWLANConnect(), the credentials
+   are only saved once they work.
+*/
+void startWLANConnect(String ssid, String password) {
+  debugMsg("Connect WiFi");
+  debugMsg("SSID:");
+  debugMsg(ssid);
+  if (password.length() > 0) {
+    WiFi.begin(ssid.c_str(), password.c_str());
+  } else {
+    WiFi.begin(ssid.c_str());
+  }
+
+  pendingSSID = ssid;
+  pendingPassword = password;
+  wlanConnectPending = true;
+  wlanConnectFailed = false;
+  wlanConnectStartTime = millis();
+}
+
+/**
+   See how the connection started from the WLAN page is going
+*/
+void serviceWLANConnect() {
+  if (!wlanConnectPending) {
+    return;
+  }
+
+  if (WiFi.status() == WL_CONNECTED) {
+    wlanConnectPending = false;
+    storeCredentialsInEEPROM(pendingSSID, pendingPassword);
+
+    debugMsg("WiFi connected");
+    debugMsg("IP address: " + formatIPAsString(WiFi.localIP()));
+    debugMsg("SoftAP IP address: " + formatIPAsString(WiFi.softAPIP()));
+  } else if ((millis() - wlanConnectStartTime) > WLAN_CONNECT_TIMEOUT_MS) {
+    wlanConnectPending = false;
+    wlanConnectFailed = true;
+    debugMsg("Could not connect to " + pendingSSID);
+
+    // Go back to the network that worked, and make sure the soft AP is up
+    // in case that doesn't either, or we would be left unreachable
+    String esid = getSSIDFromEEPROM();
+    if (esid.length() > 0) {
+      String epass = getPasswordFromEEPROM();
+      if (epass.length() > 0) {
+        WiFi.begin(esid.c_str(), epass.c_str());
+      } else {
+        WiFi.begin(esid.c_str());
+      }
+    }
+    if (WiFi.getMode() != WIFI_AP_STA) {
+      debugMsg("Start softAP");
+      startSoftAP();
+    }
+  }
+}
+
+/**
+   Open our own access point next to the station, so there is always a way to reach the config pages
+*/
+void startSoftAP() {
+  WiFi.mode(WIFI_AP_STA);
+
+  // You can add the password parameter if you want the AP to be password protected
+  if (strlen(ap_password) > 0) {
+    WiFi.softAP(ap_ssid, ap_password);
+  } else {
+    WiFi.softAP(ap_ssid);
+  }
+}
+
+/**
+   Set the radio sleep type for the power mode. Only used in station mode, the soft AP has to stay awake.
+*/
+void applyPowerMode() {
+  if (powerMode == POWER_MODE_LIGHT_SLEEP) {
+    WiFi.setSleepMode(WIFI_LIGHT_SLEEP, POWER_LISTEN_INTERVAL);
+  } else if (powerMode == POWER_MODE_MODEM_SLEEP) {
+    WiFi.setSleepMode(WIFI_MODEM_SLEEP, POWER_LISTEN_INTERVAL);
+  } else {
+    WiFi.setSleepMode(WIFI_NONE_SLEEP);
+  }
+  debugMsg("Power mode set to " + String(powerMode));
+}
+
+/**
+   Get the local time from the time zone server. Return the error description prefixed by "ERROR:" if something went wrong.
+   Uses the global variable timeServerURL.
+*/
+String getTimeFromTimeZoneServer() {
+  String payload;
+
+  // Only a dropped connection costs us the DNS lookup and the handshake
+  timeServerRequests++;
+  if (!timeServerWiFiClient.connected()) {
+    timeServerConnects++;
+  }
+
+  timeServerHttp.begin(timeServerWiFiClient, timeServerURL);
+  timeServerHttp.setReuse(true);
+  timeServerHttp.setTimeout(TIME_SERVER_TIMEOUT_MS);
+  String espId = "";espId += ESP.getChipId();
+  timeServerHttp.addHeader("ESP",espId);
+  timeServerHttp.addHeader("ClientID",serialNumber);
+
+  unsigned long requestStartMillis = millis();
+  int httpCode = timeServerHttp.GET();
+
+  // file found at server
+  if (httpCode == HTTP_CODE_OK) {
+    payload = timeServerHttp.getString();
+    updateTimeServerLatency(millis() - requestStartMillis);
+  } else {
+    debugMsg("[HTTP] GET... failed, error: " + timeServerHttp.errorToString(httpCode));
+    if (httpCode > 0) {
+      // RFC error codes don't have a string mapping
+      payload = "ERROR: " + String(httpCode);
+    } else {
+      // ESP error codes have a string mapping
+      payload = "ERROR: " + String(httpCode) + " ("+ timeServerHttp.errorToString(httpCode) + ")";
+    }
+  }    
+
+  // Keeps the connection open if the server agreed to it
+  timeServerHttp.end();
+
+  return payload;
+}
+
+/**
+   Keep running averages of the time server latency and how much it varies
+*/
+void updateTimeServerLatency(long latency) {
+  timeServerLatency = latency;
+  if (timeServerLatencyAve == 0) {
+    timeServerLatencyAve = latency;
+  }
+
+  long diff = latency - timeServerLatencyAve;
+  timeServerLatencyAve += diff / TIME_SERVER_SMOOTHING;
+  timeServerJitter += (abs(diff) - timeServerJitter) / TIME_SERVER_SMOOTHING;
+}
+
+// ----------------------------------------------------------------------------------------------------
+// ------------------------------------------ EEPROM functions ----------------------------------------
+// ----------------------------------------------------------------------------------------------------
+
+String getSSIDFromEEPROM() {
+  String esid = "";
+  for (int i = 0; i < 32; i++)
+  {
+    byte readByte = EEPROM.read(i);
+    if (readByte == 0) {
+      break;
+    } else if ((readByte < 32) || (readByte == 0xFF)) {
+      continue;
+    }
+    esid += char(readByte);
+  }
+  debugMsg("Recovered SSID: " + esid);
   return esid;
 }
 
@@ -1114,6 +1929,19 @@ void storeTimeServerURLInEEPROM(String timeServerURL) {
   EEPROM.commit();
 }
 
+byte getPowerModeFromEEPROM() {
+  byte storedMode = EEPROM.read(EEPROM_POWER_MODE);
+  if (storedMode > POWER_MODE_MAX) {
+    storedMode = POWER_MODE_MODEM_SLEEP;
+  }
+  return storedMode;
+}
+
+void storePowerModeInEEPROM(byte newPowerMode) {
+  EEPROM.write(EEPROM_POWER_MODE, newPowerMode);
+  EEPROM.commit();
+}
+
 void resetEEPROM() {
   debugMsg("Clearing EEPROM");
   wipeEEPROM();
@@ -1122,10 +1950,122 @@ void resetEEPROM() {
 }
 
 void wipeEEPROM() {
-  for (int i = 0; i < 344; i++) {EEPROM.write(i, 0);}
+  for (int i = 0; i <= EEPROM_POWER_MODE; i++) {EEPROM.write(i, 0);}
   EEPROM.commit();
 }
 
+// ----------------------------------------------------------------------------------------------------
+// ------------------------------------------ Config snapshot -----------------------------------------
+// ----------------------------------------------------------------------------------------------------
+
+/**
+   Fill the snapshot from the clock and our EEPROM. Return false if the clock didn't answer.
+*/
+boolean buildConfigSnapshot() {
+  if (!getClockOptionsFromI2C() || !getClockAlarmsFromI2C()) {
+    return false;
+  }
+
+  snapshot[0] = SNAP_MAGIC_0;
+  snapshot[1] = SNAP_MAGIC_1;
+  snapshot[2] = SNAP_VERSION;
+  for (int idx = 0 ; idx < I2C_DATA_SIZE ; idx++) {
+    snapshot[SNAP_OPTIONS_OFFSET + idx] = clockOptionBlock[idx];
+  }
+  for (byte alarm = 0 ; alarm < I2C_ALARM_COUNT ; alarm++) {
+    for (byte idx = 0 ; idx < I2C_ALARM_SIZE ; idx++) {
+      snapshot[SNAP_ALARMS_OFFSET + alarm * I2C_ALARM_SIZE + idx] = configAlarms[alarm][idx];
+    }
+  }
+  for (int idx = 0 ; idx < SNAP_ESP_SIZE ; idx++) {
+    snapshot[SNAP_ESP_OFFSET + idx] = EEPROM.read(idx);
+  }
+
+  unsigned int crc = getCRC16(snapshot, SNAP_CRC_OFFSET);
+  snapshot[SNAP_CRC_OFFSET] = crc / 256;
+  snapshot[SNAP_CRC_OFFSET + 1] = crc % 256;
+  return true;
+}
+
+/**
+   Check the uploaded snapshot and apply it. The clock gets its alarms and the option block in
+   one burst and we wait once for it to save them, then our settings go to EEPROM in one commit.
+   Return an empty string if it worked, otherwise what went wrong.
+*/
+String applyConfigSnapshot() {
+  if (snapshotLength != SNAP_SIZE) {
+    return "Wrong size, expected " + String(SNAP_SIZE) + " bytes, got " + String(snapshotLength);
+  }
+
+  if ((snapshot[0] != SNAP_MAGIC_0) || (snapshot[1] != SNAP_MAGIC_1)) {
+    return "Not a config snapshot";
+  }
+
+  if (snapshot[2] != SNAP_VERSION) {
+    return "Snapshot version " + String(snapshot[2]) + " is not supported, expected " + String(SNAP_VERSION);
+  }
+
+  unsigned int crc = getCRC16(snapshot, SNAP_CRC_OFFSET);
+  if ((snapshot[SNAP_CRC_OFFSET] != crc / 256) || (snapshot[SNAP_CRC_OFFSET + 1] != crc % 256)) {
+    return "CRC error";
+  }
+
+  if (snapshot[SNAP_OPTIONS_OFFSET + I2C_OPT_PROTOCOL] != I2C_PROTOCOL_NUMBER) {
+    return "Snapshot is for I2C protocol " + String(snapshot[SNAP_OPTIONS_OFFSET + I2C_OPT_PROTOCOL]) + ", we talk " + String(I2C_PROTOCOL_NUMBER);
+  }
+
+  // This also checks that the clock talks our protocol
+  if (!getClockOptionsFromI2C()) {
+    return "The clock did not answer";
+  }
+
+  boolean sentOK = true;
+  for (byte alarm = 0 ; alarm < I2C_ALARM_COUNT ; alarm++) {
+    byte* alarmBlock = &snapshot[SNAP_ALARMS_OFFSET + alarm * I2C_ALARM_SIZE];
+    if (!sendClockAlarm(alarm, alarmBlock[0], alarmBlock[1], alarmBlock[2], alarmBlock[3])) {
+      sentOK = false;
+    }
+  }
+  if (!sendClockOptionBlock(&snapshot[SNAP_OPTIONS_OFFSET])) {
+    sentOK = false;
+  }
+  if (!confirmOptionWrite(sentOK)) {
+    return "The clock did not confirm the settings";
+  }
+
+  for (int idx = 0 ; idx < SNAP_ESP_SIZE ; idx++) {
+    EEPROM.write(idx, snapshot[SNAP_ESP_OFFSET + idx]);
+  }
+  EEPROM.commit();
+
+  timeServerURL = getTimeServerURLFromEEPROM();
+  timeServerWiFiClient.stop();
+  powerMode = getPowerModeFromEEPROM();
+  if (WiFi.getMode() == WIFI_STA) {
+    applyPowerMode();
+  }
+
+  return "";
+}
+
+/**
+   CRC-16/CCITT (polynomial 0x1021, start 0xFFFF)
+*/
+unsigned int getCRC16(byte* data, int length) {
+  unsigned int crc = 0xFFFF;
+  for (int idx = 0 ; idx < length ; idx++) {
+    crc ^= data[idx] << 8;
+    for (byte bit = 0 ; bit < 8 ; bit++) {
+      if (crc & 0x8000) {
+        crc = ((crc << 1) ^ 0x1021) & 0xFFFF;
+      } else {
+        crc = (crc << 1) & 0xFFFF;
+      }
+    }
+  }
+  return crc;
+}
+
 
 // ----------------------------------------------------------------------------------------------------
 // ----------------------------------------- Utility functions ----------------------------------------
@@ -1140,231 +2080,546 @@ void setBlueLED(boolean newState) {
   digitalWrite(blueLedPin, newState);
 }
 
+void debugMsg(String msg) {
+  #ifdef DEBUG
+  Serial.println(msg);
+  #endif
+}
+void debugMsgContinue(String msg) {
+  #ifdef DEBUG
+  Serial.print(msg);
+  #endif
+}
+
+void setupDebug() {
+  #ifdef DEBUG
+  Serial.begin(115200);
+  debugMsg("Starting debug session");
+  #endif
+}
+
+String formatIPAsString(IPAddress ip) {
+  return String(ip[0]) + '.' + String(ip[1]) + '.' + String(ip[2]) + '.' + String(ip[3]);
+}
+
+// ----------------------------------------------------------------------------------------------------
+// ------------------------------------------- I2C functions ------------------------------------------
+// ----------------------------------------------------------------------------------------------------
+
+/**
+ * Send the time to the I2C slave. If the transmission went OK, return true, otherwise false.
+ */
+boolean sendTimeToI2C(String timeString) {
+
+  int year = getIntValue(timeString, ',', 0);
+  byte month = getIntValue(timeString, ',', 1);
+  byte day = getIntValue(timeString, ',', 2);
+  byte hour = getIntValue(timeString, ',', 3);
+  byte minute = getIntValue(timeString, ',', 4);
+  byte sec = getIntValue(timeString, ',', 5);
+
+  byte yearAdjusted = (year - 2000);
+
+  debugMsg("Sending time to I2C: " + timeString);
+
+  Wire.beginTransmission(preferredI2CSlaveAddress);
+  Wire.write(I2C_TIME_UPDATE); // Command
+  Wire.write(yearAdjusted);
+  Wire.write(month);
+  Wire.write(day);
+  Wire.write(hour);
+  Wire.write(minute);
+  Wire.write(sec);
+  int error = Wire.endTransmission();
+  return checkI2CResult(error);
+}
+
+/**
+   Get the options from the I2C slave. If the transmission went OK, return true, otherwise false.
+*/
+boolean getClockOptionsFromI2C() {
+  int available = Wire.requestFrom((int)preferredI2CSlaveAddress, I2C_DATA_SIZE);
+  debugMsg("I2C <-- Received bytes (expecting " + String(I2C_DATA_SIZE) + "): " + available);
+  if (available == I2C_DATA_SIZE) {
+    byte* optionBlock = clockOptionBlock;
+    for (int idx = 0 ; idx < I2C_DATA_SIZE ; idx++) {
+      optionBlock[idx] = Wire.read();
+    }
+
+    debugMsg("I2C <-- Got protocol header: " + String(optionBlock[I2C_OPT_PROTOCOL]));
+    if (optionBlock[I2C_OPT_PROTOCOL] != I2C_PROTOCOL_NUMBER) {
+      debugMsg("I2C Protocol ERROR! Expected header " + String(I2C_PROTOCOL_NUMBER)  + ", but got: " + String(optionBlock[I2C_OPT_PROTOCOL]));
+      return false;
+    }
+
+    configHourMode = optionBlock[I2C_OPT_12_24];
+    configBlankLead = optionBlock[I2C_OPT_BLANK_LEAD];
+    configScrollback = optionBlock[I2C_OPT_SCROLLBACK];
+    configSuppressACP = optionBlock[I2C_OPT_SUPPRESS_ACP];
+    configUseFade = optionBlock[I2C_OPT_FADE];
+    configDateFormat = optionBlock[I2C_OPT_DATE_FORMAT];
+    configDayBlanking = optionBlock[I2C_OPT_DAY_BLANKING];
+    configBlankFrom = optionBlock[I2C_OPT_BLANK_START];
+    configBlankTo = optionBlock[I2C_OPT_BLANK_END];
+    configFadeSteps = optionBlock[I2C_OPT_FADE_STEPS];
+    configScrollSteps = optionBlock[I2C_OPT_SCROLL_STEPS];
+    configBacklightMode = optionBlock[I2C_OPT_BACKLIGHT_MODE];
+    configRedCnl = optionBlock[I2C_OPT_RED_CHANNEL];
+    configGreenCnl = optionBlock[I2C_OPT_GREEN_CHANNEL];
+    configBlueCnl = optionBlock[I2C_OPT_BLUE_CHANNEL];
+    configCycleSpeed = optionBlock[I2C_OPT_CYCLE_SPEED];
+    configUseLDR = optionBlock[I2C_OPT_USE_LDR];
+    configBlankMode = optionBlock[I2C_OPT_BLANK_MODE];
+    configSlotsMode = optionBlock[I2C_OPT_SLOTS_MODE];
+    configMinDim = optionBlock[I2C_OPT_MIN_DIM_HI] * 256 + optionBlock[I2C_OPT_MIN_DIM_LO];
+    configRollMode = optionBlock[I2C_OPT_ROLL_MODE];
+    debugMsg("I2C <-- Got minDim combined: " + String(configMinDim));
+
+  } else {
+    // didn't get the right number of bytes
+    debugMsg("I2C <-- Got wrong number of bytes, expected " + String(I2C_DATA_SIZE) +" bytes, got: " + String(available));
+    return false;
+  }
+  
+  int error = Wire.endTransmission();
+  return (error == 0);
+}
+
+boolean sendIPAddressToI2C(IPAddress ip) {
+  debugMsg("Sending IP Address to I2C: " + formatIPAsString(ip));
+
+  Wire.beginTransmission(preferredI2CSlaveAddress);
+  Wire.write(I2C_SHOW_IP_ADDR); // Command
+  Wire.write(ip[0]);
+  Wire.write(ip[1]);
+  Wire.write(ip[2]);
+  Wire.write(ip[3]);
+  
+  int error = Wire.endTransmission();
+  return checkI2CResult(error);
+}
+
+// ----------------------------------------------------------------------------------------------------
+// -------------------------------------------- RTC proxy ---------------------------------------------
+// ----------------------------------------------------------------------------------------------------
+
+/**
+   Look after the RTC for a clock that doesn't talk to it itself. Pick up any time that was set on
+   the clock and, while we have no time server, keep the clock on the RTC time.
+*/
+void serviceRTCProxy() {
+  if (!useRTC) {
+    return;
+  }
+
+  if ((millis() - lastRTCProxyPollTime) < RTC_PROXY_POLL_MS) {
+    return;
+  }
+  lastRTCProxyPollTime = millis();
+
+  byte statusBlock[I2C_STATUS_SIZE];
+  if (getClockStatus(statusBlock) && (statusBlock[I2C_STAT_FLAGS] & I2C_STATUS_TIME_SET)) {
+    copyClockTimeToRTC();
+  }
+
+  if (!timeServerOK && ((millis() - lastRTCPushTime) > RTC_PUSH_MS)) {
+    sendRTCTimeToI2C();
+  }
+}
+
+/**
+   See if anyone is watching the live telemetry
+*/
+boolean hasViewers() {
+  for (byte slot = 0 ; slot < SSE_MAX_CLIENTS ; slot++) {
+    if (sseClients[slot].connected()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+   See if we have work on that idling would hold up: live viewers, a WLAN connect, or pages being loaded
+*/
+boolean isBusy() {
+  return hasViewers() || wlanConnectPending || ((millis() - lastRequestMillis) < POWER_BUSY_MS);
+}
+
+/**
+   Poll the clock once per interval while anyone is watching, and stream what changed to all of them.
+*/
+void serviceTelemetry() {
+  if (!hasViewers()) {
+    return;
+  }
+
+  if ((lastTelemetryPollTime != 0) && ((millis() - lastTelemetryPollTime) < (telemetryIntervalSecs * 1000UL))) {
+    return;
+  }
+  lastTelemetryPollTime = millis();
+
+  String json = "";
+
+  byte telemetryBlock[I2C_TELEM_SIZE];
+  if (getClockTelemetryFromI2C(telemetryBlock)) {
+    addTelemetryField(json, "hv", telemetryBlock[I2C_TELEM_HV_HI] * 256 + telemetryBlock[I2C_TELEM_HV_LO], lastTelemHV);
+    addTelemetryField(json, "brightness", telemetryBlock[I2C_TELEM_BRIGHTNESS], lastTelemBrightness);
+    addTelemetryField(json, "impressions", telemetryBlock[I2C_TELEM_IMPR_HI] * 256 + telemetryBlock[I2C_TELEM_IMPR_LO], lastTelemImpressions);
+    addTelemetryField(json, "flags", telemetryBlock[I2C_TELEM_FLAGS], lastTelemFlags);
+  }
+  addTelemetryField(json, "timeOK", timeServerOK, lastTelemTimeOK);
+  addTelemetryField(json, "syncAge", (millis() - lastI2CUpdateTime) / 1000, lastTelemSyncAge);
+  addTelemetryField(json, "i2cErrors", i2cErrorCount, lastTelemI2CErrors);
+  telemetrySendAll = false;
+
+  if (json.length() == 0) {
+    return;
+  }
+
+  String event = "event: telemetry\ndata: {" + json + "}\n\n";
+  for (byte slot = 0 ; slot < SSE_MAX_CLIENTS ; slot++) {
+    if (sseClients[slot].connected()) {
+      sseClients[slot].print(event);
+    }
+  }
+}
+
+/**
+   Add a value to a telemetry event if it changed since we last sent it.
+*/
+void addTelemetryField(String &json, const char* fieldName, long value, long &lastValue) {
+  if (!telemetrySendAll && (value == lastValue)) {
+    return;
+  }
+  lastValue = value;
+
+  if (json.length() > 0) {
+    json += ",";
+  }
+  json += "\"" + String(fieldName) + "\":" + String(value);
+}
+
+/**
+   Get the telemetry block from the I2C slave. If the transmission went OK, return true, otherwise false.
+*/
+boolean getClockTelemetryFromI2C(byte* telemetryBlock) {
+  Wire.beginTransmission(preferredI2CSlaveAddress);
+  Wire.write(I2C_GET_TELEMETRY);
+  int error = Wire.endTransmission();
+  if (!checkI2CResult(error)) {
+    return false;
+  }
+
+  int available = Wire.requestFrom((int)preferredI2CSlaveAddress, I2C_TELEM_SIZE);
+  if (available != I2C_TELEM_SIZE) {
+    debugMsg("I2C <-- Got wrong number of telemetry bytes: " + String(available));
+    return false;
+  }
+
+  for (byte idx = 0 ; idx < I2C_TELEM_SIZE ; idx++) {
+    telemetryBlock[idx] = Wire.read();
+  }
+
+  return (telemetryBlock[I2C_TELEM_OPCODE] == I2C_GET_TELEMETRY);
+}
+
+/**
+   Read the RTC and send the time and temperature to the clock. If the transmission went OK,
+   return true, otherwise false.
+*/
+boolean sendRTCTimeToI2C() {
+  byte year, month, date, dow, hour, minute, second;
+  Clock.getTime(year, month, date, dow, hour, minute, second);
+  int tempQuarters = (int) (Clock.getTemperature() * 4.0);
+
+  debugMsg("Sending RTC time to I2C: " + String(year) + "," + String(month) + "," + String(date) + "," + String(hour) + "," + String(minute) + "," + String(second));
+
+  Wire.beginTransmission(preferredI2CSlaveAddress);
+  Wire.write(I2C_RTC_TIME_UPDATE); // Command
+  Wire.write(year);
+  Wire.write(month);
+  Wire.write(date);
+  Wire.write(hour);
+  Wire.write(minute);
+  Wire.write(second);
+  Wire.write(highByte(tempQuarters));
+  Wire.write(lowByte(tempQuarters));
+  int error = Wire.endTransmission();
+
+  lastRTCPushTime = millis();
+  return checkI2CResult(error);
+}
+
+/**
+   Collect the time that was set on the clock and write it to the RTC.
+*/
+boolean copyClockTimeToRTC() {
+  Wire.beginTransmission(preferredI2CSlaveAddress);
+  Wire.write(I2C_GET_TIME);
+  int error = Wire.endTransmission();
+  if (!checkI2CResult(error)) {
+    return false;
+  }
+
+  int available = Wire.requestFrom((int)preferredI2CSlaveAddress, I2C_TIME_SIZE);
+  if (available != I2C_TIME_SIZE) {
+    debugMsg("I2C <-- Got wrong number of time bytes: " + String(available));
+    return false;
+  }
+
+  byte timeBlock[I2C_TIME_SIZE];
+  for (int idx = 0 ; idx < I2C_TIME_SIZE ; idx++) {
+    timeBlock[idx] = Wire.read();
+  }
+
+  if (timeBlock[0] != I2C_GET_TIME) {
+    return false;
+  }
+
+  debugMsg("Clock time was set, writing it to the RTC");
+  setRTC(timeBlock[1], timeBlock[2], timeBlock[3], timeBlock[4], timeBlock[5], timeBlock[6]);
+  return true;
+}
+
+/**
+   Write the time we got from the time server to the RTC.
+*/
+void setRTCFromTimeString(String timeString) {
+  int year = getIntValue(timeString, ',', 0);
+  byte month = getIntValue(timeString, ',', 1);
+  byte day = getIntValue(timeString, ',', 2);
+  byte hour = getIntValue(timeString, ',', 3);
+  byte minute = getIntValue(timeString, ',', 4);
+  byte sec = getIntValue(timeString, ',', 5);
+
+  setRTC(year - 2000, month, day, hour, minute, sec);
+}
+
+/**
+   Set the RTC, always in 24H format. The year is the 2 digit year. The time is written in a single
+   transaction and read back to check it.
+*/
+boolean setRTC(byte year, byte month, byte day, byte hour, byte minute, byte sec) {
+  boolean setOK = Clock.setDateTime(year, month, day, getDayOfWeek(2000 + year, month, day), hour, minute, sec, true);
+  if (!setOK) {
+    debugMsg("RTC did not accept the time");
+  }
+  return setOK;
+}
+
+/**
+   Day of the week, 1 = Sunday (the same as the Time library on the clock).
+*/
+byte getDayOfWeek(int year, byte month, byte day) {
+  static const byte monthOffset[12] = {0, 3, 2, 5, 0, 3, 5, 1, 4, 6, 2, 4};
+  if (month < 3) {
+    year--;
+  }
+  return ((year + year / 4 - year / 100 + year / 400 + monthOffset[month - 1] + day) % 7) + 1;
+}
+
+/**
+   Get the alarms from the I2C slave. If the transmission went OK, return true, otherwise false.
+*/
+boolean getClockAlarmsFromI2C() {
+  Wire.beginTransmission(preferredI2CSlaveAddress);
+  Wire.write(I2C_GET_ALARMS);
+  int error = Wire.endTransmission();
+  if (!checkI2CResult(error)) {
+    return false;
+  }
+
+  int available = Wire.requestFrom((int)preferredI2CSlaveAddress, I2C_ALARMS_SIZE);
+  if (available != I2C_ALARMS_SIZE) {
+    debugMsg("I2C <-- Got wrong number of alarm bytes: " + String(available));
+    return false;
+  }
+
+  if (Wire.read() != I2C_GET_ALARMS) {
+    debugMsg("I2C <-- Clock does not support alarms");
+    return false;
+  }
+
+  for (byte alarm = 0 ; alarm < I2C_ALARM_COUNT ; alarm++) {
+    for (byte idx = 0 ; idx < I2C_ALARM_SIZE ; idx++) {
+      configAlarms[alarm][idx] = Wire.read();
+    }
+  }
+
+  return true;
+}
+
 /**
-   Split a string based on a separator, get the element given by index
+   Send an alarm to the I2C slave. If the clock confirmed it, return true, otherwise false.
 */
-String getValue(String data, char separator, int index)
-{
-  int found = 0;
-  int strIndex[] = {0, -1};
-  int maxIndex = data.length() - 1;
-  for (int i = 0; i <= maxIndex && found <= index; i++) {
-    if (data.charAt(i) == separator || i == maxIndex) {
-      found++;
-      strIndex[0] = strIndex[1] + 1;
-      strIndex[1] = (i == maxIndex) ? i + 1 : i;
-    }
-  }
-  return found > index ? data.substring(strIndex[0], strIndex[1]) : "";
+boolean setClockAlarm(byte alarm, byte hour, byte minute, byte days, byte action) {
+  return confirmOptionWrite(sendClockAlarm(alarm, hour, minute, days, action));
 }
 
 /**
-   Split a string based on a separator, get the element given by index, return an integer value
+   Send an alarm without waiting for the clock to save it. Return true if the transmission went OK.
 */
-int getIntValue(String data, char separator, int index) {
-  String result = getValue(data, separator, index);
-  return atoi(result.c_str());
-}
+boolean sendClockAlarm(byte alarm, byte hour, byte minute, byte days, byte action) {
+  debugMsg("I2C --> setting alarm: " + String(alarm) + " to " + String(hour) + ":" + String(minute));
 
-void debugMsg(String msg) {
-  #ifdef DEBUG
-  Serial.println(msg);
-  #endif
-}
-void debugMsgContinue(String msg) {
-  #ifdef DEBUG
-  Serial.print(msg);
-  #endif
+  Wire.beginTransmission(preferredI2CSlaveAddress);
+  Wire.write(I2C_SET_ALARM);
+  Wire.write(alarm);
+  Wire.write(hour);
+  Wire.write(minute);
+  Wire.write(days);
+  Wire.write(action);
+  int error = Wire.endTransmission();
+  return checkI2CResult(error);
 }
 
-void setupDebug() {
-  #ifdef DEBUG
-  Serial.begin(115200);
-  debugMsg("Starting debug session");
-  #endif
+/**
+   Start, stop or reset the stopwatch or countdown on the clock.
+*/
+boolean sendTimerCommand(byte timer, byte command) {
+  Wire.beginTransmission(preferredI2CSlaveAddress);
+  Wire.write(I2C_TIMER_CONTROL);
+  Wire.write(timer);
+  Wire.write(command);
+  int error = Wire.endTransmission();
+  return checkI2CResult(error);
 }
 
-String formatIPAsString(IPAddress ip) {
-  return String(ip[0]) + '.' + String(ip[1]) + '.' + String(ip[2]) + '.' + String(ip[3]);
+/**
+   Set the time the countdown starts from.
+*/
+boolean setClockCountdown(byte mins, byte secs) {
+  Wire.beginTransmission(preferredI2CSlaveAddress);
+  Wire.write(I2C_SET_COUNTDOWN);
+  Wire.write(mins);
+  Wire.write(secs);
+  int error = Wire.endTransmission();
+  return checkI2CResult(error);
 }
 
-// ----------------------------------------------------------------------------------------------------
-// ------------------------------------------- I2C functions ------------------------------------------
-// ----------------------------------------------------------------------------------------------------
-
 /**
- * Send the time to the I2C slave. If the transmission went OK, return true, otherwise false.
- */
-boolean sendTimeToI2C(String timeString) {
+   Get the boot timeline from the I2C slave. If the transmission went OK, return true, otherwise false.
+*/
+boolean getClockBootTimesFromI2C() {
+  Wire.beginTransmission(preferredI2CSlaveAddress);
+  Wire.write(I2C_GET_BOOT_TIMES);
+  int error = Wire.endTransmission();
+  if (!checkI2CResult(error)) {
+    return false;
+  }
 
-  int year = getIntValue(timeString, ',', 0);
-  byte month = getIntValue(timeString, ',', 1);
-  byte day = getIntValue(timeString, ',', 2);
-  byte hour = getIntValue(timeString, ',', 3);
-  byte minute = getIntValue(timeString, ',', 4);
-  byte sec = getIntValue(timeString, ',', 5);
+  int available = Wire.requestFrom((int)preferredI2CSlaveAddress, I2C_BOOT_SIZE);
+  if (available != I2C_BOOT_SIZE) {
+    debugMsg("I2C <-- Got wrong number of boot time bytes: " + String(available));
+    return false;
+  }
 
-  byte yearAdjusted = (year - 2000);
+  for (byte idx = 0 ; idx < I2C_BOOT_SIZE ; idx++) {
+    bootTimesBlock[idx] = Wire.read();
+  }
 
-  debugMsg("Sending time to I2C: " + timeString);
+  if (bootTimesBlock[0] != I2C_GET_BOOT_TIMES) {
+    debugMsg("I2C <-- Clock does not report boot times");
+    return false;
+  }
+
+  return true;
+}
 
+/**
+   Start the self test on the clock. It runs in the clock main loop, read the result a few seconds later.
+*/
+boolean runClockSelfTest() {
   Wire.beginTransmission(preferredI2CSlaveAddress);
-  Wire.write(I2C_TIME_UPDATE); // Command
-  Wire.write(yearAdjusted);
-  Wire.write(month);
-  Wire.write(day);
-  Wire.write(hour);
-  Wire.write(minute);
-  Wire.write(sec);
+  Wire.write(I2C_RUN_SELF_TEST);
   int error = Wire.endTransmission();
-  return (error == 0);
+  return checkI2CResult(error);
 }
 
 /**
-   Get the options from the I2C slave. If the transmission went OK, return true, otherwise false.
+   Get the last self test result from the I2C slave. If the transmission went OK, return true, otherwise false.
 */
-boolean getClockOptionsFromI2C() {
-  int available = Wire.requestFrom((int)preferredI2CSlaveAddress, I2C_DATA_SIZE);
-  debugMsg("I2C <-- Received bytes (expecting " + String(I2C_DATA_SIZE) + "): " + available);
-  if (available == I2C_DATA_SIZE) {
+boolean getClockSelfTestFromI2C() {
+  Wire.beginTransmission(preferredI2CSlaveAddress);
+  Wire.write(I2C_GET_SELF_TEST);
+  int error = Wire.endTransmission();
+  if (!checkI2CResult(error)) {
+    return false;
+  }
 
-    // IDX 
-    byte receivedByte = Wire.read();
-    debugMsg("I2C <-- Got protocol header: " + receivedByte);
+  int available = Wire.requestFrom((int)preferredI2CSlaveAddress, I2C_SELF_TEST_SIZE);
+  if (available != I2C_SELF_TEST_SIZE) {
+    debugMsg("I2C <-- Got wrong number of self test bytes: " + String(available));
+    return false;
+  }
 
-    if (receivedByte != I2C_PROTOCOL_NUMBER) {
-      debugMsg("I2C Protocol ERROR! Expected header " + String(I2C_PROTOCOL_NUMBER)  + ", but got: " + String(receivedByte));
-      return false;
-    }
-    
-    // IDX 1
-    receivedByte = Wire.read();
-    debugMsg("I2C <-- Got hour mode: " + receivedByte);
-    configHourMode = receivedByte;
-
-    // IDX 2
-    receivedByte = Wire.read();
-    debugMsg("I2C <-- Got blank lead: " + receivedByte);
-    configBlankLead = receivedByte;
-
-    // IDX 3
-    receivedByte = Wire.read();
-    debugMsg("I2C <-- Got scrollback: " + receivedByte);
-    configScrollback = receivedByte;
-
-    // IDX 4
-    receivedByte = Wire.read();
-    debugMsg("I2C <-- Got suppress ACP: " + receivedByte);
-    configSuppressACP = receivedByte;
-
-    // IDX 5
-    receivedByte = Wire.read();
-    debugMsg("I2C <-- Got useFade: " + receivedByte);
-    configUseFade = receivedByte;
-
-    // IDX 6
-    receivedByte = Wire.read();
-    debugMsg("I2C <-- Got date format: " + receivedByte);
-    configDateFormat = receivedByte;
-
-    // IDX 7
-    receivedByte = Wire.read();
-    debugMsg("I2C <-- Got day blanking: " + receivedByte);
-    configDayBlanking = receivedByte;
-
-    // IDX 8
-    receivedByte = Wire.read();
-    debugMsg("I2C <-- Got blank hour start: " + receivedByte);
-    configBlankFrom = receivedByte;
-
-    // IDX 9
-    receivedByte = Wire.read();
-    debugMsg("I2C <-- Got blank hour end: " + receivedByte);
-    configBlankTo = receivedByte;
-
-    // IDX 10
-    receivedByte = Wire.read();
-    debugMsg("I2C <-- Got fade steps: " + receivedByte);
-    configFadeSteps = receivedByte;
-
-    // IDX 11
-    receivedByte = Wire.read();
-    debugMsg("I2C <-- Got scroll steps: " + receivedByte);
-    configScrollSteps = receivedByte;
-
-    // IDX 12
-    receivedByte = Wire.read();
-    debugMsg("I2C <-- Got backlight mode: " + receivedByte);
-    configBacklightMode = receivedByte;
-
-    // IDX 13
-    receivedByte = Wire.read();
-    debugMsg("I2C <-- Got red channel: " + receivedByte);
-    configRedCnl = receivedByte;
-
-    // IDX 14
-    receivedByte = Wire.read();
-    debugMsg("I2C <-- Got green channel: " + receivedByte);
-    configGreenCnl = receivedByte;
-
-    // IDX 15
-    receivedByte = Wire.read();
-    debugMsg("I2C <-- Got blue channel: " + receivedByte);
-    configBlueCnl = receivedByte;
-
-    // IDX 16
-    receivedByte = Wire.read();
-    debugMsg("I2C <-- Got cycle speed: " + receivedByte);
-    configCycleSpeed = receivedByte;
-
-    // IDX 17
-    receivedByte = Wire.read();
-    debugMsg("I2C <-- Got useLDR: " + receivedByte);
-    configUseLDR = receivedByte;
-
-    // IDX 18
-    receivedByte = Wire.read();
-    debugMsg("I2C <-- Got blankMode: " + receivedByte);
-    configBlankMode = receivedByte;
-
-    // IDX 19
-    receivedByte = Wire.read();
-    debugMsg("I2C <-- Got slotsMode: " + receivedByte);
-    configSlotsMode = receivedByte;
-    
-    // IDX 20
-    receivedByte = Wire.read();
-    debugMsg("I2C <-- Got minDim Hi: " + receivedByte);
-    int newMinDim = receivedByte * 256;
-    
-    // IDX 21
-    receivedByte = Wire.read();
-    debugMsg("I2C <-- Got minDim Lo: " + receivedByte);
-    newMinDim += receivedByte;
-    debugMsg("I2C <-- Got minDim combined: " + newMinDim);
-    configMinDim = newMinDim;
+  for (byte idx = 0 ; idx < I2C_SELF_TEST_SIZE ; idx++) {
+    selfTestBlock[idx] = Wire.read();
+  }
 
-  } else {
-    // didn't get the right number of bytes
-    debugMsg("I2C <-- Got wrong number of bytes, expected " + String(I2C_DATA_SIZE) +" bytes, got: " + String(available));
+  if (selfTestBlock[I2C_SELF_TEST_OPCODE] != I2C_GET_SELF_TEST) {
+    debugMsg("I2C <-- Clock does not support the self test");
+    return false;
   }
-  
+
+  return true;
+}
+
+/**
+   Start a cathode rejuvenation program on the clock.
+*/
+boolean startClockRejuvenation(byte tubes, unsigned int cathodes, byte duty, byte stepMins) {
+  Wire.beginTransmission(preferredI2CSlaveAddress);
+  Wire.write(I2C_REJUV_CONTROL);
+  Wire.write(I2C_REJUV_CMD_START);
+  Wire.write(tubes);
+  Wire.write(cathodes / 256);
+  Wire.write(cathodes % 256);
+  Wire.write(duty);
+  Wire.write(stepMins);
   int error = Wire.endTransmission();
-  return (error == 0);
+  return confirmOptionWrite(checkI2CResult(error));
 }
 
-boolean sendIPAddressToI2C(IPAddress ip) {
-  debugMsg("Sending IP Address to I2C: " + formatIPAsString(ip));
+/**
+   Pause, resume or cancel the cathode rejuvenation program.
+*/
+boolean sendRejuvCommand(byte command) {
+  Wire.beginTransmission(preferredI2CSlaveAddress);
+  Wire.write(I2C_REJUV_CONTROL);
+  Wire.write(command);
+  int error = Wire.endTransmission();
+  return confirmOptionWrite(checkI2CResult(error));
+}
 
+/**
+   Get the rejuvenation progress from the I2C slave. If the transmission went OK, return true, otherwise false.
+*/
+boolean getClockRejuvFromI2C() {
   Wire.beginTransmission(preferredI2CSlaveAddress);
-  Wire.write(I2C_SHOW_IP_ADDR); // Command
-  Wire.write(ip[0]);
-  Wire.write(ip[1]);
-  Wire.write(ip[2]);
-  Wire.write(ip[3]);
-  
+  Wire.write(I2C_GET_REJUV);
   int error = Wire.endTransmission();
-  return (error == 0);
+  if (!checkI2CResult(error)) {
+    return false;
+  }
+
+  int available = Wire.requestFrom((int)preferredI2CSlaveAddress, I2C_REJUV_SIZE);
+  if (available != I2C_REJUV_SIZE) {
+    debugMsg("I2C <-- Got wrong number of rejuvenation bytes: " + String(available));
+    return false;
+  }
+
+  for (byte idx = 0 ; idx < I2C_REJUV_SIZE ; idx++) {
+    rejuvBlock[idx] = Wire.read();
+  }
+
+  if (rejuvBlock[I2C_REJUV_OPCODE] != I2C_GET_REJUV) {
+    debugMsg("I2C <-- Clock does not support rejuvenation");
+    return false;
+  }
+
+  return true;
 }
 
 boolean setClockOption12H24H(boolean newMode) {
@@ -1443,10 +2698,28 @@ boolean setClockOptionSlotsMode(byte newMode) {
   return setClockOptionByte(I2C_SET_OPTION_SLOTS_MODE, newMode);
 }
 
+boolean setClockOptionRollMode(byte newMode) {
+  return setClockOptionByte(I2C_SET_OPTION_ROLL_MODE, newMode);
+}
+
 boolean setClockOptionMinDim(unsigned int newMinDim) {
   return setClockOptionInt(I2C_SET_OPTION_MIN_DIM, newMinDim);
 }
 
+/**
+   Send a whole option block in one write, without waiting for the clock to save it.
+   Return true if the transmission went OK.
+*/
+boolean sendClockOptionBlock(byte* optionBlock) {
+  debugMsg("I2C --> sending option block");
+
+  Wire.beginTransmission(preferredI2CSlaveAddress);
+  Wire.write(I2C_SET_OPTIONS);
+  Wire.write(optionBlock, I2C_DATA_SIZE);
+  int error = Wire.endTransmission();
+  return checkI2CResult(error);
+}
+
 /**
    Send the options from the I2C slave. If the transmission went OK, return true, otherwise false.
 */
@@ -1463,8 +2736,7 @@ boolean setClockOptionBoolean(byte option, boolean newMode) {
   }
   Wire.write(newOption);
   int error = Wire.endTransmission();
-  delay(10);
-  return (error == 0);
+  return confirmOptionWrite(checkI2CResult(error));
 }
 
 /**
@@ -1477,8 +2749,7 @@ boolean setClockOptionByte(byte option, byte newMode) {
   Wire.write(option);
   Wire.write(newMode);
   int error = Wire.endTransmission();
-  delay(10);
-  return (error == 0);
+  return confirmOptionWrite(checkI2CResult(error));
 }
 
 /**
@@ -1494,10 +2765,189 @@ boolean setClockOptionInt(byte option, int newMode) {
   Wire.write(hiByte);
   Wire.write(loByte);
   int error = Wire.endTransmission();
-  delay(10);
-  return (error == 0);
+  return confirmOptionWrite(checkI2CResult(error));
+}
+
+
+/**
+   Wait until the clock has saved the option we just sent, polling its status block rather than
+   guessing how long it takes. Clocks without the status block get the old fixed delay.
+   Failures are counted so that the config page can report them.
+*/
+boolean confirmOptionWrite(boolean sentOK) {
+  if (sentOK) {
+    if (clockHasStatus) {
+      sentOK = waitForClockToApply();
+    } else {
+      delay(10);
+    }
+  }
+
+  if (!sentOK) {
+    optionWriteFailures++;
+  }
+
+  return sentOK;
+}
+
+/**
+   Poll the status block until the clock has applied everything it has received, or we time out.
+   The received sequence number already includes our write, so once the applied one catches up,
+   our option is saved.
+*/
+boolean waitForClockToApply() {
+  unsigned long startMillis = millis();
+  while ((millis() - startMillis) < I2C_APPLY_TIMEOUT_MS) {
+    byte statusBlock[I2C_STATUS_SIZE];
+    if (getClockStatus(statusBlock)) {
+      if (((statusBlock[I2C_STAT_FLAGS] & I2C_STATUS_BUSY) == 0) &&
+          (statusBlock[I2C_STAT_APPLIED_SEQ] == statusBlock[I2C_STAT_RECEIVED_SEQ])) {
+        return true;
+      }
+    }
+
+    delay(1);
+  }
+
+  debugMsg("I2C <-- Clock did not confirm option within " + String(I2C_APPLY_TIMEOUT_MS) + "mS");
+  return false;
+}
+
+/**
+   Read the status block from the clock. Return true if we got a valid one.
+*/
+boolean getClockStatus(byte* statusBlock) {
+  Wire.beginTransmission(preferredI2CSlaveAddress);
+  Wire.write(I2C_GET_STATUS);
+  int error = Wire.endTransmission();
+  if (!checkI2CResult(error)) {
+    return false;
+  }
+
+  int available = Wire.requestFrom((int)preferredI2CSlaveAddress, I2C_STATUS_SIZE);
+  if (available != I2C_STATUS_SIZE) {
+    return false;
+  }
+
+  for (int idx = 0 ; idx < I2C_STATUS_SIZE ; idx++) {
+    statusBlock[idx] = Wire.read();
+  }
+
+  if (statusBlock[I2C_STAT_OPCODE] != I2C_GET_STATUS) {
+    return false;
+  }
+
+  // The received sequence only goes back when the clock restarts (or
+  // wraps, which costs us one handshake we didn't need)
+  if (statusBlock[I2C_STAT_RECEIVED_SEQ] < i2cLastReceivedSeq) {
+    debugMsg("I2C <-- Clock restarted");
+    i2cClockRestarted = true;
+  }
+  i2cLastReceivedSeq = statusBlock[I2C_STAT_RECEIVED_SEQ];
+
+  return true;
+}
+
+/**
+   Agree the bus speed with the clock. The handshake itself always runs at standard speed, so
+   this is also how we fall back. If both sides can do it we switch to 400kHz fast mode.
+   Return true if the clock answered the handshake.
+*/
+boolean negotiateI2CSpeed(boolean offerFastMode) {
+  Wire.setClock(I2C_SPEED_STANDARD);
+  i2cFastMode = false;
+  i2cConsecutiveErrors = 0;
+  i2cLastNegotiateTime = millis();
+  i2cClockRestarted = false;
+  i2cHandshakeOK = false;
+  clockHasStatus = false;
+  clockUsesRTCProxy = false;
+
+  Wire.beginTransmission(preferredI2CSlaveAddress);
+  Wire.write(I2C_GET_CAPABILITIES);
+  if (offerFastMode) {
+    Wire.write(I2C_CAP_FAST_MODE);
+  } else {
+    Wire.write(0);
+  }
+  int error = Wire.endTransmission();
+  if (error != 0) {
+    debugMsg("I2C --> Capability handshake failed: " + String(error));
+    return false;
+  }
+
+  int available = Wire.requestFrom((int)preferredI2CSlaveAddress, I2C_CAPS_SIZE);
+  if (available != I2C_CAPS_SIZE) {
+    debugMsg("I2C <-- Got wrong number of capability bytes: " + String(available));
+    return false;
+  }
+
+  byte echo = Wire.read();
+  byte protocol = Wire.read();
+  byte clockCaps = Wire.read();
+  if ((echo != I2C_GET_CAPABILITIES) || (protocol != I2C_PROTOCOL_NUMBER)) {
+    // Older clocks don't know the handshake and send the option block instead
+    debugMsg("I2C <-- Clock does not support capability handshake, staying at standard speed");
+    return false;
+  }
+
+  i2cHandshakeOK = true;
+  i2cHandshakeSeen = true;
+  clockHasStatus = ((clockCaps & I2C_CAP_STATUS) != 0);
+  clockUsesRTCProxy = ((clockCaps & I2C_CAP_RTC_PROXY) != 0);
+
+  if (offerFastMode && (clockCaps & I2C_CAP_FAST_MODE)) {
+    Wire.setClock(I2C_SPEED_FAST);
+    i2cFastMode = true;
+    debugMsg("I2C bus switched to fast mode");
+  }
+
+  return true;
+}
+
+/**
+   Check the result of a transmission. While in fast mode we count consecutive errors and drop back
+   to standard speed (telling the clock as well) if we get too many of them.
+*/
+boolean checkI2CResult(int error) {
+  if (error == 0) {
+    i2cConsecutiveErrors = 0;
+    return true;
+  }
+
+  i2cErrorCount++;
+  i2cLastErrorTime = millis();
+
+  if (i2cFastMode) {
+    i2cConsecutiveErrors++;
+    if (i2cConsecutiveErrors >= I2C_FAST_MODE_MAX_ERRORS) {
+      debugMsg("I2C errors in fast mode, falling back to standard speed");
+      negotiateI2CSpeed(false);
+    }
+  }
+
+  return false;
 }
 
+/**
+   Handshake again when what we agreed with the clock may be stale: at once if the clock restarted,
+   otherwise once the bus has been quiet for a while. This takes us back to fast mode after a
+   fallback, and tells a clock that restarted without us seeing it that we can do fast mode.
+*/
+void serviceI2CSpeed() {
+  unsigned long waitMillis = I2C_RENEGOTIATE_MS;
+  if (i2cHandshakeSeen && !i2cHandshakeOK) {
+    waitMillis = I2C_RENEGOTIATE_RETRY_MS;
+  }
+
+  if (!i2cClockRestarted &&
+      (((millis() - i2cLastNegotiateTime) < waitMillis) || ((millis() - i2cLastErrorTime) < waitMillis))) {
+    return;
+  }
+
+  debugMsg("I2C --> Renegotiating bus speed");
+  negotiateI2CSpeed(true);
+}
 
 boolean scanI2CBus() {
   debugMsg("Scanning I2C bus");
@@ -1522,6 +2972,8 @@ boolean scanI2CBus() {
     preferredI2CSlaveAddress = pingAnsweredFrom;
     preferredAddressFoundBy = 2;
   }
+
+  return (preferredI2CSlaveAddress != 0xff);
 }
 
 // ----------------------------------------------------------------------------------------------------
@@ -1544,244 +2996,5 @@ String getHTMLHead() {
   return header;
 }
 
-/**
-   Get the bootstrap top row navbar, including the Bootstrap links
-*/
-String getNavBar() {
-  String navbar = "<nav class=\"navbar navbar-inverse navbar-fixed-top\">";
-  navbar += "<div class=\"container-fluid\"><div class=\"navbar-header\"><button type=\"button\" class=\"navbar-toggle collapsed\" data-toggle=\"collapse\" data-target=\"#navbar\" aria-expanded=\"false\" aria-controls=\"navbar\">";
-  navbar += "<span class=\"sr-only\">Toggle navigation</span><span class=\"icon-bar\"></span><span class=\"icon-bar\"></span><span class=\"icon-bar\"></span></button>";
-  navbar += "<a class=\"navbar-brand\" href=\"#\">Arduino Nixie Clock Time Module</a></div><div id=\"navbar\" class=\"navbar-collapse collapse\"><ul class=\"nav navbar-nav navbar-right\">";
-  navbar += "<li><a href=\"/\">Summary</a></li><li><a href=\"/time\">Configure Time Server</a></li><li><a href=\"/wlan_config\">Configure WLAN settings</a></li><li><a href=\"/clockconfig\">Configure clock settings</a></li></ul></div></div></nav>";
-  return navbar;
-} 
-
-/**
-   Get the header for a 2 column table
-*/
-String getTableHead2Col(String tableHeader, String col1Header, String col2Header) {
-  String tableHead = "<div class=\"container\" role=\"main\"><h3 class=\"sub-header\">";
-  tableHead += tableHeader;
-  tableHead += "</h3><div class=\"table-responsive\"><table class=\"table table-striped\"><thead><tr><th>";
-  tableHead += col1Header;
-  tableHead += "</th><th>";
-  tableHead += col2Header;
-  tableHead += "</th></tr></thead><tbody>";
-
-  return tableHead;
-}
-
-String getTableRow2Col(String col1Val, String col2Val) {
-  String tableRow = "<tr><td>";
-  tableRow += col1Val;
-  tableRow += "</td><td>";
-  tableRow += col2Val;
-  tableRow += "</td></tr>";
-
-  return tableRow;
-}
-
-String getTableRow2Col(String col1Val, int col2Val) {
-  String tableRow = "<tr><td>";
-  tableRow += col1Val;
-  tableRow += "</td><td>";
-  tableRow += col2Val;
-  tableRow += "</td></tr>";
-
-  return tableRow;
-}
-
-String getTableFoot() {
-  return "</tbody></table></div></div>";
-}
-
-/**
-   Get the header for an input form
-*/
-String getFormHead(String formTitle) {
-  String tableHead = "<div class=\"container\" role=\"main\"><h3 class=\"sub-header\">";
-  tableHead += formTitle;
-  tableHead += "</h3><form class=\"form-horizontal\">";
-
-  return tableHead;
-}
-
-/**
-   Get the header for an input form
-*/
-String getFormFoot() {
-  return "</form></div>";
-}
-
-String getHTMLFoot() {
-  return "</body></html>";
-}
-
-String getRadioGroupHeader(String header) {
-  String result = "<div class=\"form-group\"><label class=\"control-label col-xs-3\">";
-  result += header;
-  result += "</label>";
-  return result;
-}
-
-String getRadioButton(String group_name, String text, String value, boolean checked) {
-  String result = "<div class=\"col-xs-1\">";
-  if (checked) {
-    result += "<label class=\"radio-inline\"><input checked type=\"radio\" name=\"";
-  } else {
-    result += "<label class=\"radio-inline\"><input type=\"radio\" name=\"";
-  }
-  result += group_name;
-  result += "\" value=\"";
-  result += value;
-  result += "\"> ";
-  result += text;
-  result += "</label></div>";
-  return result;
-}
-
-String getRadioGroupFooter() {
-  String result = "</div>";
-  return result;
-}
-
-String getCheckBox(String checkbox_name, String value, String text, boolean checked) {
-  String result = "<div class=\"form-group\"><div class=\"col-xs-offset-3 col-xs-9\"><label class=\"checkbox-inline\">";
-  if (checked) {
-    result += "<input checked type=\"checkbox\" name=\"";
-  } else {
-    result += "<input type=\"checkbox\" name=\"";
-  }
-
-  result += checkbox_name;
-  result += "\" value=\"";
-  result += value;
-  result += "\"> ";
-  result += text;
-  result += "</label></div></div>";
-
-  return result;
-}
-
-String getDropDownHeader(String heading, String group_name, boolean wide) {
-  String result = "<div class=\"form-group\"><label class=\"control-label col-xs-3\">";
-  result += heading;
-  if (wide) {
-    result += "</label><div class=\"col-xs-8\"><select class=\"form-control\" name=\"";
-  } else {
-    result += "</label><div class=\"col-xs-2\"><select class=\"form-control\" name=\"";
-  }
-  result += group_name;
-  result += "\">";
-  return result;
-}
-
-String getDropDownOption (String value, String text, boolean checked) {
-  String result = "";
-  if (checked) {
-    result += "<option selected value=\"";
-  } else {
-    result += "<option value=\"";
-  }
-  result += value;
-  result += "\">";
-  result += text;
-  result += "</option>";
-  return result;
-}
-
-String getDropDownFooter() {
-  return "</select></div></div>";
-}
-
-String getNumberInput(String heading, String input_name, unsigned int minVal, unsigned int maxVal, unsigned int value, boolean disabled) {
-  String result = "<div class=\"form-group\"><label class=\"control-label col-xs-3\" for=\"";
-  result += input_name;
-  result += "\">";
-  result += heading;
-  result += "</label><div class=\"col-xs-2\"><input type=\"number\" class=\"form-control\" name=\"";
-  result += input_name;
-  result += "\" id=\"";
-  result += input_name;
-  result += "\" min=\"";
-  result += minVal;
-  result += "\" max=\"";
-  result += maxVal;
-  result += "\" value=\"";
-  result += value;
-  if (disabled) {
-    result += " disabled";
-  }
-  result += "\"></div></div>";
-
-  return result;
-}
-
-String getNumberInputWide(String heading, String input_name, byte minVal, byte maxVal, byte value, boolean disabled) {
-  String result = "<div class=\"form-group\"><label class=\"control-label col-xs-8\" for=\"";
-  result += input_name;
-  result += "\">";
-  result += heading;
-  result += "</label><div class=\"col-xs-2\"><input type=\"number\" class=\"form-control\" name=\"";
-  result += input_name;
-  result += "\" id=\"";
-  result += input_name;
-  result += "\" min=\"";
-  result += minVal;
-  result += "\" max=\"";
-  result += maxVal;
-  result += "\" value=\"";
-  result += value;
-  if (disabled) {
-    result += " disabled";
-  }
-  result += "\"></div></div>";
-
-  return result;
-}
-
-String getTextInput(String heading, String input_name, String value, boolean disabled) {
-  String result = "<div class=\"form-group\"><label class=\"control-label col-xs-3\" for=\"";
-  result += input_name;
-  result += "\">";
-  result += heading;
-  result += "</label><div class=\"col-xs-2\"><input type=\"text\" class=\"form-control\" name=\"";
-  result += input_name;
-  result += "\" id=\"";
-  result += input_name;
-  result += "\" value=\"";
-  result += value;
-  if (disabled) {
-    result += " disabled";
-  }
-  result += "\"></div></div>";
-
-  return result;
-}
-
-String getTextInputWide(String heading, String input_name, String value, boolean disabled) {
-  String result = "<div class=\"form-group\"><label class=\"control-label col-xs-3\" for=\"";
-  result += input_name;
-  result += "\">";
-  result += heading;
-  result += "</label><div class=\"col-xs-8\"><input type=\"text\" class=\"form-control\" name=\"";
-  result += input_name;
-  result += "\" id=\"";
-  result += input_name;
-  result += "\" value=\"";
-  result += value;
-  if (disabled) {
-    result += " disabled";
-  }
-  result += "\"></div></div>";
-
-  return result;
-}
-
-String getSubmitButton(String buttonText) {
-  String result = "<div class=\"form-group\"><div class=\"col-xs-offset-3 col-xs-9\"><input type=\"submit\" class=\"btn btn-primary\" value=\"";
-  result += buttonText;
-  result += "\"></div></div>";
-  return result;
-}
+// The rest of the page fragments are in WebLogic.cpp
 
@@ -0,0 +1,17 @@
+#ifndef EventDefs_h
+#define EventDefs_h
+
+// Events, each raised once when it happens
+#define EVENT_MINUTE                   0  // the time moved on to a new minute
+#define EVENT_HOUR                     1  // the time moved on to a new hour
+#define EVENT_DAY                      2  // the time moved on to a new day
+
+// Subscriber table entry. The table is in PROGMEM, so it costs no RAM.
+typedef void (*EventHandler)();
+
+typedef struct {
+  byte event;
+  EventHandler handler;
+} EventSubscriber;
+
+#endif
@@ -23,6 +23,7 @@
 
 // Other parts of the code, broken out for clarity
 #include "ClockButton.h"
+#include "EventDefs.h"
 
 //**********************************************************************************
 //**********************************************************************************
@@ -665,7 +666,9 @@ byte blankSuppressStep = 0;    // The press we are on: 1 press = suppress for 1
 unsigned long blankSuppressedMillis = 0;   // The end time of the blanking, 0 if we are not suppressed
 unsigned long blankSuppressedSelectionTimoutMillis = 0;   // Used for determining the end of the blanking period selection timeout
 boolean hourMode = false;
-boolean triggeredThisSec = false;
+
+// What we last raised events for
+time_t lastEventTime = 0;
 
 byte useRTC = false;  // true if we detect an RTC
 byte useWiFi = 0; // the number of minutes ago we recevied information from the WiFi module, 0 = don't use WiFi
@@ -941,6 +944,9 @@ void setup()
   setTime(12, 34, 56, 1, 3, 2017);
   getRTCTime();
 
+  // The first minute event comes when the minute changes, not straight away
+  lastEventTime = now();
+
   // Show the version for 1 s
   tempDisplayMode = TEMP_MODE_VERSION;
   tempDisplayModeDuration = TEMP_DISPLAY_MODE_DUR_MS;
@@ -969,29 +975,24 @@ void loop()
   // -------------------------------------------------------------------------------
   
   if (abs(nowMillis - lastCheckMillis) >= 1000) {
-    if ((second() == 0) && (!triggeredThisSec)) {
-      if ((minute() == 0)) {
-        if (hour() == 0) {
-          performOncePerDayProcessing();
-        }
-        
-        performOncePerHourProcessing();
-      }
-      
-      performOncePerMinuteProcessing();
-    }
-
     performOncePerSecondProcessing();
 
-    // Make sure we don't call multiple times
-    triggeredThisSec = true;
-    
-    if ((second() > 0) && triggeredThisSec) {
-      triggeredThisSec = false;
-    }
-
     lastCheckMillis = nowMillis;
   }
+
+  // Time events, raised once on the edge. If the time was set back we
+  // only catch up with it: the minute it went back to has had its event.
+  time_t timeNow = now();
+  if ((timeNow / SECS_PER_MIN) > (lastEventTime / SECS_PER_MIN)) {
+    if ((timeNow / SECS_PER_DAY) > (lastEventTime / SECS_PER_DAY)) {
+      raiseEvent(EVENT_DAY);
+    }
+    if ((timeNow / SECS_PER_HOUR) > (lastEventTime / SECS_PER_HOUR)) {
+      raiseEvent(EVENT_HOUR);
+    }
+    raiseEvent(EVENT_MINUTE);
+  }
+  lastEventTime = timeNow;
   
   // -------------------------------------------------------------------------------
 
@@ -1184,6 +1185,33 @@ void performOncePerHourProcessing() {
 void performOncePerDayProcessing() {
 }
 
+//**********************************************************************************
+//**********************************************************************************
+//*                                    Events                                      *
+//**********************************************************************************
+//**********************************************************************************
+
+// Who wants to hear about what. Handlers are called in table order.
+const EventSubscriber eventSubscribers[] PROGMEM = {
+  {EVENT_DAY,    performOncePerDayProcessing},
+  {EVENT_HOUR,   performOncePerHourProcessing},
+  {EVENT_MINUTE, performOncePerMinuteProcessing},
+};
+
+#define EVENT_SUBSCRIBER_COUNT (sizeof(eventSubscribers) / sizeof(EventSubscriber))
+
+// ************************************************************
+// Call everyone who subscribed to the event
+// ************************************************************
+void raiseEvent(byte event) {
+  for (byte idx = 0 ; idx < EVENT_SUBSCRIBER_COUNT ; idx++) {
+    if (pgm_read_byte(&eventSubscribers[idx].event) == event) {
+      EventHandler handler = (EventHandler) pgm_read_ptr(&eventSubscribers[idx].handler);
+      handler();
+    }
+  }
+}
+
 // ************************************************************
 // Set the seconds tick led(s) and the back lights
 // ************************************************************
@@ -0,0 +1,178 @@
+#include "Arduino.h"
+#include "ClockLogic.h"
+
+// ************************************************************
+// If the hour falls in the blanking period. The period can run
+// over midnight, Start = End means no blanking.
+// ************************************************************
+boolean isHoursBlanked(byte hourNow, byte blankHourStart, byte blankHourEnd) {
+  if (blankHourStart > blankHourEnd) {
+    // blanking before midnight
+    return ((hourNow >= blankHourStart) || (hourNow < blankHourEnd));
+  } else if (blankHourStart < blankHourEnd) {
+    // dim at or after midnight
+    return ((hourNow >= blankHourStart) && (hourNow < blankHourEnd));
+  } else {
+    // no dimming if Start = End
+    return false;
+  }
+}
+
+// ************************************************************
+// If the day blanking mode blanks us. Weekday as the Time
+// library gives it: 1 = Sunday, 7 = Saturday.
+// ************************************************************
+boolean isDayBlanked(byte dayBlanking, byte weekdayNow, boolean hoursBlanked) {
+  boolean weekend = ((weekdayNow == 1) || (weekdayNow == 7));
+
+  switch (dayBlanking) {
+    case DAY_BLANKING_HOURS:
+      return hoursBlanked;
+    case DAY_BLANKING_WEEKEND:
+      return weekend;
+    case DAY_BLANKING_WEEKEND_OR_HOURS:
+      return weekend || hoursBlanked;
+    case DAY_BLANKING_WEEKEND_AND_HOURS:
+      return weekend && hoursBlanked;
+    case DAY_BLANKING_WEEKDAY:
+      return !weekend;
+    case DAY_BLANKING_WEEKDAY_OR_HOURS:
+      return !weekend || hoursBlanked;
+    case DAY_BLANKING_WEEKDAY_AND_HOURS:
+      return !weekend && hoursBlanked;
+    case DAY_BLANKING_ALWAYS:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// ************************************************************
+// Simple moving average: move the smoothed value 1/smoothCount
+// of the way towards the new reading
+// ************************************************************
+double smoothSensorReading(double smoothed, int rawValue, int smoothCount) {
+  double sensorDiff = rawValue - smoothed;
+  return smoothed + (sensorDiff / smoothCount);
+}
+
+// ************************************************************
+// Map the smoothed LDR reading onto the display brightness,
+// 0 in the dark up to the full on count. The caller scales and
+// clamps the result.
+//
+// dimDark is taken off both before and after the clamp, as
+// getDimmingFromLDR() always did, so the ramp runs from
+// 2 * dimDark to dimBright + dimDark. Every clock's thresholds
+// are set against that, so changing it is a change of its own.
+// ************************************************************
+double getBrightnessFromSensor(double sensorSmoothed, int dimDark, int dimBright, double sensorFactor) {
+  double sensorSmoothedResult = sensorSmoothed - dimDark;
+  if (sensorSmoothedResult < dimDark) sensorSmoothedResult = dimDark;
+  if (sensorSmoothedResult > dimBright) sensorSmoothedResult = dimBright;
+  return (sensorSmoothedResult - dimDark) * sensorFactor;
+}
+
+// ************************************************************
+// How long a digit slot has to be this frame. A full slot is
+// dispCount ticks plus its share of the dark time outside the
+// digit loops (slotOverhead). When we cut the slot, every time
+// in it shrinks by (slotCount + overhead) / (dispCount +
+// overhead), so each digit keeps the same share of the frame.
+// The slot has to hold the shrunk on time of the brightest
+// digit (onMax), the anti-ghost gap after it and the tick
+// where the anode goes off. We don't go below the dark time
+// each slot carries: past that the refresh rate gains little
+// and the slot runs out of ticks for the fades.
+//
+// Returns dispCount when cutting the slot gives nothing back.
+// ************************************************************
+int getSlotCount(int dispCount, int onMax, int slotOverhead, byte antiGhost) {
+  long fullSlot = dispCount + slotOverhead;
+  long neededSlot = dispCount;
+  if (onMax < fullSlot) {
+    neededSlot = ((long) onMax * slotOverhead + (long) (antiGhost + 1) * fullSlot + (fullSlot - onMax - 1)) / (fullSlot - onMax);
+  }
+  if (neededSlot < FRAME_SLOT_MIN) neededSlot = FRAME_SLOT_MIN;
+  if (neededSlot < slotOverhead) neededSlot = slotOverhead;
+
+  return (neededSlot < dispCount) ? neededSlot : dispCount;
+}
+
+// ************************************************************
+// Sigma-delta dither: add up the fractions of a tick we can't
+// show, and show an extra tick in each frame where they reach a
+// whole one. offCountFine is in 1/DITHER_SCALE ticks. A cut
+// slot shrinks the on time, so the error is kept in the finer
+// 1/SLOT_DITHER_SCALE steps.
+// ************************************************************
+int ditherOffCount(long offCountFine, float slotScale, unsigned int& ditherError) {
+  long slotOffCountFine = offCountFine * slotScale * (SLOT_DITHER_SCALE / DITHER_SCALE);
+  int ditheredOffCount = slotOffCountFine >> SLOT_DITHER_SHIFT;
+  ditherError += (slotOffCountFine & SLOT_DITHER_MASK);
+  if (ditherError >= SLOT_DITHER_SCALE) {
+    ditherError -= SLOT_DITHER_SCALE;
+    ditheredOffCount++;
+  }
+  return ditheredOffCount;
+}
+
+// ************************************************************
+// One frame of a digit's cross fade. fadeState counts down the
+// frames left, 0 when the digit is not fading; changed is if the
+// digit has a new value to fade to. Each impression we show 1
+// fade step less of the old digit and 1 fade step more of the
+// new. Returns the tick in the slot where we switch to the new
+// digit. The fade is over when fadeState gets back to 0.
+// ************************************************************
+int stepFade(byte& fadeState, boolean changed, int fadeSteps, float fadeStep, float slotScale) {
+  int digitSwitchTime = DIGIT_DISPLAY_COUNT * slotScale;
+
+  if (changed && (fadeState == 0)) {
+    // Start the fade
+    fadeState = fadeSteps;
+  }
+
+  if (fadeState == 1) {
+    // finish the fade
+    fadeState = 0;
+  } else if (fadeState > 1) {
+    // Continue the fade
+    fadeState = fadeState - 1;
+    digitSwitchTime = (int) (fadeState * fadeStep * slotScale);
+  }
+
+  return digitSwitchTime;
+}
+
+// ************************************************************
+// Colour cycling 3: one colour dominates. Every cycleSpeed
+// frames, move one step towards a colour picked at random, for
+// a random number of steps.
+// ************************************************************
+void cycleColours3(int colors[3], ColourCycle& cycle, byte cycleSpeed) {
+  cycle.count++;
+  if (cycle.count > cycleSpeed) {
+    cycle.count = 0;
+
+    if (cycle.changeSteps == 0) {
+      cycle.changeSteps = random(256);
+      cycle.colour = random(3);
+    }
+
+    cycle.changeSteps--;
+
+    // Brighten the dominant colour, and fade the other two
+    byte up = cycle.colour;
+    if (colors[up] < 255) {
+      colors[up]++;
+      for (byte i = 0 ; i < 3 ; i++) {
+        if ((i != up) && (colors[i] > 0)) {
+          colors[i]--;
+        }
+      }
+    } else {
+      cycle.changeSteps = 0;
+    }
+  }
+}
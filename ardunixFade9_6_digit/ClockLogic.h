@@ -0,0 +1,44 @@
+#ifndef ClockLogic_h
+#define ClockLogic_h
+
+#include "Arduino.h"
+#include "DisplayDefs.h"
+
+// Pure calculations used by the clock. Nothing in here touches the
+// hardware or the clock globals: everything comes in as parameters, so
+// these can be built and checked away from the board.
+
+// Day blanking modes
+#define DAY_BLANKING_MIN                0
+#define DAY_BLANKING_NEVER              0  // Don't blank ever (default)
+#define DAY_BLANKING_WEEKEND            1  // Blank during the weekend
+#define DAY_BLANKING_WEEKDAY            2  // Blank during weekdays
+#define DAY_BLANKING_ALWAYS             3  // Always blank
+#define DAY_BLANKING_HOURS              4  // Blank between start and end hour every day
+#define DAY_BLANKING_WEEKEND_OR_HOURS   5  // Blank between start and end hour during the week AND all day on the weekend
+#define DAY_BLANKING_WEEKDAY_OR_HOURS   6  // Blank between start and end hour during the weekends AND all day on week days
+#define DAY_BLANKING_WEEKEND_AND_HOURS  7  // Blank between start and end hour during the weekend
+#define DAY_BLANKING_WEEKDAY_AND_HOURS  8  // Blank between start and end hour during week days
+#define DAY_BLANKING_MAX                8
+#define DAY_BLANKING_DEFAULT            0
+
+boolean isHoursBlanked(byte hourNow, byte blankHourStart, byte blankHourEnd);
+boolean isDayBlanked(byte dayBlanking, byte weekdayNow, boolean hoursBlanked);
+double smoothSensorReading(double smoothed, int rawValue, int smoothCount);
+double getBrightnessFromSensor(double sensorSmoothed, int dimDark, int dimBright, double sensorFactor);
+
+// Display frame
+int getSlotCount(int dispCount, int onMax, int slotOverhead, byte antiGhost);
+int ditherOffCount(long offCountFine, float slotScale, unsigned int& ditherError);
+int stepFade(byte& fadeState, boolean changed, int fadeSteps, float fadeStep, float slotScale);
+
+// Back light colour cycling
+struct ColourCycle {
+  byte count;         // frames since the last step
+  int changeSteps;    // steps left towards the current colour
+  byte colour;        // the colour we are moving towards
+};
+
+void cycleColours3(int colors[3], ColourCycle& cycle, byte cycleSpeed);
+
+#endif
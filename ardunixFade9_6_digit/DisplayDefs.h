@@ -9,6 +9,30 @@
 #define BLINK    4
 #define SCROLL   5
 #define BRIGHT   6
+#define ROLL     7
+
+// Ticks of the multiplexing loop in a digit's slot
+#define DIGIT_DISPLAY_COUNT   1000 // The number of times to traverse inner fade loop per digit
+#define DIGIT_DISPLAY_ON      0    // Switch on the digit at the beginning by default
+#define DIGIT_DISPLAY_OFF     999  // Switch off the digit at the end by default
+#define DIGIT_DISPLAY_NEVER   -1   // When we don't want to switch on or off (i.e. blanking)
+
+// The brightness is worked out in fractions of a tick. The whole ticks are
+// displayed and the fraction is dithered over the following frames.
+#define DITHER_SHIFT          4    // 1/16 tick resolution
+#define DITHER_SCALE          (1 << DITHER_SHIFT)
+#define DITHER_MASK           (DITHER_SCALE - 1)
+#define SLOT_DITHER_SHIFT     12   // the cut slot is dithered in 1/4096 ticks, so cutting it keeps the 1/16 tick steps
+#define SLOT_DITHER_SCALE     (1L << SLOT_DITHER_SHIFT)
+#define SLOT_DITHER_MASK      (SLOT_DITHER_SCALE - 1)
+
+#define FRAME_SLOT_MIN        100  // shortest digit slot in ticks, so the fades keep some steps
+
+// Called once per tick of the digit multiplexing loop. Nothing on the clock,
+// the host build uses it to follow what the tubes show.
+#ifndef DISPLAY_TICK
+#define DISPLAY_TICK()
+#endif
 
 #endif
 
@@ -0,0 +1,19 @@
+#ifndef EventDefs_h
+#define EventDefs_h
+
+// Events, each raised once when it happens
+#define EVENT_SECOND                   0  // the time moved on to a new second
+#define EVENT_MINUTE                   1  // the time moved on to a new minute
+#define EVENT_MODE_ENTERED             2  // currentMode changed
+#define EVENT_TIME_SYNC                3  // we got the time from the WiFi module or the RTC
+#define EVENT_DIGIT_CHANGED            4  // a digit on the tubes started on its way to a new value, see eventDigit
+
+// Subscriber table entry. The table is in PROGMEM, so it costs no RAM.
+typedef void (*EventHandler)();
+
+typedef struct {
+  byte event;
+  EventHandler handler;
+} EventSubscriber;
+
+#endif
@@ -26,8 +26,194 @@
 #define I2C_SET_OPTION_BLANK_MODE      0x14
 #define I2C_SET_OPTION_SLOTS_MODE      0x15
 #define I2C_SET_OPTION_MIN_DIM         0x16
+#define I2C_GET_CAPABILITIES           0x17
+#define I2C_GET_STATUS                 0x18
+#define I2C_RTC_TIME_UPDATE            0x19
+#define I2C_GET_TIME                   0x1a
+#define I2C_SET_ALARM                  0x1b
+#define I2C_GET_ALARMS                 0x1c
+#define I2C_TIMER_CONTROL              0x1d
+#define I2C_SET_COUNTDOWN              0x1e
+#define I2C_SET_OPTION_ROLL_MODE       0x1f
+#define I2C_REJUV_CONTROL              0x20
+#define I2C_GET_REJUV                  0x21
+#define I2C_RUN_SELF_TEST              0x22
+#define I2C_GET_SELF_TEST              0x23
+#define I2C_GET_BOOT_TIMES             0x24
+#define I2C_GET_TELEMETRY              0x25
+#define I2C_SET_OPTIONS                0x26
 
-#define I2C_DATA_SIZE                  22
-#define I2C_PROTOCOL_NUMBER            54
+// Capability handshake: the master writes I2C_GET_CAPABILITIES followed by
+// its own capability bits, then reads back I2C_CAPS_SIZE bytes:
+// the echoed opcode, the protocol number and the clock capability bits.
+// The echo lets the master spot older clocks, which answer any read with
+// the option block.
+#define I2C_CAP_FAST_MODE              0x01  // 400kHz bus clock supported
+#define I2C_CAP_STATUS                 0x02  // option writes can be confirmed with I2C_GET_STATUS
+#define I2C_CAP_RTC_PROXY              0x04  // the master does all RTC traffic for the clock
+#define I2C_CAPS_SIZE                  3
+
+// Status block: the master writes I2C_GET_STATUS, then reads back
+// I2C_STATUS_SIZE bytes. Every option write bumps the received sequence
+// number, the applied one catches up once the clock has saved it.
+// The shadow version lets the master check that blocks it read one
+// after the other belong together.
+#define I2C_STAT_OPCODE                0     // echo of I2C_GET_STATUS
+#define I2C_STAT_RECEIVED_SEQ          1
+#define I2C_STAT_APPLIED_SEQ           2
+#define I2C_STAT_FLAGS                 3
+#define I2C_STAT_SHADOW_VERSION        4     // changes whenever the option or alarm blocks change
+#define I2C_STATUS_SIZE                5
+
+#define I2C_STATUS_BUSY                0x01  // an option write is waiting to be saved
+#define I2C_STATUS_TIME_SET            0x02  // time set on the clock, collect it with I2C_GET_TIME
+
+// RTC proxy: the master reads the RTC and sends I2C_RTC_TIME_UPDATE with
+// the 2 digit year, month, day, hours, minutes, seconds and the RTC
+// temperature in 1/4 degrees (high byte first). When the time is set on
+// the clock, the master reads it back with I2C_GET_TIME: the echoed
+// opcode followed by the same six time fields.
+#define I2C_TIME_SIZE                  7
+
+// Alarms: I2C_SET_ALARM is followed by the alarm number and its
+// I2C_ALARM_SIZE bytes: hour, minute, day mask and action bits.
+// I2C_GET_ALARMS reads back the echoed opcode and then all alarms.
+// Day mask bit 0 is Sunday ... bit 6 Saturday, no days = alarm off.
+#define I2C_ALARM_COUNT                4
+#define I2C_ALARM_SIZE                 4
+#define I2C_ALARMS_SIZE                (1 + I2C_ALARM_COUNT * I2C_ALARM_SIZE)
+
+#define I2C_ALARM_ACTION_UNBLANK       0x01  // switch the display on
+#define I2C_ALARM_ACTION_FLASH         0x02  // flash the back lights
+#define I2C_ALARM_ACTION_EFFECT        0x04  // run the slot machine effect
+
+// Stopwatch and countdown: I2C_TIMER_CONTROL is followed by the timer
+// and a command. I2C_SET_COUNTDOWN is followed by the countdown minutes
+// and seconds, and loads them if the countdown isn't running.
+#define I2C_TIMER_STOPWATCH            0
+#define I2C_TIMER_COUNTDOWN            1
+
+#define I2C_TIMER_CMD_START            0x01
+#define I2C_TIMER_CMD_STOP             0x02
+#define I2C_TIMER_CMD_RESET            0x03
+
+// Cathode rejuvenation: I2C_REJUV_CONTROL is followed by a command. Start
+// is followed by the program: the tube mask (bit 0 = digit 0), the cathode
+// mask high and low bytes (bit 0 = cathode 0), the duty in percent and the
+// minutes to spend on each cathode. The program only burns while the tubes
+// are blanked, and picks up where it was after a power cut.
+// I2C_GET_REJUV reads back I2C_REJUV_SIZE bytes of progress.
+#define I2C_REJUV_CMD_START            0x01
+#define I2C_REJUV_CMD_PAUSE            0x02
+#define I2C_REJUV_CMD_RESUME           0x03
+#define I2C_REJUV_CMD_CANCEL           0x04
+
+#define I2C_REJUV_STATE_IDLE           0     // no program
+#define I2C_REJUV_STATE_WAITING        1     // waiting for the tubes to be blanked
+#define I2C_REJUV_STATE_BURNING        2
+#define I2C_REJUV_STATE_PAUSED         3
+#define I2C_REJUV_STATE_DONE           4
+
+#define I2C_REJUV_OPCODE               0     // echo of I2C_GET_REJUV
+#define I2C_REJUV_STATE                1
+#define I2C_REJUV_TUBE                 2     // the digit we are on
+#define I2C_REJUV_CATHODE              3     // and its cathode
+#define I2C_REJUV_STEP_MINS            4     // minutes done on this cathode
+#define I2C_REJUV_STEPS_DONE           5
+#define I2C_REJUV_STEPS_TOTAL          6
+#define I2C_REJUV_SAG                  7     // worst HV sag on this cathode in volts
+#define I2C_REJUV_SAG_SKIPS            8     // cathodes cut short because the HV sagged
+#define I2C_REJUV_SIZE                 9
+
+// Self test: I2C_RUN_SELF_TEST starts it on the clock, which takes about
+// 2 seconds and shows the failed check bits on the tubes. I2C_GET_SELF_TEST
+// reads back I2C_SELF_TEST_SIZE bytes of the last result. Until a test has
+// run, the status byte is 0.
+#define I2C_SELF_TEST_OPCODE           0     // echo of I2C_GET_SELF_TEST
+#define I2C_SELF_TEST_STATUS           1     // I2C_SELF_TEST_RAN, I2C_SELF_TEST_RTC_SKIPPED
+#define I2C_SELF_TEST_FAILED           2     // I2C_SELF_TEST_* bits of the checks that failed
+#define I2C_SELF_TEST_ANODES           3     // anodes that pulled the HV down, bit 0 = digit 0
+#define I2C_SELF_TEST_CATHODES_HI      4     // cathodes that pulled the HV down, bit 0 = cathode 0
+#define I2C_SELF_TEST_CATHODES_LO      5
+#define I2C_SELF_TEST_SAG              6     // worst HV sag under one digit in volts
+#define I2C_SELF_TEST_LEDS_FAILED      7     // bit 0 red, 1 green, 2 blue, 3 tick
+#define I2C_SELF_TEST_LDR_HI           8     // raw LDR reading
+#define I2C_SELF_TEST_LDR_LO           9
+#define I2C_SELF_TEST_SIZE             10
+
+#define I2C_SELF_TEST_RAN              0x01
+#define I2C_SELF_TEST_RTC_SKIPPED      0x02  // RTC proxy: the RTC is not on the clock
+
+#define I2C_SELF_TEST_HV               0x01
+#define I2C_SELF_TEST_LEDS             0x02
+#define I2C_SELF_TEST_RTC              0x04
+#define I2C_SELF_TEST_LDR              0x08
+#define I2C_SELF_TEST_EEPROM           0x10
+
+// Boot timeline: I2C_GET_BOOT_TIMES reads back I2C_BOOT_SIZE bytes: the
+// echoed opcode, then for each stage the ms from reset it was reached
+// (high byte first), 0 = not reached yet.
+#define I2C_BOOT_STAGE_HV_ON           0     // HV generator started with the saved PWM profile
+#define I2C_BOOT_STAGE_TIME            1     // the clock has a time (RTC read or our own)
+#define I2C_BOOT_STAGE_SETUP_DONE      2
+#define I2C_BOOT_STAGE_FIRST_FRAME     3     // first frame with the tubes lit
+#define I2C_BOOT_STAGE_HV_READY        4     // HV reached its target voltage
+#define I2C_BOOT_STAGE_COUNT           5
+#define I2C_BOOT_FIRST_STAGE           1
+#define I2C_BOOT_SIZE                  (I2C_BOOT_FIRST_STAGE + I2C_BOOT_STAGE_COUNT * 2)
+
+// Telemetry: I2C_GET_TELEMETRY reads back I2C_TELEM_SIZE bytes, rebuilt
+// by the clock once a second.
+#define I2C_TELEM_OPCODE               0     // echo of I2C_GET_TELEMETRY
+#define I2C_TELEM_HV_HI                1     // measured HV in volts
+#define I2C_TELEM_HV_LO                2
+#define I2C_TELEM_BRIGHTNESS           3     // digit on time in percent
+#define I2C_TELEM_IMPR_HI              4     // impressions per second
+#define I2C_TELEM_IMPR_LO              5
+#define I2C_TELEM_FLAGS                6
+#define I2C_TELEM_SIZE                 7
+
+#define I2C_TELEM_BLANKED              0x01  // tubes are blanked
+#define I2C_TELEM_RTC                  0x02  // the clock has an RTC time
+#define I2C_TELEM_WIFI_TIME            0x04  // the clock got the time from us recently
+
+// Batched option write: I2C_SET_OPTIONS is followed by a whole option
+// block (I2C_DATA_SIZE bytes, laid out as below). The clock applies it
+// as one write and saves it in one pass, so it counts once in the status
+// sequence numbers. Blocks with a different I2C_OPT_PROTOCOL are ignored.
+
+#define I2C_SPEED_STANDARD             100000L
+#define I2C_SPEED_FAST                 400000L
+
+// Layout of the option block returned by the clock. Both the clock
+// (requestEvent) and the WiFi module (getClockOptionsFromI2C) index
+// the block with these. Each sketch has its own copy of this file, so
+// edit both: "make -C test i2cdefs" fails if they differ.
+#define I2C_OPT_PROTOCOL               0
+#define I2C_OPT_12_24                  1
+#define I2C_OPT_BLANK_LEAD             2
+#define I2C_OPT_SCROLLBACK             3
+#define I2C_OPT_SUPPRESS_ACP           4
+#define I2C_OPT_FADE                   5
+#define I2C_OPT_DATE_FORMAT            6
+#define I2C_OPT_DAY_BLANKING           7
+#define I2C_OPT_BLANK_START            8
+#define I2C_OPT_BLANK_END              9
+#define I2C_OPT_FADE_STEPS             10
+#define I2C_OPT_SCROLL_STEPS           11
+#define I2C_OPT_BACKLIGHT_MODE         12
+#define I2C_OPT_RED_CHANNEL            13
+#define I2C_OPT_GREEN_CHANNEL          14
+#define I2C_OPT_BLUE_CHANNEL           15
+#define I2C_OPT_CYCLE_SPEED            16
+#define I2C_OPT_USE_LDR                17
+#define I2C_OPT_BLANK_MODE             18
+#define I2C_OPT_SLOTS_MODE             19
+#define I2C_OPT_MIN_DIM_HI             20
+#define I2C_OPT_MIN_DIM_LO             21
+#define I2C_OPT_ROLL_MODE              22
+
+#define I2C_DATA_SIZE                  23
+#define I2C_PROTOCOL_NUMBER            60
 
 #endif
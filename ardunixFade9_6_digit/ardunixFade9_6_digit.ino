@@ -28,8 +28,10 @@
 // Other parts of the code, broken out for clarity
 #include "ClockButton.h"
 #include "Transition.h"
+#include "ClockLogic.h"
 #include "DisplayDefs.h"
 #include "I2CDefs.h"
+#include "EventDefs.h"
 
 //**********************************************************************************
 //**********************************************************************************
@@ -72,21 +74,36 @@
 #define EE_USE_LDR            34     // if we use the LDR or not (if we don't use the LDR, it has 100% brightness
 #define EE_BLANK_MODE         35     // blank tubes, or LEDs or both
 #define EE_SLOTS_MODE         36     // Show date every now and again
+#define EE_RTC_AGING          37     // DS3231 aging offset, trimmed against the WiFi time
+#define EE_ALARM_BASE         38     // ALARM_COUNT alarms of EE_ALARM_SIZE bytes: hour, minute, day mask, action
+#define EE_ALARM_SIZE         4
+#define EE_SUB_SLOTS          54     // how many pieces we split each digit's on time into
+#define EE_ROLL_MODE          55     // roll changed digits through the values in between: off, up or down
+#define EE_REJUV_STATE        56     // cathode rejuvenation program: idle, waiting, paused or done
+#define EE_REJUV_TUBES        57     // the tubes in the program, bit 0 = digit 0
+#define EE_REJUV_CATHODES_LO  58     // the cathodes in the program, bit 0 = cathode 0
+#define EE_REJUV_CATHODES_HI  59
+#define EE_REJUV_DUTY         60     // percent of the time the cathode is on
+#define EE_REJUV_STEP_MINS    61     // minutes to spend on each cathode
+#define EE_REJUV_STEP         62     // checkpoint: the step we are on, digit * 10 + cathode
+#define EE_REJUV_STEP_DONE    63     // checkpoint: minutes done on that step
+#define EE_REJUV_SAG_SKIPS    64     // checkpoint: steps cut short because the HV sagged
+#define EE_SELF_TEST          65     // scratch byte the self test writes and reads back
+#define EE_RTC_AGING_VALID    66     // RTC_AGING_VALID once EE_RTC_AGING holds an offset we saved
 
 // Software version shown in config menu
-#define SOFTWARE_VERSION      54
+#define SOFTWARE_VERSION      60
 
 // how often we make reference to the external time provider
 #define READ_TIME_PROVIDER_MILLIS 60000 // Update the internal time provider from the external source once every minute
 
-// Display handling
-#define DIGIT_DISPLAY_COUNT   1000 // The number of times to traverse inner fade loop per digit
-#define DIGIT_DISPLAY_ON      0    // Switch on the digit at the beginning by default
-#define DIGIT_DISPLAY_OFF     999  // Switch off the digit at the end by default
-#define DIGIT_DISPLAY_NEVER   -1   // When we don't want to switch on or off (i.e. blanking)
+// Display handling: the tick counts and the dither are in DisplayDefs.h
 #define DISPLAY_COUNT_MAX     2000 // Maximum value we can set to
 #define DISPLAY_COUNT_MIN     500  // Minimum value we can set to
 
+#define FRAME_OVERHEAD_DEFAULT 100 // dark ticks per slot outside the digit loops, until we have measured them
+#define FRAME_GAP_MAX_MICROS  10000 // a longer gap between frames is not the normal loop, don't measure it
+
 #define MIN_DIM_DEFAULT       100  // The default minimum dim count
 #define MIN_DIM_MIN           100  // The minimum dim count
 #define MIN_DIM_MAX           500  // The maximum dim count
@@ -143,70 +160,78 @@
 #define MODE_MIN                        0
 #define MODE_TIME                       0
 
+// Stopwatch and countdown timer, minutes, seconds and 1/100 seconds
+#define MODE_STOPWATCH                  1
+#define MODE_COUNTDOWN                  2
+
 // Time setting, need all six digits, so no flashing mode indicator
-#define MODE_HOURS_SET                  1
-#define MODE_MINS_SET                   2
-#define MODE_SECS_SET                   3
-#define MODE_DAYS_SET                   4
-#define MODE_MONTHS_SET                 5
-#define MODE_YEARS_SET                  6
+#define MODE_HOURS_SET                  3
+#define MODE_MINS_SET                   4
+#define MODE_SECS_SET                   5
+#define MODE_DAYS_SET                   6
+#define MODE_MONTHS_SET                 7
+#define MODE_YEARS_SET                  8
 
 // Basic settings
-#define MODE_12_24                      7  // Mode "00" 0 = 24, 1 = 12
+#define MODE_12_24                      9  // Mode "00" 0 = 24, 1 = 12
 #define HOUR_MODE_DEFAULT               false
-#define MODE_LEAD_BLANK                 8  // Mode "01" 1 = blanked
+#define MODE_LEAD_BLANK                 10 // Mode "01" 1 = blanked
 #define LEAD_BLANK_DEFAULT              false
-#define MODE_SCROLLBACK                 9  // Mode "02" 1 = use scrollback
+#define MODE_SCROLLBACK                 11 // Mode "02" 1 = use scrollback
 #define SCROLLBACK_DEFAULT              false
-#define MODE_FADE                       10 // Mode "03" 1 = use fade
+#define MODE_FADE                       12 // Mode "03" 1 = use fade
 #define FADE_DEFAULT                    false
-#define MODE_DATE_FORMAT                11 // Mode "04"
-#define MODE_DAY_BLANKING               12 // Mode "05"
-#define MODE_HR_BLNK_START              13 // Mode "06" - skipped if not using hour blanking
-#define MODE_HR_BLNK_END                14 // Mode "07" - skipped if not using hour blanking
-#define MODE_SUPPRESS_ACP               15 // Mode "08" 1 = suppress ACP when fully dimmed
+#define MODE_DATE_FORMAT                13 // Mode "04"
+#define MODE_DAY_BLANKING               14 // Mode "05"
+#define MODE_HR_BLNK_START              15 // Mode "06" - skipped if not using hour blanking
+#define MODE_HR_BLNK_END                16 // Mode "07" - skipped if not using hour blanking
+#define MODE_SUPPRESS_ACP               17 // Mode "08" 1 = suppress ACP when fully dimmed
 #define SUPPRESS_ACP_DEFAULT            true
-#define MODE_USE_LDR                    16 // Mode "09" 1 = use LDR, 0 = don't (and have 100% brightness)
+#define MODE_USE_LDR                    18 // Mode "09" 1 = use LDR, 0 = don't (and have 100% brightness)
 #define MODE_USE_LDR_DEFAULT            true
-#define MODE_BLANK_MODE                 17 // Mode "10" 
+#define MODE_BLANK_MODE                 19 // Mode "10" 
 #define MODE_BLANK_MODE_DEFAULT         BLANK_MODE_BOTH
 
 // Display tricks
-#define MODE_FADE_STEPS_UP              18 // Mode "11"
-#define MODE_FADE_STEPS_DOWN            19 // Mode "12"
-#define MODE_DISPLAY_SCROLL_STEPS_UP    20 // Mode "13"
-#define MODE_DISPLAY_SCROLL_STEPS_DOWN  21 // Mode "14"
-#define MODE_SLOTS_MODE                 22 // Mode "15"
+#define MODE_FADE_STEPS_UP              20 // Mode "11"
+#define MODE_FADE_STEPS_DOWN            21 // Mode "12"
+#define MODE_DISPLAY_SCROLL_STEPS_UP    22 // Mode "13"
+#define MODE_DISPLAY_SCROLL_STEPS_DOWN  23 // Mode "14"
+#define MODE_SLOTS_MODE                 24 // Mode "15"
 
 // Back light
-#define MODE_BACKLIGHT_MODE             23 // Mode "16"
-#define MODE_RED_CNL                    24 // Mode "17"
-#define MODE_GRN_CNL                    25 // Mode "18"
-#define MODE_BLU_CNL                    26 // Mode "19"
-#define MODE_CYCLE_SPEED                27 // Mode "20" - speed the colour cycle cyles at
+#define MODE_BACKLIGHT_MODE             25 // Mode "16"
+#define MODE_RED_CNL                    26 // Mode "17"
+#define MODE_GRN_CNL                    27 // Mode "18"
+#define MODE_BLU_CNL                    28 // Mode "19"
+#define MODE_CYCLE_SPEED                29 // Mode "20" - speed the colour cycle cyles at
 
 // HV generation
-#define MODE_TARGET_HV_UP               28 // Mode "21"
-#define MODE_TARGET_HV_DOWN             29 // Mode "22"
-#define MODE_PULSE_UP                   30 // Mode "23"
-#define MODE_PULSE_DOWN                 31 // Mode "24"
+#define MODE_TARGET_HV_UP               30 // Mode "21"
+#define MODE_TARGET_HV_DOWN             31 // Mode "22"
+#define MODE_PULSE_UP                   32 // Mode "23"
+#define MODE_PULSE_DOWN                 33 // Mode "24"
+
+#define MODE_MIN_DIM_UP                 34 // Mode "25"
+#define MODE_MIN_DIM_DOWN               35 // Mode "26"
+
+#define MODE_ANTI_GHOST_UP              36 // Mode "27"
+#define MODE_ANTI_GHOST_DOWN            37 // Mode "28"
 
-#define MODE_MIN_DIM_UP                 32 // Mode "25"
-#define MODE_MIN_DIM_DOWN               33 // Mode "26"
+#define MODE_SUB_SLOTS                  38 // Mode "29" 1 = each digit in one piece
 
-#define MODE_ANTI_GHOST_UP              34 // Mode "27"
-#define MODE_ANTI_GHOST_DOWN            35 // Mode "28"
+#define MODE_ROLL_MODE                  39 // Mode "30" 0 = off, 1 = roll up, 2 = roll down
 
 // Temperature
-#define MODE_TEMP                       36 // Mode "29"
+#define MODE_TEMP                       40 // Mode "31"
 
 // Software Version
-#define MODE_VERSION                    37 // Mode "30"
+#define MODE_VERSION                    41 // Mode "32"
 
 // Tube test - all six digits, so no flashing mode indicator
-#define MODE_TUBE_TEST                  38
+#define MODE_TUBE_TEST                  42
 
-#define MODE_MAX                        38
+#define MODE_MAX                        42
 
 // Pseudo mode - burn the tubes and nothing else
 #define MODE_DIGIT_BURN                 99 // Digit burn mode - accesible by super long press
@@ -220,7 +245,8 @@
 #define TEMP_IP_ADDR12                  4 // IP xxx.yyy.zzz.aaa: xxx.yyy
 #define TEMP_IP_ADDR34                  5 // IP xxx.yyy.zzz.aaa: zzz.aaa
 #define TEMP_IMPR                       6 // number of impressions per second
-#define TEMP_MODE_MAX                   6
+#define TEMP_SELF_TEST                  7 // result of the last self test: failed checks, 0 = pass
+#define TEMP_MODE_MAX                   7
 
 #define DATE_FORMAT_MIN                 0
 #define DATE_FORMAT_YYMMDD              0
@@ -229,18 +255,7 @@
 #define DATE_FORMAT_MAX                 2
 #define DATE_FORMAT_DEFAULT             2
 
-#define DAY_BLANKING_MIN                0
-#define DAY_BLANKING_NEVER              0  // Don't blank ever (default)
-#define DAY_BLANKING_WEEKEND            1  // Blank during the weekend
-#define DAY_BLANKING_WEEKDAY            2  // Blank during weekdays
-#define DAY_BLANKING_ALWAYS             3  // Always blank
-#define DAY_BLANKING_HOURS              4  // Blank between start and end hour every day
-#define DAY_BLANKING_WEEKEND_OR_HOURS   5  // Blank between start and end hour during the week AND all day on the weekend
-#define DAY_BLANKING_WEEKDAY_OR_HOURS   6  // Blank between start and end hour during the weekends AND all day on week days
-#define DAY_BLANKING_WEEKEND_AND_HOURS  7  // Blank between start and end hour during the weekend
-#define DAY_BLANKING_WEEKDAY_AND_HOURS  8  // Blank between start and end hour during week days
-#define DAY_BLANKING_MAX                8
-#define DAY_BLANKING_DEFAULT            0
+// Day blanking modes are in ClockLogic.h
 
 #define BLANK_MODE_MIN                  0
 #define BLANK_MODE_TUBES                0  // Use blanking for tubes only 
@@ -267,6 +282,44 @@
 #define ANTI_GHOST_MAX                  50
 #define ANTI_GHOST_DEFAULT              0
 
+#define SUB_SLOTS_MIN                   1
+#define SUB_SLOTS_MAX                   3
+#define SUB_SLOTS_DEFAULT               1
+
+#define ROLL_MODE_MIN                   0
+#define ROLL_MODE_OFF                   0   // Digits change the normal way (fade or scrollback)
+#define ROLL_MODE_UP                    1   // Count up through the values in between
+#define ROLL_MODE_DOWN                  2   // Count down through the values in between
+#define ROLL_MODE_MAX                   2
+#define ROLL_MODE_DEFAULT               0
+
+// How long a roll takes, however many values it goes through
+#define ROLL_DURATION_MS                400
+
+// Cathode rejuvenation. A program steps through every selected
+// cathode of every selected tube, one at a time, while the tubes
+// are blanked.
+#define REJUV_STEPS                     60  // 6 tubes of 10 cathodes
+#define REJUV_DUTY_MIN                  10
+#define REJUV_DUTY_MAX                  100
+#define REJUV_DUTY_DEFAULT              50
+#define REJUV_STEP_MINS_MIN             1
+#define REJUV_STEP_MINS_MAX             240
+#define REJUV_STEP_MINS_DEFAULT         30
+#define REJUV_CHECKPOINT_MINS           5   // how often we save the progress through a step
+#define REJUV_SETTLE_MS                 5000 // give the HV time to settle before we look for sag
+#define REJUV_SAG_LIMIT_V               20  // cut a step short if the HV sags this far below target
+#define REJUV_SAG_LIMIT_RAW             ((int) (REJUV_SAG_LIMIT_V * 4.7 / 394.7 * 1023 / 5))
+
+// Self test
+#define SELF_TEST_SETTLE_MS             500 // let the HV regulation settle before we start
+#define SELF_TEST_STEP_MS               25  // how long we load the HV with each anode and cathode
+#define SELF_TEST_SAG_LIMIT_V           15  // more sag than this under one digit means a short
+#define SELF_TEST_SAG_LIMIT_RAW         ((int) (SELF_TEST_SAG_LIMIT_V * 4.7 / 394.7 * 1023 / 5))
+#define SELF_TEST_LDR_MIN               5   // readings this close to the rails mean the LDR is open or shorted
+#define SELF_TEST_LDR_MAX               1018
+#define SELF_TEST_DISPLAY_NUM           88  // shown on the right hand tubes with the result
+
 #define TEMP_DISPLAY_MODE_DUR_MS        5000
 
 #define USE_LDR_DEFAULT                 true
@@ -285,6 +338,31 @@
 
 #define MAX_WIFI_TIME                  5
 
+// RTC drift trimming. We only correct the RTC from the WiFi time once it is
+// more than RTC_DRIFT_MAX_SECS out, and use the corrections to trim the
+// aging offset
+#define RTC_DRIFT_MAX_SECS              1       // RTC error we allow before we correct it
+#define RTC_DRIFT_MIN_PERIOD_SECS       86400L  // history we need before we trim (1 day)
+#define RTC_DRIFT_STEP_SECS             60      // bigger errors are time changes, not drift
+#define RTC_AGING_MIN                   -127
+#define RTC_AGING_MAX                   127
+#define RTC_AGING_VALID                 0x5A    // anything else (erased EEPROM): use what the RTC has
+
+// Alarms
+#define ALARM_COUNT                     I2C_ALARM_COUNT
+#define ALARM_UNBLANK_MS                600000  // how long an alarm keeps the display on
+#define ALARM_FLASH_MS                  60000   // how long an alarm flashes the back lights
+#define ALARM_FLASH_PERIOD_MS           500
+#define ALARM_MAX_CHECK_GAP_SECS        120     // a bigger gap between checks means the time was changed
+
+// Stopwatch and countdown
+#define TIMER_STOPWATCH                 I2C_TIMER_STOPWATCH
+#define TIMER_COUNTDOWN                 I2C_TIMER_COUNTDOWN
+#define TIMER_COUNT                     2
+#define TIMER_US_PER_TICK               (64L * 256L * 1000000L / F_CPU) // one timer 0 cycle: 1024uS at 16MHz
+#define TIMER_US_PER_CENTISEC           10000
+#define COUNTDOWN_DEFAULT_MINS          5
+
 #define DO_NOT_APPLY_LEAD_0_BLANK     false
 #define APPLY_LEAD_0_BLANK            true
 
@@ -370,13 +448,33 @@ byte ourIP[4]          = {0, 0, 0, 0}; // set by the WiFi module
 // 100 is about 1 second
 int fadeSteps = FADE_STEPS_DEFAULT;
 int digitOffCount = DIGIT_DISPLAY_OFF;
+int digitOffCountFine = DIGIT_DISPLAY_OFF * DITHER_SCALE; // digitOffCount including the fraction, in 1/DITHER_SCALE ticks
+unsigned int ditherError = 0;                             // fraction of a tick carried into the next frame, in 1/SLOT_DITHER_SCALE ticks
+unsigned int slotOverhead8 = FRAME_OVERHEAD_DEFAULT * 8;  // running average of the dark ticks per slot outside the digit loops, x8
+unsigned long lastFrameMicros = 0;                        // when the last frame's digit loops finished
+unsigned long lastFrameLoopMicros = 0;                    // how long they took
+long lastFrameTicks = 0;                                  // and how many ticks they ran
 int scrollSteps = SCROLL_STEPS_DEFAULT;
 boolean scrollback = true;
 boolean fade = true;
 byte antiGhost = ANTI_GHOST_DEFAULT;
 int dispCount = DIGIT_DISPLAY_COUNT + antiGhost;
+byte subSlots = SUB_SLOTS_DEFAULT;
+byte rollMode = ROLL_MODE_DEFAULT;
+byte rollFrom[6]       = {0, 0, 0, 0, 0, 0};  // the value the roll started at
+byte rollSteps[6]      = {0, 0, 0, 0, 0, 0};  // how many values the roll goes through, 0 = not rolling
+byte rollNext[6]       = {0, 0, 0, 0, 0, 0};  // the value we cross fade into this frame
+unsigned long rollStartMillis[6];
+const byte interleavedScanOrder[6] = {0, 3, 1, 4, 2, 5};
 float fadeStep = DIGIT_DISPLAY_COUNT / fadeSteps;
 
+// What we last raised events for
+time_t lastEventTime = 0;
+byte lastEventMode = MODE_TIME;
+volatile boolean timeSyncReceived = false;  // set by the I2C interrupt, raised from the main loop
+byte digitsChanging = 0;                     // bit per digit that is on its way to a new value
+byte eventDigit = 0;                         // the digit an EVENT_DIGIT_CHANGED is about
+
 // For software blinking
 int blinkCounter = 0;
 boolean blinkState = true;
@@ -429,11 +527,79 @@ byte blankSuppressStep = 0;    // The press we are on: 1 press = suppress for 1
 unsigned long blankSuppressedMillis = 0;   // The end time of the blanking, 0 if we are not suppressed
 unsigned long blankSuppressedSelectionTimoutMillis = 0;   // Used for determining the end of the blanking period selection timeout
 boolean hourMode = false;
-boolean triggeredThisSec = false;
 
 byte useRTC = false;  // true if we detect an RTC
 byte useWiFi = 0; // the number of minutes ago we recevied information from the WiFi module, 0 = don't use WiFi
 
+// Clocks with a WiFi module can leave all RTC traffic to the module, which
+// then pushes the RTC time to us. The clock never leaves I2C slave mode.
+#define RTC_DIRECT // [RTC_DIRECT,RTC_PROXY]
+
+signed char rtcAgingOffset = 0;  // aging offset we have trimmed the RTC to
+boolean rtcAgingKnown = true;    // false until we have a saved offset or have read the RTC's
+time_t rtcDriftBaseline = 0;     // start of the current drift measurement, 0 = not started
+long rtcDriftSecs = 0;           // RTC error we have corrected since rtcDriftBaseline
+float rtcTemp = 0.0;             // last temperature read from the RTC (by us or the WiFi module)
+
+#ifdef RTC_PROXY
+volatile boolean rtcTimeSetPending = false;  // time was set here, waiting for the WiFi module to write it to the RTC
+#endif
+
+// ***************************** Boot timeline ***************************
+// Fast boot gets the HV going before anything else and goes straight to
+// the time, without showing the version first.
+#define FAST_BOOT // [FAST_BOOT,FULL_BOOT]
+
+// ms from reset to each I2C_BOOT_STAGE_*, in the layout the master reads
+byte bootTimeline[I2C_BOOT_SIZE] = {I2C_GET_BOOT_TIMES};
+
+// ******************************* Alarms ******************************
+byte alarmHour[ALARM_COUNT];
+byte alarmMinute[ALARM_COUNT];
+byte alarmDays[ALARM_COUNT];          // bit 0 = Sunday ... bit 6 = Saturday, 0 = alarm off
+byte alarmAction[ALARM_COUNT];        // I2C_ALARM_ACTION_* bits
+time_t nextAlarmTime = 0;             // when the next alarm is due, 0 = none
+byte nextAlarm = 0;                   // which alarm is due then
+time_t lastAlarmCheck = 0;
+volatile boolean alarmsChanged = false;
+boolean alarmFlashing = false;
+unsigned long alarmFlashStartMillis = 0;
+
+// ************************ Stopwatch and countdown ************************
+// The timer interrupt counts the digits directly, one digit per byte in the
+// same order as NumberArray (MMSScc), so showing them is just a copy
+volatile byte timerDigits[TIMER_COUNT][6];
+volatile boolean timerRunning[TIMER_COUNT] = {false, false};
+volatile unsigned int timerMicros[TIMER_COUNT] = {0, 0}; // time towards the next 1/100 second
+volatile boolean countdownExpired = false;
+boolean timerAtStart[TIMER_COUNT] = {true, true};         // the next button press starts the timer
+byte countdownPreset[6];                                   // where the countdown starts from
+const byte timerDigitMax[6] = {9, 9, 5, 9, 9, 9};
+
+// ************************ I2C bus handling ************************
+byte i2cReadBlock = I2C_GET_OPTIONS;  // what the next read from the master gets: set by the preceding command
+boolean i2cFastMode = false;          // true if the WiFi module has negotiated 400kHz with us
+volatile byte i2cOptionsReceived = 0; // sequence number of the last option write from the master
+byte i2cOptionsApplied = 0;           // sequence number of the last option write saved to EEPROM
+
+// What the master reads, built in the main loop so the I2C interrupt only has
+// to copy it out. Two of each: we build into the one the interrupt isn't using
+// and then swap, so it never sees a half built block.
+byte i2cOptionsShadow[2][I2C_DATA_SIZE];
+byte i2cAlarmsShadow[2][I2C_ALARMS_SIZE];
+volatile byte i2cShadowActive = 0;
+volatile byte i2cShadowVersion = 0;   // bumped on every rebuild, lets the master check reads belong together
+byte i2cRejuvShadow[2][I2C_REJUV_SIZE];
+volatile byte i2cRejuvShadowActive = 0;
+byte i2cSelfTestShadow[2][I2C_SELF_TEST_SIZE] = {{I2C_GET_SELF_TEST}, {I2C_GET_SELF_TEST}};
+volatile byte i2cSelfTestShadowActive = 0;
+byte i2cTelemetryShadow[2][I2C_TELEM_SIZE];
+volatile byte i2cTelemetryShadowActive = 0;
+#ifdef RTC_PROXY
+byte i2cTimeShadow[2][I2C_TIME_SIZE];
+volatile byte i2cTimeShadowActive = 0;
+#endif
+
 // **************************** LED management ***************************
 boolean upOrDown;
 
@@ -447,13 +613,11 @@ byte backlightMode = BACKLIGHT_DEFAULT;
 byte redCnl = COLOUR_RED_CNL_DEFAULT;
 byte grnCnl = COLOUR_GRN_CNL_DEFAULT;
 byte bluCnl = COLOUR_BLU_CNL_DEFAULT;
-byte cycleCount = 0;
 byte cycleSpeed = CYCLE_SPEED_DEFAULT;
 
 // Back light cycling
 int colors[3];
-int changeSteps = 0;
-byte currentColour = 0;
+ColourCycle colourCycle = {0, 0, 0};
 
 int impressionsPerSec = 0;
 int lastImpressionsPerSec = 0;
@@ -469,6 +633,24 @@ ClockButton button1(inputPin1, false);
 byte digitBurnDigit = 0;
 byte digitBurnValue = 0;
 
+// Cathode rejuvenation does the same as a scheduled program, in the
+// time the tubes are blanked anyway
+byte rejuvState = I2C_REJUV_STATE_IDLE;   // stored state, never I2C_REJUV_STATE_BURNING
+byte rejuvTubes = 0;
+unsigned int rejuvCathodes = 0;
+byte rejuvDuty = REJUV_DUTY_DEFAULT;
+byte rejuvStepMins = REJUV_STEP_MINS_DEFAULT;
+byte rejuvStep = 0;                       // digit * 10 + cathode
+byte rejuvStepDone = 0;                   // minutes done on this step
+byte rejuvSagSkips = 0;
+int rejuvWorstSag = 0;                    // in raw ADC counts
+boolean rejuvBurning = false;
+unsigned long rejuvBurnStartMillis = 0;
+
+// **************************** self test ****************************
+byte selfTestFailed = 0;                  // I2C_SELF_TEST_* bits of the checks that failed
+volatile boolean selfTestRequested = false;
+
 // ************************************************************
 // LED brightness correction: The perceived brightness is not linear
 // ************************************************************
@@ -554,6 +736,11 @@ void setup()
   TCCR2A = (1 << COM2B1) | (1 << WGM21) | (1 << WGM20);
   TCCR2B = (1 << CS22);
 
+  // Timer 0 runs millis(), its compare A interrupt drives the stopwatch.
+  // OCR0A is double buffered in PWM mode, so the red LED PWM on it doesn't
+  // change how often we get it: once per timer 0 cycle.
+  TIMSK0 |= (1 << OCIE0A);
+
   // we don't need the HV yet, so turn it off
   TCCR1A = tccrOff;
 
@@ -562,6 +749,8 @@ void setup()
 
   // **********************************************************************
 
+  setCountdown(COUNTDOWN_DEFAULT_MINS, 0);
+
   // Set up the PRNG with something so that it looks random
   randomSeed(analogRead(LDRPin));
 
@@ -586,6 +775,12 @@ void setup()
     EEPROM.write(EE_NEED_SETUP, true);
   }
 
+#ifdef FAST_BOOT
+  // The HV takes longest to come up, so start it as soon as we know we
+  // aren't flashing for a factory reset, and let it rise while we do the rest
+  startHVFromEEPROM();
+#endif
+
   // If the button is held down while we are flashing, then do the test pattern
   boolean doTestPattern = false;
 
@@ -606,23 +801,17 @@ void setup()
     doTestPattern = true;
   }
 
-  // Read EEPROM values
-  readEEPROMValues();
-
-  // set our PWM profile
-  setPWMOnTime(pwmOn);
-  setPWMTopTime(pwmTop);
-
-  // Set the target voltage
-  rawHVADCThreshold = getRawHVADCThreshold(hvTargetVoltage);
-
-  // HV GOOOO!!!!
-  TCCR1A = tccrOn;
+#ifndef FAST_BOOT
+  startHVFromEEPROM();
+#endif
 
   if (doTestPattern) {
     boolean oldUseLDR = useLDR;
     byte oldBacklightMode = backlightMode;
 
+    // Check the hardware before someone looks at the pattern
+    runSelfTest();
+
     // reset the EEPROM values
     factoryReset();
 
@@ -697,18 +886,85 @@ void setup()
   // initialise the internal time (in case we don't find the time provider)
   nowMillis = millis();
   setTime(12, 34, 56, 1, 3, 2017);
+#ifdef RTC_PROXY
+  // The WiFi module reads the RTC and pushes the time to us
+  startI2CSlave();
+#else
   getRTCTime();
+#endif
+  recordBootStage(I2C_BOOT_STAGE_TIME);
+
+  // The first minute event comes when the minute changes, not straight away
+  lastEventTime = now();
 
-  // Show the version for 1 s
-  tempDisplayMode = TEMP_MODE_VERSION;
-  tempDisplayModeDuration = TEMP_DISPLAY_MODE_DUR_MS;
+  // Show the version for 1 s, or the self test result if we just ran it
+  if (doTestPattern) {
+    tempDisplayMode = TEMP_SELF_TEST;
+    tempDisplayModeDuration = TEMP_DISPLAY_MODE_DUR_MS;
+  } else {
+#ifdef FAST_BOOT
+    // Straight to the time, with no fade in from 000000
+    loadNumberArrayTime();
+    for (byte i = 0 ; i < 6 ; i++) {
+      currNumberArray[i] = NumberArray[i];
+    }
+#else
+    tempDisplayMode = TEMP_MODE_VERSION;
+    tempDisplayModeDuration = TEMP_DISPLAY_MODE_DUR_MS;
+#endif
+  }
 
   // don't blank anything right now
   blanked = false;
   setTubesAndLEDSBlankMode();
 
-  // mark that we have done the EEPROM setup
-  EEPROM.write(EE_NEED_SETUP, false);
+  // mark that we have done the EEPROM setup, without the 3ms write if it is already done
+  EEPROM.update(EE_NEED_SETUP, false);
+
+  recordBootStage(I2C_BOOT_STAGE_SETUP_DONE);
+}
+
+// ************************************************************
+// Read the settings and start the HV generator with the PWM
+// profile we saved last time
+// ************************************************************
+void startHVFromEEPROM() {
+  readEEPROMValues();
+
+  // set our PWM profile
+  setPWMOnTime(pwmOn);
+  setPWMTopTime(pwmTop);
+
+  // Set the target voltage
+  rawHVADCThreshold = getRawHVADCThreshold(hvTargetVoltage);
+
+  // HV GOOOO!!!!
+  TCCR1A = tccrOn;
+  recordBootStage(I2C_BOOT_STAGE_HV_ON);
+}
+
+// ************************************************************
+// Note how long after reset we got to a boot stage. Only the
+// first time counts.
+// ************************************************************
+void recordBootStage(byte stage) {
+  byte idx = I2C_BOOT_FIRST_STAGE + stage * 2;
+  if ((bootTimeline[idx] != 0) || (bootTimeline[idx + 1] != 0)) {
+    return;
+  }
+
+  // The stage can't be 0ms, millis() only starts counting when timer 0 is set up
+  unsigned int stageMillis = millis();
+  if (stageMillis == 0) {
+    stageMillis = 1;
+  }
+
+  // Don't let the I2C interrupt see half of it
+  byte oldSREG = SREG;
+  cli();
+  bootTimeline[idx] = stageMillis / 256;
+  bootTimeline[idx + 1] = stageMillis % 256;
+  SREG = oldSREG;
 }
 
 //**********************************************************************************
@@ -731,17 +987,53 @@ void loop()
   if (abs(nowMillis - lastCheckMillis) >= 1000) {
     performOncePerSecondProcessing();
 
-    // we only want to once per minute processing to be called once each minute 
-    if ((second() == 0) && (!triggeredThisSec)) {
-      performOncePerMinuteProcessing();
-      triggeredThisSec = true;
+    lastCheckMillis = nowMillis;
+  }
+
+  // Time events, raised once on the edge. If the time was set back we
+  // only catch up with it: the minute it went back to has had its event.
+  time_t timeNow = now();
+  if (timeNow != lastEventTime) {
+    boolean newMinute = ((timeNow / SECS_PER_MIN) > (lastEventTime / SECS_PER_MIN));
+    lastEventTime = timeNow;
+
+    raiseEvent(EVENT_SECOND);
+    if (newMinute) {
+      raiseEvent(EVENT_MINUTE);
     }
+  }
 
-    if ((second() == 1) && triggeredThisSec) {
-      triggeredThisSec = false;
+  if (timeSyncReceived) {
+    timeSyncReceived = false;
+    raiseEvent(EVENT_TIME_SYNC);
+  }
+
+  // Save any options the WiFi module sent. The I2C interrupt only sets the
+  // values, the EEPROM write is too slow to do there
+  if (i2cOptionsApplied != i2cOptionsReceived) {
+    byte optionsReceived = i2cOptionsReceived;
+    saveEEPROMValues();
+    i2cOptionsApplied = optionsReceived;
+
+    // We only need to look for the next alarm when the schedule changed
+    if (alarmsChanged) {
+      alarmsChanged = false;
+      computeNextAlarm();
     }
+  }
 
-    lastCheckMillis = nowMillis;
+  // The self test takes a couple of seconds, much too long for the I2C interrupt
+  if (selfTestRequested) {
+    selfTestRequested = false;
+    runSelfTest();
+    tempDisplayMode = TEMP_SELF_TEST;
+    tempDisplayModeDuration = TEMP_DISPLAY_MODE_DUR_MS;
+  }
+
+  // A countdown that ran out goes off like an alarm
+  if (countdownExpired) {
+    countdownExpired = false;
+    triggerAlarm(I2C_ALARM_ACTION_UNBLANK | I2C_ALARM_ACTION_FLASH);
   }
 
   // Check button, we evaluate below
@@ -773,30 +1065,22 @@ void loop()
     nextMode = currentMode;
   } else if (button1.isButtonPressedReleased2S()) {
     currentMode = MODE_MIN;
-
-    // Store the EEPROM if we exit the config mode
-    saveEEPROMValues();
-
-    // Preset the display
-    allFadeOrNormal(DO_NOT_APPLY_LEAD_0_BLANK);
-
     nextMode = currentMode;
   } else if (button1.isButtonPressedReleased1S()) {
     currentMode++;
 
     if (currentMode > MODE_MAX) {
       currentMode = MODE_MIN;
-
-      // Store the EEPROM if we exit the config mode
-      saveEEPROMValues();
-
-      // Preset the display
-      allFadeOrNormal(DO_NOT_APPLY_LEAD_0_BLANK);
     }
 
     nextMode = currentMode;
   }
 
+  if (currentMode != lastEventMode) {
+    lastEventMode = currentMode;
+    raiseEvent(EVENT_MODE_ENTERED);
+  }
+
   // ************* Process the modes *************
   if (nextMode != currentMode) {
     setNextMode();
@@ -805,24 +1089,13 @@ void loop()
   }
 
   // get the LDR ambient light reading
-  digitOffCount = getDimmingFromLDR();
-  fadeStep = digitOffCount / fadeSteps;
+  digitOffCountFine = getDimmingFromLDR();
+  digitOffCount = digitOffCountFine >> DITHER_SHIFT;
+  fadeStep = (float) digitOffCountFine / (DITHER_SCALE * fadeSteps);
 
-  // One armed bandit trigger every 10th minute
-  if ((currentMode != MODE_DIGIT_BURN) && (nextMode != MODE_DIGIT_BURN)) {
-    if (acpOffset == 0) {
-      if (((minute() % 10) == 9) && (second() == 15)) {
-        // suppress ACP when fully dimmed
-        if (suppressACP) {
-          if (digitOffCount > minDim) {
-            acpOffset = 1;
-          }
-        } else {
-          acpOffset = 1;
-        }
-      }
-    }
+  updateRejuvenation();
 
+  if ((currentMode != MODE_DIGIT_BURN) && (nextMode != MODE_DIGIT_BURN)) {
     // One armed bandit handling
     if (acpOffset > 0) {
       if (acpTick >= acpOffset) {
@@ -836,8 +1109,15 @@ void loop()
       }
     }
 
-    // Set normal output display
-    outputDisplay();
+    // Set normal output display, unless we are using the blanked time to heal cathodes
+    if (rejuvBurning) {
+      outputRejuvenation();
+    } else {
+      outputDisplay();
+      if (!blankTubes) {
+        recordBootStage(I2C_BOOT_STAGE_FIRST_FRAME);
+      }
+    }
   } else {
     // Digit burn mode
     digitOn(digitBurnDigit, digitBurnValue);
@@ -845,6 +1125,9 @@ void loop()
 
   // Slow regulation of the voltage
   checkHVVoltage();
+  if ((int) sensorHVSmoothed >= rawHVADCThreshold) {
+    recordBootStage(I2C_BOOT_STAGE_HV_READY);
+  }
 
   // Prepare the tick and backlight LEDs
   setLeds();
@@ -904,10 +1187,12 @@ void performOncePerSecondProcessing() {
 // ************************************************************
 void performOncePerMinuteProcessing() {
   if (useWiFi > 0) {
+#ifdef RTC_DIRECT
     if (useWiFi == MAX_WIFI_TIME) {
-      // We recently got an update, send to the RTC (if installed)
-      setRTC();      
+      // We recently got an update, check the RTC (if installed)
+      checkRTCDrift();
     }
+#endif
     useWiFi--;
   } else {
     // get the time from the external RTC provider - (if installed)
@@ -915,6 +1200,23 @@ void performOncePerMinuteProcessing() {
   }
 }
 
+// ************************************************************
+// In the cycle modes the back lights head for a new colour
+// each time the minutes change on the tubes
+// ************************************************************
+void backlightOnDigitChanged() {
+  if ((backlightMode != BACKLIGHT_CYCLE) && (backlightMode != BACKLIGHT_CYCLE_DIM)) {
+    return;
+  }
+
+  // Only the time itself, not the effects that run over it
+  if ((eventDigit != 3) || (currentMode != MODE_TIME) || (acpOffset > 0) || transition.isMessageOnDisplay(nowMillis)) {
+    return;
+  }
+
+  colourCycle.changeSteps = 0;
+}
+
 // ************************************************************
 // Set the seconds tick led(s) and the back lights
 // ************************************************************
@@ -934,7 +1236,20 @@ void setLeds()
   // Tick led output
   analogWrite(tickLed, getLEDAdjusted(255, pwmFactor, dimFactor));
 
-  if (blankLEDs) {
+  if (alarmFlashing && ((nowMillis - alarmFlashStartMillis) > ALARM_FLASH_MS)) {
+    alarmFlashing = false;
+  }
+
+  if (alarmFlashing) {
+    // Alarm: flash the back lights, even if they are blanked
+    byte alarmFlash = 0;
+    if (((nowMillis - alarmFlashStartMillis) % ALARM_FLASH_PERIOD_MS) < (ALARM_FLASH_PERIOD_MS / 2)) {
+      alarmFlash = 255;
+    }
+    analogWrite(RLed, alarmFlash);
+    analogWrite(GLed, alarmFlash);
+    analogWrite(BLed, alarmFlash);
+  } else if (blankLEDs) {
     analogWrite(RLed, 0);
     analogWrite(GLed, 0);
     analogWrite(BLed, 0);
@@ -953,7 +1268,7 @@ void setLeds()
           analogWrite(BLed, getLEDAdjusted(rgb_backlight_curve[bluCnl], pwmFactor, 1));
           break;
         case BACKLIGHT_CYCLE:
-          cycleColours3(colors);
+          cycleColours3(colors, colourCycle, cycleSpeed);
           analogWrite(RLed, getLEDAdjusted(colors[0], 1, 1));
           analogWrite(GLed, getLEDAdjusted(colors[1], 1, 1));
           analogWrite(BLed, getLEDAdjusted(colors[2], 1, 1));
@@ -969,7 +1284,7 @@ void setLeds()
           analogWrite(BLed, getLEDAdjusted(rgb_backlight_curve[bluCnl], pwmFactor, dimFactor));
           break;
         case BACKLIGHT_CYCLE_DIM:
-          cycleColours3(colors);
+          cycleColours3(colors, colourCycle, cycleSpeed);
           analogWrite(RLed, getLEDAdjusted(colors[0], 1, dimFactor));
           analogWrite(GLed, getLEDAdjusted(colors[1], 1, dimFactor));
           analogWrite(BLed, getLEDAdjusted(colors[2], 1, dimFactor));
@@ -1214,6 +1529,16 @@ void setNextMode() {
         displayConfig();
         break;
       }
+    case MODE_SUB_SLOTS: {
+        loadNumberArrayConfInt(subSlots, nextMode - MODE_12_24);
+        displayConfig();
+        break;
+      }
+    case MODE_ROLL_MODE: {
+        loadNumberArrayConfInt(rollMode, nextMode - MODE_12_24);
+        displayConfig();
+        break;
+      }
     case MODE_TEMP: {
         loadNumberArrayTemp(nextMode - MODE_12_24);
         displayConfig();
@@ -1229,6 +1554,16 @@ void setNextMode() {
         allNormal();
         break;
       }
+    case MODE_STOPWATCH: {
+        loadNumberArrayTimer(TIMER_STOPWATCH);
+        allNormal();
+        break;
+      }
+    case MODE_COUNTDOWN: {
+        loadNumberArrayTimer(TIMER_COUNTDOWN);
+        allNormal();
+        break;
+      }
     case MODE_DIGIT_BURN: {
         // Nothing: handled separately to suppress multiplexing
       }
@@ -1242,8 +1577,11 @@ void processCurrentMode() {
   switch (currentMode) {
     case MODE_TIME: {
         if (button1.isButtonPressedAndReleased()) {
-          // Deal with blanking first
-          if ((nowMillis < blankSuppressedSelectionTimoutMillis) || blanked) {
+          // A press while an alarm is flashing just stops it
+          if (alarmFlashing) {
+            alarmFlashing = false;
+          } else if ((nowMillis < blankSuppressedSelectionTimoutMillis) || blanked) {
+            // Deal with blanking first
             if (blankSuppressedSelectionTimoutMillis == 0) {
               // Apply 5 sec tineout for setting the suppression time
               blankSuppressedSelectionTimoutMillis = nowMillis + TEMP_DISPLAY_MODE_DUR_MS;
@@ -1324,6 +1662,10 @@ void processCurrentMode() {
             loadNumberArrayConfInt(lastImpressionsPerSec, 0);
           }
 
+          if (tempDisplayMode == TEMP_SELF_TEST) {
+            loadNumberArrayConfInt(selfTestFailed, SELF_TEST_DISPLAY_NUM);
+          }
+
           allFadeOrNormal(DO_NOT_APPLY_LEAD_0_BLANK);
 
         } else {
@@ -1332,18 +1674,6 @@ void processCurrentMode() {
             allBright();
           } else {
             if (slotsMode > SLOTS_MODE_MIN) {
-              if (second() == 50) {
-
-                // initialise the slots values
-                loadNumberArrayDate();
-                transition.setAlternateValues();
-                loadNumberArrayTime();
-                transition.setRegularValues();
-                allFadeOrNormal(DO_NOT_APPLY_LEAD_0_BLANK);
-
-                transition.start(nowMillis);
-              }
-
               // initialise the slots mode
               boolean msgDisplaying;
               switch (slotsMode) {
@@ -1747,6 +2077,28 @@ void processCurrentMode() {
         displayConfig();
         break;
       }
+    case MODE_SUB_SLOTS: {
+        if (button1.isButtonPressedAndReleased()) {
+          subSlots++;
+          if (subSlots > SUB_SLOTS_MAX) {
+            subSlots = SUB_SLOTS_MIN;
+          }
+        }
+        loadNumberArrayConfInt(subSlots, currentMode - MODE_12_24);
+        displayConfig();
+        break;
+      }
+    case MODE_ROLL_MODE: {
+        if (button1.isButtonPressedAndReleased()) {
+          rollMode++;
+          if (rollMode > ROLL_MODE_MAX) {
+            rollMode = ROLL_MODE_MIN;
+          }
+        }
+        loadNumberArrayConfInt(rollMode, currentMode - MODE_12_24);
+        displayConfig();
+        break;
+      }
     case MODE_TEMP: {
         loadNumberArrayTemp(currentMode - MODE_12_24);
         displayConfig();
@@ -1762,6 +2114,21 @@ void processCurrentMode() {
         loadNumberArrayTestDigits();
         break;
       }
+    case MODE_STOPWATCH:
+    case MODE_COUNTDOWN: {
+        byte timer = (currentMode == MODE_STOPWATCH) ? TIMER_STOPWATCH : TIMER_COUNTDOWN;
+        if (button1.isButtonPressedAndReleased()) {
+          // A press while an alarm is flashing just stops it
+          if (alarmFlashing) {
+            alarmFlashing = false;
+          } else {
+            pressTimerButton(timer);
+          }
+        }
+        allNormal();
+        loadNumberArrayTimer(timer);
+        break;
+      }
     case MODE_DIGIT_BURN: {
         if (button1.isButtonPressedAndReleased()) {
           digitBurnValue += 1;
@@ -1791,65 +2158,6 @@ byte getLEDAdjusted(float rawValue, float ledPWMVal, float dimFactor) {
   return dim_curve[dimmedPWMVal];
 }
 
-// ************************************************************
-// Colour cycling 3: one colour dominates
-// ************************************************************
-void cycleColours3(int colors[3]) {
-  cycleCount++;
-  if (cycleCount > cycleSpeed) {
-    cycleCount = 0;
-
-    if (changeSteps == 0) {
-      changeSteps = random(256);
-      currentColour = random(3);
-    }
-
-    changeSteps--;
-
-    switch (currentColour) {
-      case 0:
-        if (colors[0] < 255) {
-          colors[0]++;
-          if (colors[1] > 0) {
-            colors[1]--;
-          }
-          if (colors[2] > 0) {
-            colors[2]--;
-          }
-        } else {
-          changeSteps = 0;
-        }
-        break;
-      case 1:
-        if (colors[1] < 255) {
-          colors[1]++;
-          if (colors[0] > 0) {
-            colors[0]--;
-          }
-          if (colors[2] > 0) {
-            colors[2]--;
-          }
-        } else {
-          changeSteps = 0;
-        }
-        break;
-      case 2:
-        if (colors[2] < 255) {
-          colors[2]++;
-          if (colors[0] > 0) {
-            colors[0]--;
-          }
-          if (colors[1] > 0) {
-            colors[1]--;
-          }
-        } else {
-          changeSteps = 0;
-        }
-        break;
-    }
-  }
-}
-
 //**********************************************************************************
 //**********************************************************************************
 //*                             Utility functions                                  *
@@ -1959,6 +2267,19 @@ void loadNumberArrayTestDigits() {
   NumberArray[0] = (second() + 5) % 10;
 }
 
+// ************************************************************
+// Stopwatch or countdown digits, already split up by the timer
+// interrupt. We stop it while we copy so we don't get half a carry.
+// ************************************************************
+void loadNumberArrayTimer(byte timer) {
+  byte oldSREG = SREG;
+  cli();
+  for (byte i = 0 ; i < 6 ; i++) {
+    NumberArray[i] = timerDigits[timer][i];
+  }
+  SREG = oldSREG;
+}
+
 // ************************************************************
 // Do the Anti Cathode Poisoning
 // ************************************************************
@@ -2045,6 +2366,64 @@ void SetSN74141Chip(int num1)
   PORTB = portb;
 }
 
+// ************************************************************
+// Work out the value a roll shows after n steps from its start
+// ************************************************************
+byte rollValue(byte digit, byte n) {
+  if (rollMode == ROLL_MODE_DOWN) {
+    return (rollFrom[digit] + 10 - n) % 10;
+  } else {
+    return (rollFrom[digit] + n) % 10;
+  }
+}
+
+// ************************************************************
+// Move a rolling digit on for this frame. The roll goes through
+// every value between the one we show and the new one in the
+// same time, however far that is, cross fading each value into
+// the next. Sets the value to show and the one to fade into,
+// and returns the switch time for the slot. Digits that are not
+// changing cost next to nothing.
+// ************************************************************
+int rollDigit(byte digit, int offTime) {
+  if ((rollSteps[digit] == 0) || (rollValue(digit, rollSteps[digit]) != NumberArray[digit])) {
+    // Start a roll, or start again from where we are if the target moved
+    if ((NumberArray[digit] == currNumberArray[digit]) || (NumberArray[digit] > 9) || (currNumberArray[digit] > 9)) {
+      rollSteps[digit] = 0;
+      currNumberArray[digit] = NumberArray[digit];
+      rollNext[digit] = NumberArray[digit];
+      return DIGIT_DISPLAY_COUNT;
+    }
+
+    rollFrom[digit] = currNumberArray[digit];
+    if (rollMode == ROLL_MODE_DOWN) {
+      rollSteps[digit] = (currNumberArray[digit] + 10 - NumberArray[digit]) % 10;
+    } else {
+      rollSteps[digit] = (NumberArray[digit] + 10 - currNumberArray[digit]) % 10;
+    }
+    rollStartMillis[digit] = nowMillis;
+  }
+
+  unsigned long elapsed = nowMillis - rollStartMillis[digit];
+  if (elapsed >= ROLL_DURATION_MS) {
+    // finish the roll
+    rollSteps[digit] = 0;
+    currNumberArray[digit] = NumberArray[digit];
+    rollNext[digit] = NumberArray[digit];
+    return DIGIT_DISPLAY_COUNT;
+  }
+
+  // Position in the roll in 1/256ths of a step: the whole part is the value
+  // we show, the fraction is how far we have faded into the next one
+  unsigned int position = (elapsed * rollSteps[digit] * 256) / ROLL_DURATION_MS;
+  byte step = position >> 8;
+  byte fraction = position & 0xff;
+
+  currNumberArray[digit] = rollValue(digit, step);
+  rollNext[digit] = rollValue(digit, step + 1);
+  return offTime - (((long) offTime * fraction) >> 8);
+}
+
 // ************************************************************
 // Do a single complete display, including any fading and
 // dimming requested. Performs the display loop
@@ -2059,9 +2438,60 @@ void outputDisplay()
   float digitSwitchTimeFloat;
   int tmpDispType;
 
+  // What each digit does in its slot, worked out before we show any of them
+  int slotOnTime[6];
+  int slotSwitchTime[6];
+  int slotOffTime[6];
+  byte slotSwitchDigit[6];
+
   // used to blank all leading digits if 0
   boolean leadingZeros = true;
 
+  // Digits that started a change in this frame
+  byte digitsChanged = 0;
+
+  // The timer digits change too fast to scroll or roll
+  boolean timerShown = isTimerMode(currentMode) || isTimerMode(nextMode);
+  boolean useRoll = (rollMode != ROLL_MODE_OFF) && !timerShown;
+  boolean useScrollback = scrollback && !useRoll && !timerShown;
+
+  // Everything between the digit loops of two frames (the rest of loop(),
+  // and getting this frame ready) is dark time. Measure it in ticks a slot,
+  // with the tick length from the last frame, and keep a running average.
+  unsigned long frameStartMicros = micros();
+  unsigned long frameGapMicros = frameStartMicros - lastFrameMicros;
+  if ((lastFrameLoopMicros > 0) && (frameGapMicros < FRAME_GAP_MAX_MICROS)) {
+    unsigned int gapTicks = frameGapMicros * lastFrameTicks / lastFrameLoopMicros / 6;
+    slotOverhead8 = slotOverhead8 - (slotOverhead8 / 8) + gapTicks;
+  }
+  int slotOverhead = slotOverhead8 / 8;
+
+  // Size the digit slots for this frame from the on time of the brightest
+  // digit. Cutting the slot keeps each digit's share of the frame, so the
+  // brightness stays and the refresh rate goes up.
+  int onMax = 0;
+  for ( int i = 0 ; i < 6 ; i ++ ) {
+    if (blankTubes || (displayType[i] == BLANKED)) {
+      continue;
+    } else if (displayType[i] == BRIGHT) {
+      onMax = DIGIT_DISPLAY_OFF;
+    } else if (displayType[i] == DIMMED) {
+      if (onMax < DIM_VALUE) onMax = DIM_VALUE;
+    } else {
+      if (onMax < digitOffCount + 1) onMax = digitOffCount + 1;
+    }
+  }
+
+  // If that gives nothing back, the frame is what it always was
+  int slotCount = getSlotCount(dispCount, onMax, slotOverhead, antiGhost);
+  float slotScale = 1.0;
+  if (slotCount < dispCount) {
+    slotScale = (float) (slotCount + slotOverhead) / (float) (dispCount + slotOverhead);
+  }
+
+  // The fraction of a tick we can't show is dithered over the frames
+  int ditheredOffCount = ditherOffCount(digitOffCountFine, slotScale, ditherError);
+
   for ( int i = 0 ; i < 6 ; i ++ )
   {
     if (blankTubes) {
@@ -2080,27 +2510,27 @@ void outputDisplay()
       case DIMMED:
         {
           digitOnTime = DIGIT_DISPLAY_ON;
-          digitOffTime = DIM_VALUE;
+          digitOffTime = DIM_VALUE * slotScale;
           break;
         }
       case BRIGHT:
         {
           digitOnTime = DIGIT_DISPLAY_ON;
-          digitOffTime = DIGIT_DISPLAY_OFF;
+          digitOffTime = DIGIT_DISPLAY_OFF * slotScale;
           break;
         }
       case FADE:
       case NORMAL:
         {
           digitOnTime = DIGIT_DISPLAY_ON;
-          digitOffTime = digitOffCount;
+          digitOffTime = ditheredOffCount;
           break;
         }
       case BLINK:
         {
           if (blinkState) {
             digitOnTime = DIGIT_DISPLAY_ON;
-            digitOffTime = digitOffCount;
+            digitOffTime = ditheredOffCount;
           } else {
             digitOnTime = DIGIT_DISPLAY_NEVER;
             digitOffTime = DIGIT_DISPLAY_ON;
@@ -2110,7 +2540,7 @@ void outputDisplay()
       case SCROLL:
         {
           digitOnTime = DIGIT_DISPLAY_ON;
-          digitOffTime = digitOffCount;
+          digitOffTime = ditheredOffCount;
           break;
         }
     }
@@ -2118,16 +2548,34 @@ void outputDisplay()
     // Do scrollback when we are going to 0
     if ((NumberArray[i] != currNumberArray[i]) &&
         (NumberArray[i] == 0) &&
-        scrollback) {
+        useScrollback) {
       tmpDispType = SCROLL;
     }
 
+    // Rolling takes over from fading for any digit that changes
+    if (useRoll && ((tmpDispType == FADE) || (tmpDispType == NORMAL))) {
+      tmpDispType = ROLL;
+    } else {
+      rollSteps[i] = 0;
+    }
+
+    // A digit raises its event when it starts on the way to a new value,
+    // not again while it fades, rolls or scrolls there
+    byte digitBit = 1 << i;
+    if ((tmpDispType != BLANKED) && (NumberArray[i] != currNumberArray[i]) && !(digitsChanging & digitBit)) {
+      digitsChanging |= digitBit;
+      digitsChanged |= digitBit;
+    }
+
+    slotSwitchDigit[i] = NumberArray[i];
+
     // manage fading, each impression we show 1 fade step less of the old
     // digit and 1 fade step more of the new
-    // manage fading, each impression we show 1 fade step less of the old
-    // digit and 1 fade step more of the new
-    if (tmpDispType == SCROLL) {
-      digitSwitchTime = DIGIT_DISPLAY_OFF;
+    if (tmpDispType == ROLL) {
+      digitSwitchTime = rollDigit(i, digitOffTime);
+      slotSwitchDigit[i] = rollNext[i];
+    } else if (tmpDispType == SCROLL) {
+      digitSwitchTime = DIGIT_DISPLAY_OFF * slotScale;
       if (NumberArray[i] != currNumberArray[i]) {
         if (fadeState[i] == 0) {
           // Start the fade
@@ -2144,43 +2592,76 @@ void outputDisplay()
         }
       }
     } else if (tmpDispType == FADE) {
-      if (NumberArray[i] != currNumberArray[i]) {
-        if (fadeState[i] == 0) {
-          // Start the fade
-          fadeState[i] = fadeSteps;
-          digitSwitchTime = (int) fadeState[i] * fadeStep;
-        }
-      }
-
-      if (fadeState[i] == 1) {
-        // finish the fade
-        fadeState[i] = 0;
+      digitSwitchTime = stepFade(fadeState[i], (NumberArray[i] != currNumberArray[i]), fadeSteps, fadeStep, slotScale);
+      if (fadeState[i] == 0) {
         currNumberArray[i] = NumberArray[i];
-        digitSwitchTime = DIGIT_DISPLAY_COUNT;
-      } else if (fadeState[i] > 1) {
-        // Continue the fade
-        fadeState[i] = fadeState[i] - 1;
-        digitSwitchTime = (int) fadeState[i] * fadeStep;
       }
     } else {
-      digitSwitchTime = DIGIT_DISPLAY_COUNT;
+      digitSwitchTime = DIGIT_DISPLAY_COUNT * slotScale;
       currNumberArray[i] = NumberArray[i];
     }
 
-    for (int timer = 0 ; timer < dispCount ; timer++) {
-      if (timer == digitOnTime) {
-        digitOn(i, currNumberArray[i]);
+    if (currNumberArray[i] == NumberArray[i]) {
+      digitsChanging &= ~digitBit;
+    }
+
+    slotOnTime[i] = digitOnTime;
+    slotSwitchTime[i] = digitSwitchTime;
+    slotOffTime[i] = digitOffTime;
+  }
+
+  // With sub slots we show each digit subSlots times a frame, a piece of its
+  // on time each time, in the order 0,3,1,4,2,5. The pieces add up to the
+  // whole on time, so each tube is refreshed more often for the same duty.
+  // Every piece keeps the anti-ghost gap.
+  int subSlotCount = slotCount;
+  if (subSlots > 1) {
+    subSlotCount = (slotCount - antiGhost) / subSlots + antiGhost;
+  }
+
+  unsigned long loopStartMicros = micros();
+  for (byte pass = 0 ; pass < subSlots ; pass++) {
+    for (byte idx = 0 ; idx < 6 ; idx++) {
+      byte i = idx;
+      digitOnTime = slotOnTime[i];
+      digitSwitchTime = slotSwitchTime[i];
+      digitOffTime = slotOffTime[i];
+
+      if (subSlots > 1) {
+        i = interleavedScanOrder[idx];
+        digitOnTime = slotOnTime[i];
+
+        // Spread the remainders over the passes, so the pieces add up exactly
+        digitSwitchTime = (slotSwitchTime[i] + pass) / subSlots;
+        digitOffTime = (slotOffTime[i] + pass) / subSlots;
       }
 
-      if  (timer == digitSwitchTime) {
-        SetSN74141Chip(NumberArray[i]);
+      // The anode has to go off inside the slot, or the tube stays lit
+      // through the next one
+      if (digitOffTime >= subSlotCount) {
+        digitOffTime = subSlotCount - 1;
       }
 
-      if (timer == digitOffTime) {
-        digitOff();
+      for (int timer = 0 ; timer < subSlotCount ; timer++) {
+        if (timer == digitOnTime) {
+          digitOn(i, currNumberArray[i]);
+        }
+
+        if  (timer == digitSwitchTime) {
+          SetSN74141Chip(slotSwitchDigit[i]);
+        }
+
+        if (timer == digitOffTime) {
+          digitOff();
+        }
+
+        DISPLAY_TICK();
       }
     }
   }
+  lastFrameMicros = micros();
+  lastFrameLoopMicros = lastFrameMicros - loopStartMicros;
+  lastFrameTicks = (long) 6 * subSlots * subSlotCount;
 
   // Deal with blink, calculate if we are on or off
   blinkCounter++;
@@ -2188,6 +2669,14 @@ void outputDisplay()
     blinkCounter = 0;
     blinkState = !blinkState;
   }
+
+  // Now the frame is out, tell everyone about the digits that changed
+  for (byte i = 0 ; i < 6 ; i++) {
+    if (digitsChanged & (1 << i)) {
+      eventDigit = i;
+      raiseEvent(EVENT_DIGIT_CHANGED);
+    }
+  }
 }
 
 // ************************************************************
@@ -2544,43 +3033,16 @@ boolean checkBlanking() {
   // Check day blanking, but only when we are in
   // normal time mode
   if (currentMode == MODE_TIME) {
-    switch (dayBlanking) {
-      case DAY_BLANKING_NEVER:
-        return false;
-      case DAY_BLANKING_HOURS:
-        return getHoursBlanked();
-      case DAY_BLANKING_WEEKEND:
-        return ((weekday() == 1) || (weekday() == 7));
-      case DAY_BLANKING_WEEKEND_OR_HOURS:
-        return ((weekday() == 1) || (weekday() == 7)) || getHoursBlanked();
-      case DAY_BLANKING_WEEKEND_AND_HOURS:
-        return ((weekday() == 1) || (weekday() == 7)) && getHoursBlanked();
-      case DAY_BLANKING_WEEKDAY:
-        return ((weekday() > 1) && (weekday() < 7));
-      case DAY_BLANKING_WEEKDAY_OR_HOURS:
-        return ((weekday() > 1) && (weekday() < 7)) || getHoursBlanked();
-      case DAY_BLANKING_WEEKDAY_AND_HOURS:
-        return ((weekday() > 1) && (weekday() < 7)) && getHoursBlanked();
-      case DAY_BLANKING_ALWAYS:
-        return true;
-    }
+    return isDayBlanked(dayBlanking, weekday(), getHoursBlanked());
   }
+  return false;
 }
 
 // ************************************************************
 // If we are currently blanked based on hours
 // ************************************************************
 boolean getHoursBlanked() {
-  if (blankHourStart > blankHourEnd) {
-    // blanking before midnight
-    return ((hour() >= blankHourStart) || (hour() < blankHourEnd));
-  } else if (blankHourStart < blankHourEnd) {
-    // dim at or after midnight
-    return ((hour() >= blankHourStart) && (hour() < blankHourEnd));
-  } else {
-    // no dimming if Start = End
-    return false;
-  }
+  return isHoursBlanked(hour(), blankHourStart, blankHourEnd);
 }
 
 // ************************************************************
@@ -2665,41 +3127,63 @@ void setLedsTestPattern(unsigned long currentMillis) {
 //**********************************************************************************
 //**********************************************************************************
 
+#ifdef RTC_PROXY
 // ************************************************************
-// Get the time from the RTC
+// Get the time from the RTC: nothing to do, the WiFi module
+// pushes the RTC time to us
 // ************************************************************
 void getRTCTime() {
-  // Start the RTC communication in master mode
-  Wire.end();
-  Wire.begin();
+}
 
-  // Set up the time provider
-  // first try to find the RTC, if not available, go into slave mode
-  Wire.beginTransmission(RTC_I2C_ADDRESS);
-  useRTC = (Wire.endTransmission() == 0);
-  if (useRTC) {
-    bool PM;
-    bool twentyFourHourClock;
-    bool century = false;
-
-    byte years = Clock.getYear() + 2000;
-    byte months = Clock.getMonth(century);
-    byte days = Clock.getDate();
-    byte hours = Clock.getHour(twentyFourHourClock, PM);
-    byte mins = Clock.getMinute();
-    byte secs = Clock.getSecond();
-    setTime(hours, mins, secs, days, months, years);
-
-    // Make sure the clock keeps running even on battery
-    if (!Clock.oscillatorCheck())
+// ************************************************************
+// Set the date/time in the RTC from the internal time: flag it
+// so that the WiFi module collects it and writes the RTC
+// ************************************************************
+void setRTC() {
+  if (useRTC) {
+    // Make sure the WiFi module picks up the new time, not the last one
+    updateI2CTimeShadow();
+    rtcTimeSetPending = true;
+  }
+}
+#else
+// ************************************************************
+// Get the time from the RTC
+// ************************************************************
+void getRTCTime() {
+  // Start the RTC communication in master mode
+  startI2CMaster();
+
+  // Set up the time provider
+  // first try to find the RTC, if not available, go into slave mode
+  Wire.beginTransmission(RTC_I2C_ADDRESS);
+  useRTC = (Wire.endTransmission() == 0);
+  if (useRTC) {
+    // If the oscillator has stopped (e.g. flat battery) the RTC time
+    // is junk, keep our own until the RTC gets set again
+    if (Clock.oscillatorCheck()) {
+      setTime(readRTCTime());
+      timeSyncReceived = true;
+    } else {
+      // Make sure the clock keeps running even on battery
       Clock.enableOscillator(true, true, 0);
+    }
+
+    rtcTemp = Clock.getTemperature();
+
+    // Put back our aging offset if the RTC lost it. If we never saved
+    // one, the RTC's own is the best we have.
+    signed char rtcAging = Clock.getAgingOffset();
+    if (!rtcAgingKnown) {
+      rtcAgingOffset = constrain(rtcAging, RTC_AGING_MIN, RTC_AGING_MAX);
+      rtcAgingKnown = true;
+    } else if (rtcAging != rtcAgingOffset) {
+      Clock.setAgingOffset(rtcAgingOffset);
+    }
   }
 
   // Return back to I2C in slave mode
-  Wire.end();
-  Wire.begin(I2C_SLAVE_ADDR);
-  Wire.onReceive(receiveEvent);
-  Wire.onRequest(requestEvent);
+  startI2CSlave();
 }
 
 // ************************************************************
@@ -2710,40 +3194,709 @@ void getRTCTime() {
 void setRTC() {
   if (useRTC) {
     // Start the RTC communication in master mode
-    Wire.end();
-    Wire.begin();
+    startI2CMaster();
+    writeRTCTime(now());
+    startI2CSlave();
+
+    // Start the drift measurement again from the next WiFi time
+    rtcDriftBaseline = 0;
+  }
+}
 
-    // Set up the time provider
-    // first try to find the RTC, if not available, go into slave mode
-    Wire.beginTransmission(RTC_I2C_ADDRESS);
-    Clock.setClockMode(false); // false = 24h
-    Clock.setYear(year() % 100);
-    Clock.setMonth(month());
-    Clock.setDate(day());
-    Clock.setDoW(weekday());
-    Clock.setHour(hour());
-    Clock.setMinute(minute());
-    Clock.setSecond(second());
+// ************************************************************
+// Write the given time to the RTC in one go, so that it can't
+// roll over part way through. Call in master mode.
+// ************************************************************
+void writeRTCTime(time_t timeToSet) {
+  Clock.setDateTime(year(timeToSet) % 100, month(timeToSet), day(timeToSet), weekday(timeToSet),
+                    hour(timeToSet), minute(timeToSet), second(timeToSet), false);
+}
 
-    Wire.endTransmission();
-    Wire.end();
-    Wire.begin(I2C_SLAVE_ADDR);
-    Wire.onReceive(receiveEvent);
-    Wire.onRequest(requestEvent);
+// ************************************************************
+// Read the time from the RTC in one go. Call in master mode.
+// ************************************************************
+time_t readRTCTime() {
+  byte years, months, days, dow, hours, mins, secs;
+  Clock.getTime(years, months, days, dow, hours, mins, secs);
+
+  tmElements_t tm;
+  tm.Year = y2kYearToTm(years);
+  tm.Month = months;
+  tm.Day = days;
+  tm.Hour = hours;
+  tm.Minute = mins;
+  tm.Second = secs;
+  return makeTime(tm);
+}
+
+// ************************************************************
+// Check the RTC against the WiFi time we just got. We leave the
+// RTC alone until it is more than RTC_DRIFT_MAX_SECS out, and
+// add up the corrections. Once we have a day of history we work
+// out the drift in ppm and trim the aging offset to cancel it.
+// ************************************************************
+void checkRTCDrift() {
+  if (!useRTC) {
+    return;
+  }
+
+  startI2CMaster();
+
+  time_t wifiTime = now();
+  long rtcError = (long) (readRTCTime() - wifiTime);
+  rtcTemp = Clock.getTemperature();
+
+  if ((rtcDriftBaseline == 0) || (abs(rtcError) > RTC_DRIFT_STEP_SECS)) {
+    // First sync, or the time was changed: nothing to learn from this
+    writeRTCTime(wifiTime);
+    rtcDriftBaseline = wifiTime;
+    rtcDriftSecs = 0;
+  } else if (abs(rtcError) > RTC_DRIFT_MAX_SECS) {
+    writeRTCTime(wifiTime);
+    rtcDriftSecs += rtcError;
+
+    unsigned long elapsed = wifiTime - rtcDriftBaseline;
+    if (elapsed >= RTC_DRIFT_MIN_PERIOD_SECS) {
+      // One aging step is about 0.1ppm, and a positive step slows
+      // the RTC down. We only take half of the correction, because
+      // the error we see is only good to a second.
+      float driftPPM = (float) rtcDriftSecs * 1000000.0 / (float) elapsed;
+      int newAgingOffset = rtcAgingOffset + (int) (driftPPM * 10.0 / 2.0);
+      rtcAgingOffset = constrain(newAgingOffset, RTC_AGING_MIN, RTC_AGING_MAX);
+      Clock.setAgingOffset(rtcAgingOffset);
+      saveRTCAgingOffset();
+
+      rtcDriftBaseline = wifiTime;
+      rtcDriftSecs = 0;
+    }
   }
+
+  startI2CSlave();
+}
+#endif
+
+// ************************************************************
+// Save the aging offset, and mark that we have saved one
+// ************************************************************
+void saveRTCAgingOffset() {
+  EEPROM.update(EE_RTC_AGING, rtcAgingOffset);
+  EEPROM.update(EE_RTC_AGING_VALID, RTC_AGING_VALID);
 }
 
 // ************************************************************
-// Get the temperature from the RTC
+// Get the temperature from the RTC. We are normally in slave
+// mode here, so we use the last reading: the RTC only updates
+// it every 64 seconds anyway.
 // ************************************************************
 float getRTCTemp() {
   if (useRTC) {
-    return Clock.getTemperature();
+    return rtcTemp;
   } else {
     return 0.0;
   }
 }
 
+// ************************************************************
+// Take over the bus as master so that we can talk to the RTC.
+// Wire.begin() resets the bus clock, so reapply fast mode if
+// the WiFi module has negotiated it.
+// ************************************************************
+void startI2CMaster() {
+  Wire.end();
+  Wire.begin();
+  if (i2cFastMode) {
+    Wire.setClock(I2C_SPEED_FAST);
+  }
+}
+
+// ************************************************************
+// Go back to being a slave so the WiFi module can reach us
+// ************************************************************
+void startI2CSlave() {
+  Wire.end();
+  Wire.begin(I2C_SLAVE_ADDR);
+  Wire.onReceive(receiveEvent);
+  Wire.onRequest(requestEvent);
+}
+
+//**********************************************************************************
+//**********************************************************************************
+//*                                    Events                                      *
+//**********************************************************************************
+//**********************************************************************************
+
+// Who wants to hear about what. Handlers are called in table order.
+const EventSubscriber eventSubscribers[] PROGMEM = {
+  {EVENT_SECOND,        startACPIfDue},
+  {EVENT_SECOND,        startSlotsIfDue},
+#ifdef RTC_PROXY
+  {EVENT_SECOND,        updateI2CTimeShadow},
+  {EVENT_TIME_SYNC,     updateI2CTimeShadow},
+#endif
+  {EVENT_SECOND,        updateI2CRejuvShadow},
+  {EVENT_SECOND,        updateI2CTelemetryShadow},
+  {EVENT_MINUTE,        performOncePerMinuteProcessing},
+  {EVENT_MINUTE,        stepRejuvenation},
+  {EVENT_MINUTE,        checkAlarms},
+  {EVENT_MODE_ENTERED,  saveOptionsOnConfigExit},
+  {EVENT_DIGIT_CHANGED, backlightOnDigitChanged},
+};
+
+#define EVENT_SUBSCRIBER_COUNT (sizeof(eventSubscribers) / sizeof(EventSubscriber))
+
+// ************************************************************
+// Call everyone who subscribed to the event
+// ************************************************************
+void raiseEvent(byte event) {
+  for (byte idx = 0 ; idx < EVENT_SUBSCRIBER_COUNT ; idx++) {
+    if (pgm_read_byte(&eventSubscribers[idx].event) == event) {
+      EventHandler handler = (EventHandler) pgm_read_ptr(&eventSubscribers[idx].handler);
+      handler();
+    }
+  }
+}
+
+// ************************************************************
+// One armed bandit trigger every 10th minute
+// ************************************************************
+void startACPIfDue() {
+  if ((currentMode == MODE_DIGIT_BURN) || (nextMode == MODE_DIGIT_BURN) || (acpOffset > 0)) {
+    return;
+  }
+
+  if (((minute() % 10) == 9) && (second() == 15)) {
+    // suppress ACP when fully dimmed
+    if (suppressACP) {
+      if (digitOffCount > minDim) {
+        acpOffset = 1;
+      }
+    } else {
+      acpOffset = 1;
+    }
+  }
+}
+
+// ************************************************************
+// Start the slots effect at 50 seconds past the minute, when
+// we are showing the time
+// ************************************************************
+void startSlotsIfDue() {
+  if ((slotsMode == SLOTS_MODE_MIN) || (second() != 50)) {
+    return;
+  }
+
+  if ((currentMode != MODE_TIME) || (nextMode != MODE_TIME) || (tempDisplayModeDuration > 0) || (acpOffset > 0)) {
+    return;
+  }
+
+  // initialise the slots values
+  loadNumberArrayDate();
+  transition.setAlternateValues();
+  loadNumberArrayTime();
+  transition.setRegularValues();
+  allFadeOrNormal(DO_NOT_APPLY_LEAD_0_BLANK);
+
+  transition.start(nowMillis);
+}
+
+// ************************************************************
+// Store the EEPROM when we go back to showing the time
+// ************************************************************
+void saveOptionsOnConfigExit() {
+  if (currentMode == MODE_MIN) {
+    saveEEPROMValues();
+
+    // Preset the display
+    allFadeOrNormal(DO_NOT_APPLY_LEAD_0_BLANK);
+  }
+}
+
+//**********************************************************************************
+//**********************************************************************************
+//*                             Stopwatch and countdown                            *
+//**********************************************************************************
+//**********************************************************************************
+
+// ************************************************************
+// Timer 0 compare interrupt, once per timer 0 cycle. We add up
+// the cycles until we have 1/100 second, then count the digits
+// on: no division needed to show them.
+// ************************************************************
+ISR(TIMER0_COMPA_vect) {
+  for (byte timer = 0 ; timer < TIMER_COUNT ; timer++) {
+    if (!timerRunning[timer]) {
+      continue;
+    }
+
+    timerMicros[timer] += TIMER_US_PER_TICK;
+    if (timerMicros[timer] < TIMER_US_PER_CENTISEC) {
+      continue;
+    }
+    timerMicros[timer] -= TIMER_US_PER_CENTISEC;
+
+    if (timer == TIMER_STOPWATCH) {
+      if (!incrementTimerDigits(timerDigits[timer])) {
+        // 99:59.99 is as far as we go
+        timerRunning[timer] = false;
+      }
+    } else {
+      if (!decrementTimerDigits(timerDigits[timer])) {
+        timerRunning[timer] = false;
+        countdownExpired = true;
+      }
+    }
+  }
+}
+
+// ************************************************************
+// Count the digits up by 1/100 second. Returns false if they
+// would overflow, and leaves them at the maximum.
+// ************************************************************
+boolean incrementTimerDigits(volatile byte* digits) {
+  byte i = 6;
+  while (i > 0) {
+    i--;
+    if (digits[i] < timerDigitMax[i]) {
+      digits[i]++;
+      return true;
+    }
+    digits[i] = 0;
+  }
+
+  for (i = 0 ; i < 6 ; i++) {
+    digits[i] = timerDigitMax[i];
+  }
+  return false;
+}
+
+// ************************************************************
+// Count the digits down by 1/100 second. Returns false when
+// they get to zero.
+// ************************************************************
+boolean decrementTimerDigits(volatile byte* digits) {
+  byte i = 6;
+  while (i > 0) {
+    i--;
+    if (digits[i] > 0) {
+      digits[i]--;
+      break;
+    }
+    digits[i] = timerDigitMax[i];
+  }
+
+  for (i = 0 ; i < 6 ; i++) {
+    if (digits[i] != 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// ************************************************************
+// Start a timer, unless it is a countdown with nothing to do
+// ************************************************************
+void startTimer(byte timer) {
+  if ((timer == TIMER_COUNTDOWN) && !timerHasTimeLeft(timer)) {
+    return;
+  }
+
+  timerAtStart[timer] = false;
+  timerRunning[timer] = true;
+}
+
+// ************************************************************
+// Stop a timer and set it back to the start
+// ************************************************************
+void resetTimer(byte timer) {
+  byte oldSREG = SREG;
+  cli();
+  timerRunning[timer] = false;
+  timerMicros[timer] = 0;
+  for (byte i = 0 ; i < 6 ; i++) {
+    if (timer == TIMER_COUNTDOWN) {
+      timerDigits[timer][i] = countdownPreset[i];
+    } else {
+      timerDigits[timer][i] = 0;
+    }
+  }
+  SREG = oldSREG;
+
+  timerAtStart[timer] = true;
+}
+
+// ************************************************************
+// One button does it all: start, stop, back to the start
+// ************************************************************
+void pressTimerButton(byte timer) {
+  if (timerRunning[timer]) {
+    timerRunning[timer] = false;
+  } else if (timerAtStart[timer]) {
+    startTimer(timer);
+  } else {
+    resetTimer(timer);
+  }
+}
+
+// ************************************************************
+// Set the time the countdown starts from. If it isn't running
+// we load it straight away.
+// ************************************************************
+void setCountdown(byte mins, byte secs) {
+  countdownPreset[0] = mins / 10;
+  countdownPreset[1] = mins % 10;
+  countdownPreset[2] = secs / 10;
+  countdownPreset[3] = secs % 10;
+  countdownPreset[4] = 0;
+  countdownPreset[5] = 0;
+
+  if (!timerRunning[TIMER_COUNTDOWN]) {
+    resetTimer(TIMER_COUNTDOWN);
+  }
+}
+
+// ************************************************************
+// True if the timer isn't showing all zeros
+// ************************************************************
+boolean timerHasTimeLeft(byte timer) {
+  for (byte i = 0 ; i < 6 ; i++) {
+    if (timerDigits[timer][i] != 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// ************************************************************
+// True if the mode shows one of the timers
+// ************************************************************
+boolean isTimerMode(byte mode) {
+  return (mode == MODE_STOPWATCH) || (mode == MODE_COUNTDOWN);
+}
+
+//**********************************************************************************
+//**********************************************************************************
+//*                              Cathode rejuvenation                              *
+//**********************************************************************************
+//**********************************************************************************
+
+// ************************************************************
+// Start a new program. Called from the I2C interrupt, so only
+// set it up: the main loop saves it.
+// ************************************************************
+void startRejuvenation(byte tubes, unsigned int cathodes, byte duty, byte stepMins) {
+  rejuvTubes = tubes & 0x3f;
+  rejuvCathodes = cathodes & 0x3ff;
+  rejuvDuty = constrain(duty, REJUV_DUTY_MIN, REJUV_DUTY_MAX);
+  rejuvStepMins = constrain(stepMins, REJUV_STEP_MINS_MIN, REJUV_STEP_MINS_MAX);
+  rejuvStep = findRejuvStep(0);
+  rejuvStepDone = 0;
+  rejuvSagSkips = 0;
+  rejuvWorstSag = 0;
+  if (rejuvStep < REJUV_STEPS) {
+    rejuvState = I2C_REJUV_STATE_WAITING;
+  } else {
+    rejuvState = I2C_REJUV_STATE_DONE;
+  }
+}
+
+// ************************************************************
+// If the program burns this cathode of this tube
+// ************************************************************
+boolean isRejuvStep(byte step) {
+  return (rejuvTubes & (1 << (step / 10))) && (rejuvCathodes & (1 << (step % 10)));
+}
+
+// ************************************************************
+// Find the first step in the program at or after the given
+// one, REJUV_STEPS if there are none left
+// ************************************************************
+byte findRejuvStep(byte step) {
+  while ((step < REJUV_STEPS) && !isRejuvStep(step)) {
+    step++;
+  }
+  return step;
+}
+
+// ************************************************************
+// Decide if we burn this time round the loop: only when the
+// program is waiting and the tubes are blanked in time mode.
+// While we burn, watch for the HV sagging under the load.
+// ************************************************************
+void updateRejuvenation() {
+  boolean burnNow = (rejuvState == I2C_REJUV_STATE_WAITING) &&
+                    blanked && blankTubes &&
+                    (currentMode == MODE_TIME) && (nextMode == MODE_TIME);
+
+  if (burnNow != rejuvBurning) {
+    rejuvBurning = burnNow;
+    rejuvBurnStartMillis = nowMillis;
+    digitOff();
+  }
+
+  if (rejuvBurning && (nowMillis - rejuvBurnStartMillis > REJUV_SETTLE_MS)) {
+    int sag = rawHVADCThreshold - (int) sensorHVSmoothed;
+    if (sag > rejuvWorstSag) {
+      rejuvWorstSag = sag;
+    }
+
+    // The supply can't hold this cathode, don't cook it
+    if (sag > REJUV_SAG_LIMIT_RAW) {
+      rejuvSagSkips++;
+      advanceRejuvenation();
+    }
+  }
+}
+
+// ************************************************************
+// Drive the cathode we are healing for one frame, on for the
+// duty in the program
+// ************************************************************
+void outputRejuvenation() {
+  int onTime = (long) DIGIT_DISPLAY_COUNT * rejuvDuty / 100;
+
+  digitOff();
+  digitOn(rejuvStep / 10, rejuvStep % 10);
+  for (int timer = 0 ; timer < DIGIT_DISPLAY_COUNT ; timer++) {
+    if (timer == onTime) {
+      digitOff();
+    }
+  }
+}
+
+// ************************************************************
+// Count the minutes we burned, move on when the step is done
+// and checkpoint every so often in case we lose power. Only a
+// minute we burned all of counts: the part minutes at the start
+// and end of a burn are left out, so we never count more than
+// the cathode got.
+// ************************************************************
+void stepRejuvenation() {
+  if (!rejuvBurning || (nowMillis - rejuvBurnStartMillis < SECS_PER_MIN * 1000UL)) {
+    return;
+  }
+
+  rejuvStepDone++;
+  if (rejuvStepDone >= rejuvStepMins) {
+    advanceRejuvenation();
+  } else if ((rejuvStepDone % REJUV_CHECKPOINT_MINS) == 0) {
+    checkpointRejuvenation();
+  }
+}
+
+// ************************************************************
+// Go on to the next step of the program
+// ************************************************************
+void advanceRejuvenation() {
+  digitOff();
+  rejuvStep = findRejuvStep(rejuvStep + 1);
+  rejuvStepDone = 0;
+  rejuvWorstSag = 0;
+  rejuvBurnStartMillis = nowMillis;
+  if (rejuvStep >= REJUV_STEPS) {
+    rejuvState = I2C_REJUV_STATE_DONE;
+    rejuvBurning = false;
+  }
+  checkpointRejuvenation();
+}
+
+// ************************************************************
+// Save how far we got
+// ************************************************************
+void checkpointRejuvenation() {
+  EEPROM.update(EE_REJUV_STATE, rejuvState);
+  EEPROM.update(EE_REJUV_STEP, rejuvStep);
+  EEPROM.update(EE_REJUV_STEP_DONE, rejuvStepDone);
+  EEPROM.update(EE_REJUV_SAG_SKIPS, rejuvSagSkips);
+}
+
+//**********************************************************************************
+//**********************************************************************************
+//*                                   Self test                                    *
+//**********************************************************************************
+//**********************************************************************************
+
+// ************************************************************
+// Check the hardware and record the result where the master
+// can read it. Takes about 2 seconds, most of it loading the HV
+// with each anode and cathode in turn.
+// ************************************************************
+void runSelfTest() {
+  selfTestFailed = 0;
+  byte selfTestStatus = I2C_SELF_TEST_RAN;
+
+  // HV under load: every anode with every cathode. A short pulls the
+  // supply down, so a cathode that fails on every tube is a cathode
+  // line fault, one that fails on a single tube is in that tube.
+  byte anodesFailed = 0;
+  unsigned int cathodesFailed = 0;
+  int worstSag = 0;
+
+  // The HV generator only runs while a digit is on
+  unsigned long settleStart = millis();
+  digitOn(0, 0);
+  while (millis() - settleStart < SELF_TEST_SETTLE_MS) {
+    checkHVVoltage();
+  }
+  digitOff();
+
+  for (byte tube = 0 ; tube < 6 ; tube++) {
+    for (byte cathode = 0 ; cathode < 10 ; cathode++) {
+      digitOn(tube, cathode);
+      unsigned long stepStart = millis();
+      while (millis() - stepStart < SELF_TEST_STEP_MS) {
+        checkHVVoltage();
+      }
+      int sag = rawHVADCThreshold - (int) sensorHVSmoothed;
+      digitOff();
+
+      if (sag > worstSag) {
+        worstSag = sag;
+      }
+      if (sag > SELF_TEST_SAG_LIMIT_RAW) {
+        anodesFailed |= (1 << tube);
+        cathodesFailed |= (1 << cathode);
+        selfTestFailed |= I2C_SELF_TEST_HV;
+      }
+    }
+  }
+
+  // LEDs: we can't measure the current, but we can see if the pins follow
+  // what we drive them to, which finds shorts on the LED lines
+  const byte ledPins[4] = {RLed, GLed, BLed, tickLed};
+  byte ledsFailed = 0;
+  for (byte led = 0 ; led < 4 ; led++) {
+    analogWrite(ledPins[led], 255);
+    delayMicroseconds(50);
+    if (digitalRead(ledPins[led]) != HIGH) {
+      ledsFailed |= (1 << led);
+    }
+    analogWrite(ledPins[led], 0);
+    delayMicroseconds(50);
+    if (digitalRead(ledPins[led]) != LOW) {
+      ledsFailed |= (1 << led);
+    }
+  }
+  if (ledsFailed != 0) {
+    selfTestFailed |= I2C_SELF_TEST_LEDS;
+  }
+
+  // RTC: there and running
+#ifdef RTC_DIRECT
+  startI2CMaster();
+  Wire.beginTransmission(RTC_I2C_ADDRESS);
+  boolean rtcFound = (Wire.endTransmission() == 0);
+  if (!rtcFound || !Clock.oscillatorCheck()) {
+    selfTestFailed |= I2C_SELF_TEST_RTC;
+  }
+  startI2CSlave();
+#else
+  // The RTC is on the WiFi module, it has to check it
+  selfTestStatus |= I2C_SELF_TEST_RTC_SKIPPED;
+#endif
+
+  // LDR: a reading at either rail is an open or short
+  int ldrReading = analogRead(LDRPin);
+  if ((ldrReading < SELF_TEST_LDR_MIN) || (ldrReading > SELF_TEST_LDR_MAX)) {
+    selfTestFailed |= I2C_SELF_TEST_LDR;
+  }
+
+  // EEPROM: write and read back both bit patterns in the scratch byte
+  EEPROM.write(EE_SELF_TEST, 0x55);
+  boolean eepromOK = (EEPROM.read(EE_SELF_TEST) == 0x55);
+  EEPROM.write(EE_SELF_TEST, 0xaa);
+  eepromOK &= (EEPROM.read(EE_SELF_TEST) == 0xaa);
+  if (!eepromOK) {
+    selfTestFailed |= I2C_SELF_TEST_EEPROM;
+  }
+
+  byte nextShadow = 1 - i2cSelfTestShadowActive;
+  byte* testArray = i2cSelfTestShadow[nextShadow];
+  testArray[I2C_SELF_TEST_OPCODE] = I2C_GET_SELF_TEST;
+  testArray[I2C_SELF_TEST_STATUS] = selfTestStatus;
+  testArray[I2C_SELF_TEST_FAILED] = selfTestFailed;
+  testArray[I2C_SELF_TEST_ANODES] = anodesFailed;
+  testArray[I2C_SELF_TEST_CATHODES_HI] = cathodesFailed / 256;
+  testArray[I2C_SELF_TEST_CATHODES_LO] = cathodesFailed % 256;
+  testArray[I2C_SELF_TEST_SAG] = constrain(getHVVoltsFromRaw(worstSag), 0, 255);
+  testArray[I2C_SELF_TEST_LEDS_FAILED] = ledsFailed;
+  testArray[I2C_SELF_TEST_LDR_HI] = ldrReading / 256;
+  testArray[I2C_SELF_TEST_LDR_LO] = ldrReading % 256;
+  i2cSelfTestShadowActive = nextShadow;
+}
+
+//**********************************************************************************
+//**********************************************************************************
+//*                                    Alarms                                      *
+//**********************************************************************************
+//**********************************************************************************
+
+// ************************************************************
+// Work out when the next alarm is due. This looks up to a week
+// ahead for each alarm, so we only do it when the schedule
+// changes, an alarm has gone off or the time was changed.
+// ************************************************************
+void computeNextAlarm() {
+  time_t timeNow = now();
+  nextAlarmTime = 0;
+
+  for (byte alarm = 0 ; alarm < ALARM_COUNT ; alarm++) {
+    if (alarmDays[alarm] == 0) {
+      continue;
+    }
+
+    time_t alarmTime = previousMidnight(timeNow) + alarmHour[alarm] * SECS_PER_HOUR + alarmMinute[alarm] * SECS_PER_MIN;
+    for (byte dayOffset = 0 ; dayOffset < 8 ; dayOffset++) {
+      if ((alarmTime > timeNow) && (alarmDays[alarm] & (1 << (weekday(alarmTime) - 1)))) {
+        if ((nextAlarmTime == 0) || (alarmTime < nextAlarmTime)) {
+          nextAlarmTime = alarmTime;
+          nextAlarm = alarm;
+        }
+        break;
+      }
+      alarmTime += SECS_PER_DAY;
+    }
+  }
+}
+
+// ************************************************************
+// Called once a minute: set off the next alarm if it is due
+// ************************************************************
+void checkAlarms() {
+  time_t timeNow = now();
+
+  // If the time was changed, the alarm we lined up may be wrong.
+  // We don't set off alarms we jumped over.
+  if ((timeNow < lastAlarmCheck) || (timeNow > lastAlarmCheck + ALARM_MAX_CHECK_GAP_SECS)) {
+    computeNextAlarm();
+  }
+  lastAlarmCheck = timeNow;
+
+  if ((nextAlarmTime != 0) && (timeNow >= nextAlarmTime)) {
+    triggerAlarm(alarmAction[nextAlarm]);
+    computeNextAlarm();
+  }
+}
+
+// ************************************************************
+// Do what the alarm asks for
+// ************************************************************
+void triggerAlarm(byte action) {
+  if (action & I2C_ALARM_ACTION_UNBLANK) {
+    // Don't cut short a longer suppression from the button
+    blankSuppressedMillis = max(blankSuppressedMillis, (unsigned long) ALARM_UNBLANK_MS);
+  }
+
+  if (action & I2C_ALARM_ACTION_FLASH) {
+    alarmFlashing = true;
+    alarmFlashStartMillis = nowMillis;
+  }
+
+  if (action & I2C_ALARM_ACTION_EFFECT) {
+    // Run the one armed bandit
+    acpOffset = 1;
+  }
+}
+
 //**********************************************************************************
 //**********************************************************************************
 //*                               EEPROM interface                                 *
@@ -2752,40 +3905,64 @@ float getRTCTemp() {
 
 // ************************************************************
 // Save current values back to EEPROM
+// Only bytes that changed are written, to save time and wear
 // ************************************************************
 void saveEEPROMValues() {
-  EEPROM.write(EE_12_24, hourMode);
-  EEPROM.write(EE_FADE_STEPS, fadeSteps);
-  EEPROM.write(EE_DATE_FORMAT, dateFormat);
-  EEPROM.write(EE_DAY_BLANKING, dayBlanking);
-  EEPROM.write(EE_DIM_DARK_LO, dimDark % 256);
-  EEPROM.write(EE_DIM_DARK_HI, dimDark / 256);
-  EEPROM.write(EE_BLANK_LEAD_ZERO, blankLeading);
-  EEPROM.write(EE_SCROLLBACK, scrollback);
-  EEPROM.write(EE_FADE, fade);
-  EEPROM.write(EE_SCROLL_STEPS, scrollSteps);
-  EEPROM.write(EE_DIM_BRIGHT_LO, dimBright % 256);
-  EEPROM.write(EE_DIM_BRIGHT_HI, dimBright / 256);
-  EEPROM.write(EE_DIM_SMOOTH_SPEED, sensorSmoothCountLDR);
-  EEPROM.write(EE_RED_INTENSITY, redCnl);
-  EEPROM.write(EE_GRN_INTENSITY, grnCnl);
-  EEPROM.write(EE_BLU_INTENSITY, bluCnl);
-  EEPROM.write(EE_BACKLIGHT_MODE, backlightMode);
-  EEPROM.write(EE_HV_VOLTAGE, hvTargetVoltage);
-  EEPROM.write(EE_SUPPRESS_ACP, suppressACP);
-  EEPROM.write(EE_HOUR_BLANK_START, blankHourStart);
-  EEPROM.write(EE_HOUR_BLANK_END, blankHourEnd);
-  EEPROM.write(EE_CYCLE_SPEED, cycleSpeed);
-  EEPROM.write(EE_PULSE_LO, pwmOn % 256);
-  EEPROM.write(EE_PULSE_HI, pwmOn / 256);
-  EEPROM.write(EE_PWM_TOP_LO, pwmTop % 256);
-  EEPROM.write(EE_PWM_TOP_HI, pwmTop / 256);
-  EEPROM.write(EE_MIN_DIM_LO, minDim % 256);
-  EEPROM.write(EE_MIN_DIM_HI, minDim / 256);
-  EEPROM.write(EE_ANTI_GHOST, antiGhost);
-  EEPROM.write(EE_USE_LDR, useLDR);
-  EEPROM.write(EE_BLANK_MODE, blankMode);
-  EEPROM.write(EE_SLOTS_MODE, slotsMode);
+  EEPROM.update(EE_12_24, hourMode);
+  EEPROM.update(EE_FADE_STEPS, fadeSteps);
+  EEPROM.update(EE_DATE_FORMAT, dateFormat);
+  EEPROM.update(EE_DAY_BLANKING, dayBlanking);
+  EEPROM.update(EE_DIM_DARK_LO, dimDark % 256);
+  EEPROM.update(EE_DIM_DARK_HI, dimDark / 256);
+  EEPROM.update(EE_BLANK_LEAD_ZERO, blankLeading);
+  EEPROM.update(EE_SCROLLBACK, scrollback);
+  EEPROM.update(EE_FADE, fade);
+  EEPROM.update(EE_SCROLL_STEPS, scrollSteps);
+  EEPROM.update(EE_DIM_BRIGHT_LO, dimBright % 256);
+  EEPROM.update(EE_DIM_BRIGHT_HI, dimBright / 256);
+  EEPROM.update(EE_DIM_SMOOTH_SPEED, sensorSmoothCountLDR);
+  EEPROM.update(EE_RED_INTENSITY, redCnl);
+  EEPROM.update(EE_GRN_INTENSITY, grnCnl);
+  EEPROM.update(EE_BLU_INTENSITY, bluCnl);
+  EEPROM.update(EE_BACKLIGHT_MODE, backlightMode);
+  EEPROM.update(EE_HV_VOLTAGE, hvTargetVoltage);
+  EEPROM.update(EE_SUPPRESS_ACP, suppressACP);
+  EEPROM.update(EE_HOUR_BLANK_START, blankHourStart);
+  EEPROM.update(EE_HOUR_BLANK_END, blankHourEnd);
+  EEPROM.update(EE_CYCLE_SPEED, cycleSpeed);
+  EEPROM.update(EE_PULSE_LO, pwmOn % 256);
+  EEPROM.update(EE_PULSE_HI, pwmOn / 256);
+  EEPROM.update(EE_PWM_TOP_LO, pwmTop % 256);
+  EEPROM.update(EE_PWM_TOP_HI, pwmTop / 256);
+  EEPROM.update(EE_MIN_DIM_LO, minDim % 256);
+  EEPROM.update(EE_MIN_DIM_HI, minDim / 256);
+  EEPROM.update(EE_ANTI_GHOST, antiGhost);
+  EEPROM.update(EE_USE_LDR, useLDR);
+  EEPROM.update(EE_BLANK_MODE, blankMode);
+  EEPROM.update(EE_SLOTS_MODE, slotsMode);
+  if (rtcAgingKnown) {
+    saveRTCAgingOffset();
+  }
+  EEPROM.update(EE_SUB_SLOTS, subSlots);
+  EEPROM.update(EE_ROLL_MODE, rollMode);
+
+  EEPROM.update(EE_REJUV_TUBES, rejuvTubes);
+  EEPROM.update(EE_REJUV_CATHODES_LO, rejuvCathodes % 256);
+  EEPROM.update(EE_REJUV_CATHODES_HI, rejuvCathodes / 256);
+  EEPROM.update(EE_REJUV_DUTY, rejuvDuty);
+  EEPROM.update(EE_REJUV_STEP_MINS, rejuvStepMins);
+  checkpointRejuvenation();
+
+  for (byte alarm = 0 ; alarm < ALARM_COUNT ; alarm++) {
+    int alarmAddr = EE_ALARM_BASE + alarm * EE_ALARM_SIZE;
+    EEPROM.update(alarmAddr, alarmHour[alarm]);
+    EEPROM.update(alarmAddr + 1, alarmMinute[alarm]);
+    EEPROM.update(alarmAddr + 2, alarmDays[alarm]);
+    EEPROM.update(alarmAddr + 3, alarmAction[alarm]);
+  }
+
+  // What we saved is what the master gets to see
+  updateI2CShadow();
 }
 
 // ************************************************************
@@ -2914,6 +4091,69 @@ void readEEPROMValues() {
     slotsMode = SLOTS_MODE_DEFAULT;
   }
 
+  subSlots = EEPROM.read(EE_SUB_SLOTS);
+  if ((subSlots < SUB_SLOTS_MIN) || (subSlots > SUB_SLOTS_MAX)) {
+    subSlots = SUB_SLOTS_DEFAULT;
+  }
+
+  rollMode = EEPROM.read(EE_ROLL_MODE);
+  if ((rollMode < ROLL_MODE_MIN) || (rollMode > ROLL_MODE_MAX)) {
+    rollMode = ROLL_MODE_DEFAULT;
+  }
+
+  rejuvTubes = EEPROM.read(EE_REJUV_TUBES) & 0x3f;
+  rejuvCathodes = (EEPROM.read(EE_REJUV_CATHODES_HI) * 256 + EEPROM.read(EE_REJUV_CATHODES_LO)) & 0x3ff;
+  rejuvDuty = EEPROM.read(EE_REJUV_DUTY);
+  if ((rejuvDuty < REJUV_DUTY_MIN) || (rejuvDuty > REJUV_DUTY_MAX)) {
+    rejuvDuty = REJUV_DUTY_DEFAULT;
+  }
+  rejuvStepMins = EEPROM.read(EE_REJUV_STEP_MINS);
+  if ((rejuvStepMins < REJUV_STEP_MINS_MIN) || (rejuvStepMins > REJUV_STEP_MINS_MAX)) {
+    rejuvStepMins = REJUV_STEP_MINS_DEFAULT;
+  }
+
+  // Pick up a program where we left it
+  rejuvState = EEPROM.read(EE_REJUV_STATE);
+  rejuvStep = EEPROM.read(EE_REJUV_STEP);
+  rejuvStepDone = EEPROM.read(EE_REJUV_STEP_DONE);
+  rejuvSagSkips = EEPROM.read(EE_REJUV_SAG_SKIPS);
+  if ((rejuvState != I2C_REJUV_STATE_WAITING) && (rejuvState != I2C_REJUV_STATE_PAUSED) && (rejuvState != I2C_REJUV_STATE_DONE)) {
+    rejuvState = I2C_REJUV_STATE_IDLE;
+  }
+  // Only a finished program is past the last step, anything else
+  // would burn a tube we don't have
+  if (((rejuvStep >= REJUV_STEPS) && (rejuvState != I2C_REJUV_STATE_DONE)) || (rejuvStepDone >= rejuvStepMins)) {
+    rejuvState = I2C_REJUV_STATE_IDLE;
+    rejuvStep = 0;
+    rejuvStepDone = 0;
+  }
+  if (rejuvState == I2C_REJUV_STATE_IDLE) {
+    rejuvSagSkips = 0;
+  }
+
+  // Every value of the offset byte is a real offset (an erased one reads
+  // as -1), so a separate byte says if we saved one. If we didn't, or it
+  // is out of range, getRTCTime() reads the offset back from the RTC.
+  byte agingByte = EEPROM.read(EE_RTC_AGING);
+  rtcAgingKnown = (EEPROM.read(EE_RTC_AGING_VALID) == RTC_AGING_VALID) && ((signed char) agingByte >= RTC_AGING_MIN);
+  rtcAgingOffset = rtcAgingKnown ? (signed char) agingByte : 0;
+
+  for (byte alarm = 0 ; alarm < ALARM_COUNT ; alarm++) {
+    int alarmAddr = EE_ALARM_BASE + alarm * EE_ALARM_SIZE;
+    alarmHour[alarm] = EEPROM.read(alarmAddr);
+    alarmMinute[alarm] = EEPROM.read(alarmAddr + 1);
+    alarmDays[alarm] = EEPROM.read(alarmAddr + 2) & 0x7f;
+    alarmAction[alarm] = EEPROM.read(alarmAddr + 3);
+    if ((alarmHour[alarm] > 23) || (alarmMinute[alarm] > 59)) {
+      alarmHour[alarm] = 0;
+      alarmMinute[alarm] = 0;
+      alarmDays[alarm] = 0;
+      alarmAction[alarm] = 0;
+    }
+  }
+
+  updateI2CShadow();
+  updateI2CRejuvShadow();
 }
 
 // ************************************************************
@@ -2949,6 +4189,26 @@ void factoryReset() {
   useLDR = USE_LDR_DEFAULT;
   blankMode = BLANK_MODE_DEFAULT;
   slotsMode = SLOTS_MODE_DEFAULT;
+  subSlots = SUB_SLOTS_DEFAULT;
+  rollMode = ROLL_MODE_DEFAULT;
+  rtcAgingOffset = 0;
+  rtcAgingKnown = true;
+
+  rejuvState = I2C_REJUV_STATE_IDLE;
+  rejuvTubes = 0;
+  rejuvCathodes = 0;
+  rejuvDuty = REJUV_DUTY_DEFAULT;
+  rejuvStepMins = REJUV_STEP_MINS_DEFAULT;
+  rejuvStep = 0;
+  rejuvStepDone = 0;
+  rejuvSagSkips = 0;
+
+  for (byte alarm = 0 ; alarm < ALARM_COUNT ; alarm++) {
+    alarmHour[alarm] = 0;
+    alarmMinute[alarm] = 0;
+    alarmDays[alarm] = 0;
+    alarmAction[alarm] = 0;
+  }
 
   saveEEPROMValues();
 }
@@ -2994,6 +4254,14 @@ int getRawHVADCThreshold(double targetVoltage) {
   return rawReading;
 }
 
+// ************************************************************
+// And back again: the voltage for a raw ADC difference
+// ************************************************************
+int getHVVoltsFromRaw(int rawReading) {
+  double externalVoltage = rawReading * 5.0 / 1023 * 394.7 / 4.7;
+  return (int) externalVoltage;
+}
+
 //**********************************************************************************
 //**********************************************************************************
 //*                          Light Dependent Resistor                              *
@@ -3007,8 +4275,8 @@ int getRawHVADCThreshold(double targetVoltage) {
 // The LDR in bright light gives reading of around 50, the reading in
 // total darkness is around 900.
 //
-// The return value is the dimming count we are using. 999 is full
-// brightness, 100 is very dim.
+// The return value is the dimming count we are using, in
+// 1/DITHER_SCALE ticks. 999 ticks is full brightness, 100 is very dim.
 //
 // Because the floating point calculation may return more than the
 // maximum value, we have to clamp it as the final step
@@ -3016,21 +4284,17 @@ int getRawHVADCThreshold(double targetVoltage) {
 int getDimmingFromLDR() {
   if (useLDR) {
     int rawSensorVal = 1023 - analogRead(LDRPin);
-    double sensorDiff = rawSensorVal - sensorLDRSmoothed;
-    sensorLDRSmoothed += (sensorDiff / sensorSmoothCountLDR);
+    sensorLDRSmoothed = smoothSensorReading(sensorLDRSmoothed, rawSensorVal, sensorSmoothCountLDR);
 
-    double sensorSmoothedResult = sensorLDRSmoothed - dimDark;
-    if (sensorSmoothedResult < dimDark) sensorSmoothedResult = dimDark;
-    if (sensorSmoothedResult > dimBright) sensorSmoothedResult = dimBright;
-    sensorSmoothedResult = (sensorSmoothedResult - dimDark) * sensorFactor;
+    double sensorSmoothedResult = getBrightnessFromSensor(sensorLDRSmoothed, dimDark, dimBright, sensorFactor);
 
-    int returnValue = sensorSmoothedResult;
+    int returnValue = sensorSmoothedResult * DITHER_SCALE;
 
-    if (returnValue < minDim) returnValue = minDim;
-    if (returnValue > DIGIT_DISPLAY_OFF) returnValue = DIGIT_DISPLAY_OFF;
+    if (returnValue < minDim * DITHER_SCALE) returnValue = minDim * DITHER_SCALE;
+    if (returnValue > DIGIT_DISPLAY_OFF * DITHER_SCALE) returnValue = DIGIT_DISPLAY_OFF * DITHER_SCALE;
     return returnValue;
   } else {
-    return DIGIT_DISPLAY_OFF;  
+    return DIGIT_DISPLAY_OFF * DITHER_SCALE;
   }
 }
 
@@ -3205,8 +4469,7 @@ void decPWMOnTime() {
 */
 int getSmoothedHVSensorReading() {
   int rawSensorVal = analogRead(sensorPin);
-  double sensorDiff = rawSensorVal - sensorHVSmoothed;
-  sensorHVSmoothed += (sensorDiff / sensorSmoothCountHV);
+  sensorHVSmoothed = smoothSensorReading(sensorHVSmoothed, rawSensorVal, sensorSmoothCountHV);
   int sensorHVSmoothedInt = (int) sensorHVSmoothed;
   return sensorHVSmoothedInt;
 }
@@ -3219,6 +4482,10 @@ int getSmoothedHVSensorReading() {
 
 /**
  * receive information from the master
+ *
+ * Option writes only update the running value and bump the received sequence
+ * number. Saving to EEPROM takes ~3.3mS a byte, too long for the interrupt, so
+ * the main loop does that and reports it via the status block.
  */
 void receiveEvent(int bytes) {
   // the operation tells us what we are getting
@@ -3227,6 +4494,7 @@ void receiveEvent(int bytes) {
   if (operation == I2C_TIME_UPDATE) {
     // If we're getting time from the WiFi module, mark that we have an active WiFi with a 5 min time out
     useWiFi = MAX_WIFI_TIME;
+    timeSyncReceived = true;
 
     int newYears = Wire.read();
     int newMonths = Wire.read();
@@ -3240,52 +4508,52 @@ void receiveEvent(int bytes) {
   } else if (operation == I2C_SET_OPTION_12_24) {
     byte readByte1224 = Wire.read();
     hourMode = (readByte1224 == 1);
-    EEPROM.write(EE_12_24, true);
+    i2cOptionsReceived++;
   } else if (operation == I2C_SET_OPTION_BLANK_LEAD) {
     byte readByteBlank = Wire.read();
     blankLeading = (readByteBlank == 1);
-    EEPROM.write(EE_BLANK_LEAD_ZERO, blankLeading);
+    i2cOptionsReceived++;
   } else if (operation == I2C_SET_OPTION_SCROLLBACK) {
     byte readByteSB = Wire.read();
     scrollback = (readByteSB == 1);
-    EEPROM.write(EE_SCROLLBACK, scrollback);
+    i2cOptionsReceived++;
   } else if (operation == I2C_SET_OPTION_SUPPRESS_ACP) {
     byte readByteSA = Wire.read();
     suppressACP = (readByteSA == 1);
-    EEPROM.write(EE_SUPPRESS_ACP, suppressACP);
+    i2cOptionsReceived++;
   } else if (operation == I2C_SET_OPTION_DATE_FORMAT) {
     dateFormat = Wire.read();
-    EEPROM.write(EE_DATE_FORMAT, dateFormat);
+    i2cOptionsReceived++;
   } else if (operation == I2C_SET_OPTION_DAY_BLANKING) {
     dayBlanking = Wire.read();
-    EEPROM.write(EE_DAY_BLANKING, dayBlanking);
+    i2cOptionsReceived++;
   } else if (operation == I2C_SET_OPTION_BLANK_START) {
     blankHourStart = Wire.read();
-    EEPROM.write(EE_HOUR_BLANK_START, blankHourStart);
+    i2cOptionsReceived++;
   } else if (operation == I2C_SET_OPTION_BLANK_END) {
     blankHourEnd = Wire.read();
-    EEPROM.write(EE_HOUR_BLANK_END, blankHourEnd);
+    i2cOptionsReceived++;
   } else if (operation == I2C_SET_OPTION_FADE_STEPS) {
     fadeSteps = Wire.read();
-    EEPROM.write(EE_FADE_STEPS, fadeSteps);
+    i2cOptionsReceived++;
   } else if (operation == I2C_SET_OPTION_SCROLL_STEPS) {
     scrollSteps = Wire.read();
-    EEPROM.write(EE_SCROLL_STEPS, scrollSteps);
+    i2cOptionsReceived++;
   } else if (operation == I2C_SET_OPTION_BACKLIGHT_MODE) {
     backlightMode = Wire.read();
-    EEPROM.write(EE_BACKLIGHT_MODE, backlightMode);
+    i2cOptionsReceived++;
   } else if (operation == I2C_SET_OPTION_RED_CHANNEL) {
     redCnl = Wire.read();
-    EEPROM.write(EE_RED_INTENSITY, redCnl);
+    i2cOptionsReceived++;
   } else if (operation == I2C_SET_OPTION_GREEN_CHANNEL) {
     grnCnl = Wire.read();
-    EEPROM.write(EE_GRN_INTENSITY, grnCnl);
+    i2cOptionsReceived++;
   } else if (operation == I2C_SET_OPTION_BLUE_CHANNEL) {
     bluCnl = Wire.read();
-    EEPROM.write(EE_BLU_INTENSITY, bluCnl);
+    i2cOptionsReceived++;
   } else if (operation == I2C_SET_OPTION_CYCLE_SPEED) {
     cycleSpeed = Wire.read();
-    EEPROM.write(EE_CYCLE_SPEED, cycleSpeed);
+    i2cOptionsReceived++;
   } else if (operation == I2C_SHOW_IP_ADDR) {
     ourIP[0] = Wire.read();
     ourIP[1] = Wire.read();
@@ -3293,23 +4561,130 @@ void receiveEvent(int bytes) {
     ourIP[3] = Wire.read();
   } else if (operation == I2C_SET_OPTION_FADE) {
     fade = Wire.read();
-    EEPROM.write(EE_FADE, fade);
+    i2cOptionsReceived++;
   } else if (operation == I2C_SET_OPTION_USE_LDR) {
     byte readByteUseLDR = Wire.read();
     useLDR = (readByteUseLDR == 1);
-    EEPROM.write(EE_USE_LDR, useLDR);
+    i2cOptionsReceived++;
   } else if (operation == I2C_SET_OPTION_BLANK_MODE) {
     blankMode = Wire.read();
-    EEPROM.write(EE_BLANK_MODE, blankMode);
+    i2cOptionsReceived++;
   } else if (operation == I2C_SET_OPTION_SLOTS_MODE) {
     slotsMode = Wire.read();
-    EEPROM.write(EE_SLOTS_MODE, slotsMode);
+    i2cOptionsReceived++;
+  } else if (operation == I2C_SET_OPTION_ROLL_MODE) {
+    rollMode = Wire.read();
+    i2cOptionsReceived++;
   } else if (operation == I2C_SET_OPTION_MIN_DIM) {
     byte dimHI = Wire.read();
     byte dimLO = Wire.read();
     minDim = dimHI * 256 + dimLO;
-    EEPROM.write(EE_MIN_DIM_HI, dimHI);
-    EEPROM.write(EE_MIN_DIM_LO, dimLO);
+    i2cOptionsReceived++;
+  } else if (operation == I2C_SET_OPTIONS) {
+    // A whole option block in one write, counted and saved as one change
+    if (Wire.available() == I2C_DATA_SIZE) {
+      byte optionBlock[I2C_DATA_SIZE];
+      for (byte idx = 0 ; idx < I2C_DATA_SIZE ; idx++) {
+        optionBlock[idx] = Wire.read();
+      }
+      if (optionBlock[I2C_OPT_PROTOCOL] == I2C_PROTOCOL_NUMBER) {
+        applyI2COptionBlock(optionBlock);
+        i2cOptionsReceived++;
+      }
+    }
+  } else if (operation == I2C_GET_CAPABILITIES) {
+    // The master tells us what it can do, we answer on the next read
+    byte masterCaps = Wire.read();
+    i2cFastMode = ((masterCaps & I2C_CAP_FAST_MODE) != 0);
+    i2cReadBlock = I2C_GET_CAPABILITIES;
+  } else if (operation == I2C_GET_STATUS) {
+    i2cReadBlock = I2C_GET_STATUS;
+  } else if (operation == I2C_SET_ALARM) {
+    byte alarm = Wire.read();
+    byte newHour = Wire.read();
+    byte newMinute = Wire.read();
+    byte newDays = Wire.read();
+    byte newAction = Wire.read();
+    if ((alarm < ALARM_COUNT) && (newHour < 24) && (newMinute < 60)) {
+      alarmHour[alarm] = newHour;
+      alarmMinute[alarm] = newMinute;
+      alarmDays[alarm] = newDays & 0x7f;
+      alarmAction[alarm] = newAction;
+      alarmsChanged = true;
+      i2cOptionsReceived++;
+    }
+  } else if (operation == I2C_GET_ALARMS) {
+    i2cReadBlock = I2C_GET_ALARMS;
+  } else if (operation == I2C_REJUV_CONTROL) {
+    byte command = Wire.read();
+    if (command == I2C_REJUV_CMD_START) {
+      byte tubes = Wire.read();
+      byte cathodesHI = Wire.read();
+      byte cathodesLO = Wire.read();
+      byte duty = Wire.read();
+      byte stepMins = Wire.read();
+      startRejuvenation(tubes, cathodesHI * 256 + cathodesLO, duty, stepMins);
+    } else if ((command == I2C_REJUV_CMD_PAUSE) && (rejuvState == I2C_REJUV_STATE_WAITING)) {
+      rejuvState = I2C_REJUV_STATE_PAUSED;
+    } else if ((command == I2C_REJUV_CMD_RESUME) && (rejuvState == I2C_REJUV_STATE_PAUSED)) {
+      rejuvState = I2C_REJUV_STATE_WAITING;
+    } else if (command == I2C_REJUV_CMD_CANCEL) {
+      rejuvState = I2C_REJUV_STATE_IDLE;
+    }
+    i2cOptionsReceived++;
+  } else if (operation == I2C_GET_REJUV) {
+    i2cReadBlock = I2C_GET_REJUV;
+  } else if (operation == I2C_RUN_SELF_TEST) {
+    selfTestRequested = true;
+  } else if (operation == I2C_GET_SELF_TEST) {
+    i2cReadBlock = I2C_GET_SELF_TEST;
+  } else if (operation == I2C_GET_BOOT_TIMES) {
+    i2cReadBlock = I2C_GET_BOOT_TIMES;
+  } else if (operation == I2C_GET_TELEMETRY) {
+    i2cReadBlock = I2C_GET_TELEMETRY;
+  } else if (operation == I2C_TIMER_CONTROL) {
+    byte timer = Wire.read();
+    byte command = Wire.read();
+    if (timer < TIMER_COUNT) {
+      if (command == I2C_TIMER_CMD_START) {
+        startTimer(timer);
+      } else if (command == I2C_TIMER_CMD_STOP) {
+        timerRunning[timer] = false;
+      } else if (command == I2C_TIMER_CMD_RESET) {
+        resetTimer(timer);
+      }
+    }
+  } else if (operation == I2C_SET_COUNTDOWN) {
+    byte newMins = Wire.read();
+    byte newSecs = Wire.read();
+    if ((newMins < 100) && (newSecs < 60)) {
+      setCountdown(newMins, newSecs);
+    }
+#ifdef RTC_PROXY
+  } else if (operation == I2C_RTC_TIME_UPDATE) {
+    // The WiFi module has read the RTC for us. This doesn't count as WiFi time.
+    int newYears = Wire.read();
+    int newMonths = Wire.read();
+    int newDays = Wire.read();
+
+    int newHours = Wire.read();
+    int newMins = Wire.read();
+    int newSecs = Wire.read();
+
+    byte tempHI = Wire.read();
+    byte tempLO = Wire.read();
+    rtcTemp = ((int) (tempHI * 256 + tempLO)) / 4.0;
+
+    useRTC = true;
+
+    // Don't overwrite a time that was set here, but not yet written to the RTC
+    if (!rtcTimeSetPending) {
+      setTime(newHours, newMins, newSecs, newDays, newMonths, newYears);
+      timeSyncReceived = true;
+    }
+  } else if (operation == I2C_GET_TIME) {
+    i2cReadBlock = I2C_GET_TIME;
+#endif
   }
 }
 
@@ -3317,32 +4692,241 @@ void receiveEvent(int bytes) {
    send information to the master
 */
 void requestEvent() {
-  byte configArray[I2C_DATA_SIZE];
-  int idx = 0;
-  configArray[idx++] = I2C_PROTOCOL_NUMBER;  // protocol version
-  configArray[idx++] = encodeBooleanForI2C(hourMode);
-  configArray[idx++] = encodeBooleanForI2C(blankLeading);
-  configArray[idx++] = encodeBooleanForI2C(scrollback);
-  configArray[idx++] = encodeBooleanForI2C(suppressACP);
-  configArray[idx++] = encodeBooleanForI2C(fade);
-  configArray[idx++] = dateFormat;
-  configArray[idx++] = dayBlanking;
-  configArray[idx++] = blankHourStart;
-  configArray[idx++] = blankHourEnd;
-  configArray[idx++] = fadeSteps;
-  configArray[idx++] = scrollSteps;
-  configArray[idx++] = backlightMode;
-  configArray[idx++] = redCnl;
-  configArray[idx++] = grnCnl;
-  configArray[idx++] = bluCnl;
-  configArray[idx++] = cycleSpeed;
-  configArray[idx++] = encodeBooleanForI2C(useLDR);
-  configArray[idx++] = blankMode;
-  configArray[idx++] = slotsMode;
-  configArray[idx++] = minDim / 256;
-  configArray[idx++] = minDim % 256;
-
-  Wire.write(configArray, I2C_DATA_SIZE);
+  if (i2cReadBlock == I2C_GET_CAPABILITIES) {
+    byte capsArray[I2C_CAPS_SIZE];
+    capsArray[0] = I2C_GET_CAPABILITIES;
+    capsArray[1] = I2C_PROTOCOL_NUMBER;
+#ifdef RTC_PROXY
+    capsArray[2] = I2C_CAP_FAST_MODE | I2C_CAP_STATUS | I2C_CAP_RTC_PROXY;
+#else
+    capsArray[2] = I2C_CAP_FAST_MODE | I2C_CAP_STATUS;
+#endif
+
+    // Back to the default for masters that just read
+    i2cReadBlock = I2C_GET_OPTIONS;
+    Wire.write(capsArray, I2C_CAPS_SIZE);
+    return;
+  }
+
+  if (i2cReadBlock == I2C_GET_STATUS) {
+    byte statusArray[I2C_STATUS_SIZE];
+    statusArray[I2C_STAT_OPCODE] = I2C_GET_STATUS;
+    statusArray[I2C_STAT_RECEIVED_SEQ] = i2cOptionsReceived;
+    statusArray[I2C_STAT_APPLIED_SEQ] = i2cOptionsApplied;
+    statusArray[I2C_STAT_FLAGS] = 0;
+    statusArray[I2C_STAT_SHADOW_VERSION] = i2cShadowVersion;
+    if (i2cOptionsApplied != i2cOptionsReceived) {
+      statusArray[I2C_STAT_FLAGS] |= I2C_STATUS_BUSY;
+    }
+#ifdef RTC_PROXY
+    if (rtcTimeSetPending) {
+      statusArray[I2C_STAT_FLAGS] |= I2C_STATUS_TIME_SET;
+    }
+#endif
+
+    i2cReadBlock = I2C_GET_OPTIONS;
+    Wire.write(statusArray, I2C_STATUS_SIZE);
+    return;
+  }
+
+  if (i2cReadBlock == I2C_GET_ALARMS) {
+    i2cReadBlock = I2C_GET_OPTIONS;
+    Wire.write(i2cAlarmsShadow[i2cShadowActive], I2C_ALARMS_SIZE);
+    return;
+  }
+
+  if (i2cReadBlock == I2C_GET_REJUV) {
+    i2cReadBlock = I2C_GET_OPTIONS;
+    Wire.write(i2cRejuvShadow[i2cRejuvShadowActive], I2C_REJUV_SIZE);
+    return;
+  }
+
+  if (i2cReadBlock == I2C_GET_SELF_TEST) {
+    i2cReadBlock = I2C_GET_OPTIONS;
+    Wire.write(i2cSelfTestShadow[i2cSelfTestShadowActive], I2C_SELF_TEST_SIZE);
+    return;
+  }
+
+  if (i2cReadBlock == I2C_GET_BOOT_TIMES) {
+    i2cReadBlock = I2C_GET_OPTIONS;
+    Wire.write(bootTimeline, I2C_BOOT_SIZE);
+    return;
+  }
+
+  if (i2cReadBlock == I2C_GET_TELEMETRY) {
+    i2cReadBlock = I2C_GET_OPTIONS;
+    Wire.write(i2cTelemetryShadow[i2cTelemetryShadowActive], I2C_TELEM_SIZE);
+    return;
+  }
+
+#ifdef RTC_PROXY
+  if (i2cReadBlock == I2C_GET_TIME) {
+    // The WiFi module has it now
+    rtcTimeSetPending = false;
+
+    i2cReadBlock = I2C_GET_OPTIONS;
+    Wire.write(i2cTimeShadow[i2cTimeShadowActive], I2C_TIME_SIZE);
+    return;
+  }
+#endif
+
+  Wire.write(i2cOptionsShadow[i2cShadowActive], I2C_DATA_SIZE);
+}
+
+// ************************************************************
+// Rebuild the option and alarm blocks the master reads. Called
+// whenever they are saved, so the I2C interrupt doesn't have to
+// put them together on every read.
+// ************************************************************
+void updateI2CShadow() {
+  byte nextShadow = 1 - i2cShadowActive;
+
+  byte* configArray = i2cOptionsShadow[nextShadow];
+  configArray[I2C_OPT_PROTOCOL] = I2C_PROTOCOL_NUMBER;  // protocol version
+  configArray[I2C_OPT_12_24] = encodeBooleanForI2C(hourMode);
+  configArray[I2C_OPT_BLANK_LEAD] = encodeBooleanForI2C(blankLeading);
+  configArray[I2C_OPT_SCROLLBACK] = encodeBooleanForI2C(scrollback);
+  configArray[I2C_OPT_SUPPRESS_ACP] = encodeBooleanForI2C(suppressACP);
+  configArray[I2C_OPT_FADE] = encodeBooleanForI2C(fade);
+  configArray[I2C_OPT_DATE_FORMAT] = dateFormat;
+  configArray[I2C_OPT_DAY_BLANKING] = dayBlanking;
+  configArray[I2C_OPT_BLANK_START] = blankHourStart;
+  configArray[I2C_OPT_BLANK_END] = blankHourEnd;
+  configArray[I2C_OPT_FADE_STEPS] = fadeSteps;
+  configArray[I2C_OPT_SCROLL_STEPS] = scrollSteps;
+  configArray[I2C_OPT_BACKLIGHT_MODE] = backlightMode;
+  configArray[I2C_OPT_RED_CHANNEL] = redCnl;
+  configArray[I2C_OPT_GREEN_CHANNEL] = grnCnl;
+  configArray[I2C_OPT_BLUE_CHANNEL] = bluCnl;
+  configArray[I2C_OPT_CYCLE_SPEED] = cycleSpeed;
+  configArray[I2C_OPT_USE_LDR] = encodeBooleanForI2C(useLDR);
+  configArray[I2C_OPT_BLANK_MODE] = blankMode;
+  configArray[I2C_OPT_SLOTS_MODE] = slotsMode;
+  configArray[I2C_OPT_MIN_DIM_HI] = minDim / 256;
+  configArray[I2C_OPT_MIN_DIM_LO] = minDim % 256;
+  configArray[I2C_OPT_ROLL_MODE] = rollMode;
+
+  byte* alarmsArray = i2cAlarmsShadow[nextShadow];
+  alarmsArray[0] = I2C_GET_ALARMS;
+  for (byte alarm = 0 ; alarm < ALARM_COUNT ; alarm++) {
+    byte idx = 1 + alarm * I2C_ALARM_SIZE;
+    alarmsArray[idx] = alarmHour[alarm];
+    alarmsArray[idx + 1] = alarmMinute[alarm];
+    alarmsArray[idx + 2] = alarmDays[alarm];
+    alarmsArray[idx + 3] = alarmAction[alarm];
+  }
+
+  i2cShadowActive = nextShadow;
+  i2cShadowVersion++;
+}
+
+// ************************************************************
+// Build the rejuvenation progress block, once a second
+// ************************************************************
+void updateI2CRejuvShadow() {
+  byte nextShadow = 1 - i2cRejuvShadowActive;
+  byte* rejuvArray = i2cRejuvShadow[nextShadow];
+
+  byte stepsDone = 0;
+  byte stepsTotal = 0;
+  for (byte step = 0 ; step < REJUV_STEPS ; step++) {
+    if (isRejuvStep(step)) {
+      stepsTotal++;
+      if (step < rejuvStep) {
+        stepsDone++;
+      }
+    }
+  }
+
+  int sagVolts = getHVVoltsFromRaw(rejuvWorstSag);
+
+  rejuvArray[I2C_REJUV_OPCODE] = I2C_GET_REJUV;
+  rejuvArray[I2C_REJUV_STATE] = rejuvBurning ? I2C_REJUV_STATE_BURNING : rejuvState;
+  rejuvArray[I2C_REJUV_TUBE] = rejuvStep / 10;
+  rejuvArray[I2C_REJUV_CATHODE] = rejuvStep % 10;
+  rejuvArray[I2C_REJUV_STEP_MINS] = rejuvStepDone;
+  rejuvArray[I2C_REJUV_STEPS_DONE] = stepsDone;
+  rejuvArray[I2C_REJUV_STEPS_TOTAL] = stepsTotal;
+  rejuvArray[I2C_REJUV_SAG] = constrain(sagVolts, 0, 255);
+  rejuvArray[I2C_REJUV_SAG_SKIPS] = rejuvSagSkips;
+
+  i2cRejuvShadowActive = nextShadow;
+}
+
+// ************************************************************
+// Build the telemetry block, once a second
+// ************************************************************
+void updateI2CTelemetryShadow() {
+  byte nextShadow = 1 - i2cTelemetryShadowActive;
+  byte* telemetryArray = i2cTelemetryShadow[nextShadow];
+
+  int hvVolts = getHVVoltsFromRaw((int) sensorHVSmoothed);
+
+  byte flags = 0;
+  if (blankTubes) flags |= I2C_TELEM_BLANKED;
+  if (useRTC) flags |= I2C_TELEM_RTC;
+  if (useWiFi > 0) flags |= I2C_TELEM_WIFI_TIME;
+
+  telemetryArray[I2C_TELEM_OPCODE] = I2C_GET_TELEMETRY;
+  telemetryArray[I2C_TELEM_HV_HI] = hvVolts / 256;
+  telemetryArray[I2C_TELEM_HV_LO] = hvVolts % 256;
+  telemetryArray[I2C_TELEM_BRIGHTNESS] = (long) digitOffCount * 100 / DIGIT_DISPLAY_COUNT;
+  telemetryArray[I2C_TELEM_IMPR_HI] = lastImpressionsPerSec / 256;
+  telemetryArray[I2C_TELEM_IMPR_LO] = lastImpressionsPerSec % 256;
+  telemetryArray[I2C_TELEM_FLAGS] = flags;
+
+  i2cTelemetryShadowActive = nextShadow;
+}
+
+#ifdef RTC_PROXY
+// ************************************************************
+// Rebuild the time block, once a second and when the time is
+// set here
+// ************************************************************
+void updateI2CTimeShadow() {
+  byte nextShadow = 1 - i2cTimeShadowActive;
+  byte* timeArray = i2cTimeShadow[nextShadow];
+
+  time_t timeNow = now();
+  timeArray[0] = I2C_GET_TIME;
+  timeArray[1] = year(timeNow) % 100;
+  timeArray[2] = month(timeNow);
+  timeArray[3] = day(timeNow);
+  timeArray[4] = hour(timeNow);
+  timeArray[5] = minute(timeNow);
+  timeArray[6] = second(timeNow);
+
+  i2cTimeShadowActive = nextShadow;
+}
+#endif
+
+// ************************************************************
+// Take the options from a block laid out like the one we send
+// the master. Called from the I2C interrupt, the main loop
+// saves them.
+// ************************************************************
+void applyI2COptionBlock(byte* optionBlock) {
+  hourMode = (optionBlock[I2C_OPT_12_24] == 1);
+  blankLeading = (optionBlock[I2C_OPT_BLANK_LEAD] == 1);
+  scrollback = (optionBlock[I2C_OPT_SCROLLBACK] == 1);
+  suppressACP = (optionBlock[I2C_OPT_SUPPRESS_ACP] == 1);
+  fade = (optionBlock[I2C_OPT_FADE] == 1);
+  dateFormat = optionBlock[I2C_OPT_DATE_FORMAT];
+  dayBlanking = optionBlock[I2C_OPT_DAY_BLANKING];
+  blankHourStart = optionBlock[I2C_OPT_BLANK_START];
+  blankHourEnd = optionBlock[I2C_OPT_BLANK_END];
+  fadeSteps = optionBlock[I2C_OPT_FADE_STEPS];
+  scrollSteps = optionBlock[I2C_OPT_SCROLL_STEPS];
+  backlightMode = optionBlock[I2C_OPT_BACKLIGHT_MODE];
+  redCnl = optionBlock[I2C_OPT_RED_CHANNEL];
+  grnCnl = optionBlock[I2C_OPT_GREEN_CHANNEL];
+  bluCnl = optionBlock[I2C_OPT_BLUE_CHANNEL];
+  cycleSpeed = optionBlock[I2C_OPT_CYCLE_SPEED];
+  useLDR = (optionBlock[I2C_OPT_USE_LDR] == 1);
+  blankMode = optionBlock[I2C_OPT_BLANK_MODE];
+  slotsMode = optionBlock[I2C_OPT_SLOTS_MODE];
+  minDim = optionBlock[I2C_OPT_MIN_DIM_HI] * 256 + optionBlock[I2C_OPT_MIN_DIM_LO];
+  rollMode = optionBlock[I2C_OPT_ROLL_MODE];
 }
 
 byte encodeBooleanForI2C(boolean valueToProcess) {
@@ -241,6 +241,51 @@ void DS3231::setClockMode(bool h12) {
 	Wire.endTransmission();
 }
 
+bool DS3231::setDateTime(byte Year, byte Month, byte Date, byte DoW, byte Hour, byte Minute, byte Second, bool verify) {
+	// Burst write registers 0x00 to 0x06. Writing the seconds resets
+	// the countdown chain, so nothing rolls over while we write or
+	// read back.
+	byte regs[7];
+	regs[0] = decToBcd(Second);
+	regs[1] = decToBcd(Minute);
+	regs[2] = decToBcd(Hour) & 0b10111111;	// 24h mode
+	regs[3] = decToBcd(DoW);
+	regs[4] = decToBcd(Date);
+	regs[5] = decToBcd(Month) & 0b01111111;	// clear century
+	regs[6] = decToBcd(Year);
+
+	Wire.beginTransmission(CLOCK_ADDRESS);
+	Wire.write(0x00);
+	for (byte i = 0; i < 7; i++) {
+		Wire.write(regs[i]);
+	}
+	if (Wire.endTransmission() != 0) {
+		return false;
+	}
+
+	// Clear OSF flag
+	byte temp_buffer = readControlByte(1);
+	writeControlByte((temp_buffer & 0b01111111), 1);
+
+	if (!verify) {
+		return true;
+	}
+
+	Wire.beginTransmission(CLOCK_ADDRESS);
+	Wire.write(0x00);
+	Wire.endTransmission();
+
+	if (Wire.requestFrom(CLOCK_ADDRESS, 7) != 7) {
+		return false;
+	}
+	for (byte i = 0; i < 7; i++) {
+		if (Wire.read() != regs[i]) {
+			return false;
+		}
+	}
+	return true;
+}
+
 float DS3231::getTemperature() {
 	// Checks the internal thermometer on the DS3231 and returns the 
 	// temperature as a floating-point value.
@@ -254,6 +299,28 @@ float DS3231::getTemperature() {
 	return float(temp) + 0.25*(Wire.read()>>6);
 }
 
+signed char DS3231::getAgingOffset() {
+	Wire.beginTransmission(CLOCK_ADDRESS);
+	Wire.write(0x10);
+	Wire.endTransmission();
+
+	Wire.requestFrom(CLOCK_ADDRESS, 1);
+	return (signed char) Wire.read();
+}
+
+void DS3231::setAgingOffset(signed char offset) {
+	Wire.beginTransmission(CLOCK_ADDRESS);
+	Wire.write(0x10);
+	Wire.write((byte) offset);
+	Wire.endTransmission();
+
+	// The offset only takes effect on the next temperature conversion.
+	// Start one, unless one is already running (BSY flag).
+	if (!(readControlByte(1) & 0b00000100)) {
+		writeControlByte((readControlByte(0) | 0b00100000), 0);
+	}
+}
+
 void DS3231::getA1Time(byte& A1Day, byte& A1Hour, byte& A1Minute, byte& A1Second, byte& AlarmBits, bool& A1Dy, bool& A1h12, bool& A1PM) {
 	byte temp_buffer;
 	Wire.beginTransmission(CLOCK_ADDRESS);
@@ -63,11 +63,26 @@ class DS3231 {
 			// Last two digits of the year
 		void setClockMode(bool h12); 
 			// Set 12/24h mode. True is 12-h, false is 24-hour.
+		bool setDateTime(byte Year, byte Month, byte Date, byte DoW, byte Hour, byte Minute, byte Second, bool verify);
+			// Sets the whole date and time in one transaction, so the
+			// clock can't roll over between the fields. Always sets 24h
+			// mode and, like setSecond(), clears the "Oscillator Stop
+			// Flag". With verify, the registers are read back and
+			// compared; returns false if they don't match.
 
 		// Temperature function
 
 		float getTemperature(); 
 
+		// Aging offset functions
+
+		signed char getAgingOffset();
+			// Reads the aging offset register. One step is about 0.1ppm,
+			// positive values slow the oscillator down.
+		void setAgingOffset(signed char offset);
+			// Writes the aging offset register and starts a temperature
+			// conversion, so that the new offset is used straight away.
+
 		// Alarm functions
 		
 		void getA1Time(byte& A1Day, byte& A1Hour, byte& A1Minute, byte& A1Second, byte& AlarmBits, bool& A1Dy, bool& A1h12, bool& A1PM); 
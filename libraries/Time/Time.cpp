@@ -143,62 +143,54 @@ int year(time_t t) { // the year for the given time
 /* functions to convert to and from system time */
 /* These are for interfacing with time serivces and are not normally needed in a sketch */
 
-// leap year calulator expects year argument as years offset from 1970
-#define LEAP_YEAR(Y)     ( ((1970+Y)>0) && !((1970+Y)%4) && ( ((1970+Y)%100) || !((1970+Y)%400) ) )
+// Dates are converted in closed form (after H. Hinnant's days_from_civil /
+// civil_from_days) on days counted from 1 March 1968. Starting the year in
+// March puts the leap day at the end, and 1968 starts a 4 year leap cycle.
+// 1 Jan 1970 to 7 Feb 2106 (the end of time_t) is less than 65536 days, so
+// apart from splitting off the days everything fits in 16 bits. 2100 is the
+// only century in range, and it is not a leap year: we count a phantom
+// 29 Feb 2100 so that the 4 year cycle holds, and take it out again.
+#define DAYS_1968_MAR_TO_1970       671U    // 1 Mar 1968 -> 1 Jan 1970
+#define DAYS_1968_MAR_TO_2100_MAR   48212U  // 1 Mar 1968 -> 1 Mar 2100
+#define DAYS_PER_4_YEARS            1461U
 
-static  const uint8_t monthDays[]={31,28,31,30,31,30,31,31,30,31,30,31}; // API starts months from 1, this array starts from 0
- 
 void breakTime(time_t timeInput, tmElements_t &tm){
 // break the given time_t into time components
 // this is a more compact version of the C library localtime function
 // note that year is offset from 1970 !!!
 
-  uint8_t year;
-  uint8_t month, monthLength;
   uint32_t time;
-  unsigned long days;
+  uint16_t days;
+  uint16_t minutes;
+  uint16_t cycle, dayOfCycle, yearOfCycle, dayOfYear, monthFromMar;
 
   time = (uint32_t)timeInput;
-  tm.Second = time % 60;
-  time /= 60; // now it is minutes
-  tm.Minute = time % 60;
-  time /= 60; // now it is hours
-  tm.Hour = time % 24;
-  time /= 24; // now it is days
-  tm.Wday = ((time + 4) % 7) + 1;  // Sunday is day 1 
-  
-  year = 0;  
-  days = 0;
-  while((unsigned)(days += (LEAP_YEAR(year) ? 366 : 365)) <= time) {
-    year++;
+  days = time / SECS_PER_DAY;
+  time -= days * SECS_PER_DAY; // now it is seconds today
+  minutes = time / 60;
+  tm.Second = time - minutes * 60;
+  tm.Hour = minutes / 60;
+  tm.Minute = minutes % 60;
+  tm.Wday = ((days + 4) % 7) + 1;  // Sunday is day 1 
+
+  days += DAYS_1968_MAR_TO_1970;
+  if (days >= DAYS_1968_MAR_TO_2100_MAR) {
+    days++; // step over the phantom 29 Feb 2100
   }
-  tm.Year = year; // year is offset from 1970 
-  
-  days -= LEAP_YEAR(year) ? 366 : 365;
-  time  -= days; // now it is days in this year, starting at 0
-  
-  days=0;
-  month=0;
-  monthLength=0;
-  for (month=0; month<12; month++) {
-    if (month==1) { // february
-      if (LEAP_YEAR(year)) {
-        monthLength=29;
-      } else {
-        monthLength=28;
-      }
-    } else {
-      monthLength = monthDays[month];
-    }
-    
-    if (time >= monthLength) {
-      time -= monthLength;
-    } else {
-        break;
-    }
+
+  cycle = days / DAYS_PER_4_YEARS;
+  dayOfCycle = days - cycle * DAYS_PER_4_YEARS;
+  yearOfCycle = (dayOfCycle - dayOfCycle / (DAYS_PER_4_YEARS - 1)) / 365; // 0..3, the leap day is last
+  dayOfYear = dayOfCycle - yearOfCycle * 365;  // 0 = 1 Mar
+  monthFromMar = (5 * dayOfYear + 2) / 153;    // 0 = Mar
+
+  tm.Day = dayOfYear - (153 * monthFromMar + 2) / 5 + 1;  // day of month
+  if (monthFromMar < 10) {
+    tm.Month = monthFromMar + 3;  // jan is month 1
+  } else {
+    tm.Month = monthFromMar - 9;
   }
-  tm.Month = month + 1;  // jan is month 1  
-  tm.Day = time + 1;     // day of month
+  tm.Year = cycle * 4 + yearOfCycle + (tm.Month <= 2) - 2; // year is offset from 1970
 }
 
 time_t makeTime(tmElements_t &tm){   
@@ -206,26 +198,25 @@ time_t makeTime(tmElements_t &tm){
 // note year argument is offset from 1970 (see macros in time.h to convert to other formats)
 // previous version used full four digit year (or digits since 2000),i.e. 2009 was 2009 or 9
   
-  int i;
+  uint16_t years, monthFromMar, days;
   uint32_t seconds;
 
-  // seconds from 1970 till 1 jan 00:00:00 of the given year
-  seconds= tm.Year*(SECS_PER_DAY * 365);
-  for (i = 0; i < tm.Year; i++) {
-    if (LEAP_YEAR(i)) {
-      seconds +=  SECS_PER_DAY;   // add extra days for leap years
-    }
+  // years since 1968 in March based years, so that the leap day comes last
+  years = tm.Year + 2;
+  if (tm.Month <= 2) {
+    years--;
+    monthFromMar = tm.Month + 9;
+  } else {
+    monthFromMar = tm.Month - 3;
   }
-  
-  // add days for this year, months start from 1
-  for (i = 1; i < tm.Month; i++) {
-    if ( (i == 2) && LEAP_YEAR(tm.Year)) { 
-      seconds += SECS_PER_DAY * 29;
-    } else {
-      seconds += SECS_PER_DAY * monthDays[i-1];  //monthDay array starts from 0
-    }
+
+  days = years * 365U + years / 4 + (153 * monthFromMar + 2) / 5 + tm.Day - 1;
+  if (days > DAYS_1968_MAR_TO_2100_MAR) {
+    days--; // there is no 29 Feb 2100
   }
-  seconds+= (tm.Day-1) * SECS_PER_DAY;
+  days -= DAYS_1968_MAR_TO_1970;
+
+  seconds = days * SECS_PER_DAY;
   seconds+= tm.Hour * SECS_PER_HOUR;
   seconds+= tm.Minute * SECS_PER_MIN;
   seconds+= tm.Second;
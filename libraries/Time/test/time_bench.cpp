@@ -0,0 +1,58 @@
+// breakTime() and makeTime(), closed form against the old loops, on the
+// host. The loops get slower the further a date is from 1970, so each runs
+// at three dates: 1970, now, and the end of time_t.
+#include <benchmark/benchmark.h>
+
+#include "TimeLib.h"
+#include "legacy_time.h"
+
+static const uint32_t dates[3] = {
+  86399UL,        // 1970-01-01 23:59:59
+  1792326896UL,   // 2026-10-18 12:34:56
+  4294967295UL,   // 2106-02-07 06:28:15
+};
+
+static void BM_breakTime(benchmark::State& state) {
+  uint32_t t = dates[state.range(0)];
+  tmElements_t tm;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(t);
+    breakTime(t, tm);
+    benchmark::DoNotOptimize(tm);
+  }
+}
+
+static void BM_breakTimeLoop(benchmark::State& state) {
+  uint32_t t = dates[state.range(0)];
+  tmElements_t tm;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(t);
+    legacy::breakTime(t, tm);
+    benchmark::DoNotOptimize(tm);
+  }
+}
+
+static void BM_makeTime(benchmark::State& state) {
+  tmElements_t tm;
+  breakTime(dates[state.range(0)], tm);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(tm);
+    benchmark::DoNotOptimize(makeTime(tm));
+  }
+}
+
+static void BM_makeTimeLoop(benchmark::State& state) {
+  tmElements_t tm;
+  breakTime(dates[state.range(0)], tm);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(tm);
+    benchmark::DoNotOptimize(legacy::makeTime(tm));
+  }
+}
+
+BENCHMARK(BM_breakTime)->DenseRange(0, 2);
+BENCHMARK(BM_breakTimeLoop)->DenseRange(0, 2);
+BENCHMARK(BM_makeTime)->DenseRange(0, 2);
+BENCHMARK(BM_makeTimeLoop)->DenseRange(0, 2);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,92 @@
+// The closed form breakTime() and makeTime() against the loops they
+// replaced, over the whole 32 bit time_t range.
+//
+// Every 3599th second: 3599 is prime to 60, 3600 and 86400, so the sweep
+// lands on every second of the minute, hour and day as it goes. Every
+// midnight and the second before it, so that no month or year boundary is
+// missed. And every date from 1970 to 2106 through makeTime().
+#include <stdio.h>
+#include <string.h>
+
+#include "TimeLib.h"
+#include "legacy_time.h"
+
+static unsigned long failures = 0;
+
+static bool same(const tmElements_t& a, const tmElements_t& b) {
+  return (a.Second == b.Second) && (a.Minute == b.Minute) && (a.Hour == b.Hour) && (a.Wday == b.Wday) &&
+         (a.Day == b.Day) && (a.Month == b.Month) && (a.Year == b.Year);
+}
+
+static void fail(const char* what, uint32_t t, const tmElements_t& got, const tmElements_t& want) {
+  if (failures++ < 10) {
+    printf("  FAIL %s at %lu: got %d-%02d-%02d %02d:%02d:%02d wday %d, want %d-%02d-%02d %02d:%02d:%02d wday %d\n", what, (unsigned long) t,
+           tmYearToCalendar(got.Year), got.Month, got.Day, got.Hour, got.Minute, got.Second, got.Wday,
+           tmYearToCalendar(want.Year), want.Month, want.Day, want.Hour, want.Minute, want.Second, want.Wday);
+  }
+}
+
+// Both ways at one time_t
+static void checkAt(uint32_t t) {
+  tmElements_t got, want;
+  breakTime(t, got);
+  legacy::breakTime(t, want);
+  if (!same(got, want)) {
+    fail("breakTime", t, got, want);
+    return;
+  }
+  if ((uint32_t) makeTime(got) != t) {
+    fail("makeTime", (uint32_t) makeTime(got), got, want);
+  }
+}
+
+int main() {
+  unsigned long checked = 0;
+
+  for (uint64_t t = 0 ; t <= 0xffffffffULL ; t += 3599) {
+    checkAt((uint32_t) t);
+    checked++;
+  }
+
+  for (uint64_t t = 0 ; t <= 0xffffffffULL ; t += SECS_PER_DAY) {
+    checkAt((uint32_t) t);
+    if (t > 0) checkAt((uint32_t) (t - 1));
+    checked += 2;
+  }
+  checkAt(0xffffffffUL);
+
+  // Every date makeTime() can take, through both
+  for (int year = 0 ; year <= 136 ; year++) {
+    for (int month = 1 ; month <= 12 ; month++) {
+      for (int day = 1 ; day <= 31 ; day++) {
+        tmElements_t tm;
+        tm.Year = year;
+        tm.Month = month;
+        tm.Day = day;
+        tm.Hour = (year + day) % 24;
+        tm.Minute = (month * 7 + day) % 60;
+        tm.Second = (year * 13 + day) % 60;
+
+        tmElements_t back;
+        legacy::breakTime(legacy::makeTime(tm), back);
+        if ((back.Day != day) || (back.Month != month)) continue;  // no 31 Feb
+        if ((uint64_t) legacy::makeTime(tm) < (uint64_t) year * 365 * SECS_PER_DAY) continue;  // past 2106
+
+        tmElements_t copy = tm;
+        if (makeTime(copy) != legacy::makeTime(tm)) {
+          tmElements_t got;
+          breakTime(makeTime(copy), got);
+          fail("makeTime date", (uint32_t) legacy::makeTime(tm), got, tm);
+        }
+        checked++;
+      }
+    }
+  }
+
+  if (failures > 0) {
+    printf("time_test: %lu of %lu checks failed\n", failures, checked);
+    return 1;
+  }
+  printf("time_test: ok, %lu checks\n", checked);
+  return 0;
+}
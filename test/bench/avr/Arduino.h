@@ -0,0 +1,19 @@
+// Just enough Arduino for the shared scenarios on a bare ATmega328P: the
+// types the sketch code uses, random() for the colour cycling, and millis()
+// for the Time library (which the scenarios never reach).
+#ifndef Arduino_h
+#define Arduino_h
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+unsigned long millis();
+long random(long howBig);
+
+#endif
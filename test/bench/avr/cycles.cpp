@@ -0,0 +1,104 @@
+// The shared scenarios (scenarios.h) on an ATmega328P at 16MHz, under
+// simavr. Timer 1 runs at the CPU clock; each call is timed on its own and
+// the cost of an empty call is taken off. The results go out on simavr's
+// console, one line a scenario:
+//
+//   name inputs mean_cycles min_cycles max_cycles
+//
+// cycles.py builds this, runs it and turns the lines into JSON.
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+
+#include "avr_mcu_section.h"
+#include "scenarios.h"
+
+AVR_MCU(F_CPU, "atmega328p");
+AVR_MCU_SIMAVR_CONSOLE(&GPIOR0);
+
+#define PASSES 4
+
+unsigned long millis() {
+  return 0;
+}
+
+// As the Arduino core has it, on avr-libc's generator
+long random(long howBig) {
+  if (howBig == 0) return 0;
+  return random() % howBig;
+}
+
+static void print(const char* s) {
+  while (*s) GPIOR0 = *s++;
+}
+
+static void printNumber(uint32_t n) {
+  char buf[11];
+  char* p = buf + sizeof(buf) - 1;
+  *p = 0;
+  do {
+    *--p = '0' + (n % 10);
+    n /= 10;
+  } while (n > 0);
+  print(buf);
+}
+
+static void emptyRun(uint8_t input) {
+  (void) input;
+}
+
+// Cycles for one call, as Timer 1 sees them
+static uint16_t timeCall(BenchRun run, uint8_t input) {
+  uint16_t start = TCNT1;
+  run(input);
+  return TCNT1 - start;
+}
+
+int main() {
+  TCCR1A = 0;
+  TCCR1B = _BV(CS10);
+
+  // The timing itself: the call and reading the timer
+  BenchRun volatile empty = emptyRun;
+  uint16_t overhead = 0xffff;
+  for (uint8_t i = 0 ; i < 8 ; i++) {
+    uint16_t c = timeCall(empty, i);
+    if (c < overhead) overhead = c;
+  }
+
+  for (uint8_t s = 0 ; s < benchScenarioCount ; s++) {
+    const BenchScenario& scenario = benchScenarios[s];
+    uint32_t total = 0;
+    uint16_t lo = 0xffff;
+    uint16_t hi = 0;
+
+    // Once round untimed, for anything the scenario sets up the first time
+    for (uint8_t input = 0 ; input < scenario.inputs ; input++) {
+      scenario.run(input);
+    }
+
+    for (uint8_t pass = 0 ; pass < PASSES ; pass++) {
+      for (uint8_t input = 0 ; input < scenario.inputs ; input++) {
+        uint16_t c = timeCall(scenario.run, input) - overhead;
+        total += c;
+        if (c < lo) lo = c;
+        if (c > hi) hi = c;
+      }
+    }
+    print(scenario.name);
+    print(" ");
+    printNumber(scenario.inputs);
+    print(" ");
+    printNumber(total / ((uint32_t) PASSES * scenario.inputs));
+    print(" ");
+    printNumber(lo);
+    print(" ");
+    printNumber(hi);
+    print("\n");
+  }
+
+  // simavr stops when we sleep with interrupts off
+  cli();
+  sleep_cpu();
+  return 0;
+}
@@ -0,0 +1,118 @@
+#!/usr/bin/env python3
+"""Cycle counts of the shared benchmark scenarios on an ATmega328P.
+
+Builds avr/cycles.cpp with the scenarios and the sketch code they call,
+runs it under simavr and writes the results as JSON, in the same shape as
+Google Benchmark's output so the two can go through the same tools:
+
+    python3 cycles.py --out build/logic_cycles.json
+
+Needs avr-g++, simavr and simavr's avr_mcu_section.h. If any of them is
+missing it says so and exits 0, so "make cycles" can run anywhere.
+"""
+
+import argparse
+import json
+import os
+import re
+import shutil
+import subprocess
+import sys
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+BENCH = os.path.dirname(HERE)
+REPO = os.path.abspath(os.path.join(BENCH, "..", ".."))
+SKETCH = os.path.join(REPO, "ardunixFade9_6_digit")
+TIME_LIB = os.path.join(REPO, "libraries", "Time")
+
+MCU = "atmega328p"
+F_CPU = 16000000
+
+SOURCES = [
+    os.path.join(HERE, "cycles.cpp"),
+    os.path.join(BENCH, "scenarios.cpp"),
+    os.path.join(SKETCH, "ClockLogic.cpp"),
+    os.path.join(SKETCH, "Transition.cpp"),
+    os.path.join(TIME_LIB, "Time.cpp"),
+]
+
+INCLUDE_DIRS = [
+    "/usr/include/simavr/avr",
+    "/usr/local/include/simavr/avr",
+    "/usr/include/simavr",
+    "/usr/local/include/simavr",
+]
+
+LINE = re.compile(r"(\S+) (\d+) (\d+) (\d+) (\d+)$")
+ANSI = re.compile(r"\x1b\[[0-9;]*m")
+
+
+def find_mcu_section(extra):
+    for d in ([extra] if extra else []) + INCLUDE_DIRS:
+        if d and os.path.exists(os.path.join(d, "avr_mcu_section.h")):
+            return d
+    return None
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--out", default=os.path.join(BENCH, "..", "build", "logic_cycles.json"), help="JSON results")
+    parser.add_argument("--build", default=os.path.join(BENCH, "..", "build", "avr"), help="where the ELF goes")
+    parser.add_argument("--simavr-include", help="directory with avr_mcu_section.h")
+    parser.add_argument("--cxx", default="avr-g++")
+    parser.add_argument("--simavr", default="simavr")
+    args = parser.parse_args()
+
+    cxx = shutil.which(args.cxx)
+    simavr = shutil.which(args.simavr) or shutil.which("run_avr")
+    section = find_mcu_section(args.simavr_include)
+    missing = [name for name, found in ((args.cxx, cxx), (args.simavr, simavr), ("avr_mcu_section.h", section)) if not found]
+    if missing:
+        print("cycles: skipped, no " + ", ".join(missing))
+        return 0
+
+    os.makedirs(args.build, exist_ok=True)
+    elf = os.path.join(args.build, "cycles.elf")
+    cmd = [cxx, "-mmcu=" + MCU, "-DF_CPU=%dUL" % F_CPU, "-DARDUINO=10800", "-Os", "-std=gnu++11",
+           "-ffunction-sections", "-fdata-sections", "-Wl,--gc-sections",
+           "-I" + HERE, "-I" + BENCH, "-I" + SKETCH, "-I" + TIME_LIB, "-I" + section,
+           "-o", elf] + SOURCES + ["-lm"]
+    subprocess.run(cmd, check=True)
+
+    run = subprocess.run([simavr, "-m", MCU, "-f", str(F_CPU), elf],
+                         stdout=subprocess.PIPE, stderr=subprocess.STDOUT, universal_newlines=True, timeout=600)
+
+    benchmarks = []
+    for line in run.stdout.splitlines():
+        m = LINE.search(ANSI.sub("", line).strip())
+        if not m:
+            continue
+        name, inputs, mean, lo, hi = m.group(1), int(m.group(2)), int(m.group(3)), int(m.group(4)), int(m.group(5))
+        benchmarks.append({
+            "name": name,
+            "inputs": inputs,
+            "cycles": mean,
+            "min_cycles": lo,
+            "max_cycles": hi,
+            "real_time": mean * 1e9 / F_CPU,
+            "time_unit": "ns",
+        })
+
+    if not benchmarks:
+        sys.stdout.write(run.stdout)
+        print("cycles: no results from simavr")
+        return 1
+
+    print("%-26s %6s %9s %9s %9s %9s" % ("scenario", "inputs", "cycles", "min", "max", "us"))
+    for b in benchmarks:
+        print("%-26s %6d %9d %9d %9d %9.2f" % (b["name"], b["inputs"], b["cycles"], b["min_cycles"],
+                                               b["max_cycles"], b["real_time"] / 1000.0))
+
+    version = subprocess.run([cxx, "--version"], stdout=subprocess.PIPE, universal_newlines=True).stdout.splitlines()[0]
+    with open(args.out, "w") as out:
+        json.dump({"context": {"mcu": MCU, "f_cpu": F_CPU, "compiler": version}, "benchmarks": benchmarks}, out, indent=2)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
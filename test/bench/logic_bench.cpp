@@ -0,0 +1,28 @@
+// The shared scenarios (scenarios.h) under Google Benchmark, one benchmark
+// each, and the WiFi module's host only ones after them. "make bench" writes the results to build/logic_bench.json as well,
+// for keeping track release over release.
+#include <benchmark/benchmark.h>
+
+#include "scenarios.h"
+
+static void runScenario(benchmark::State& state, const BenchScenario* scenario) {
+  uint8_t input = 0;
+  for (auto _ : state) {
+    scenario->run(input);
+    if (++input == scenario->inputs) input = 0;
+  }
+  state.counters["inputs"] = scenario->inputs;
+}
+
+int main(int argc, char** argv) {
+  for (uint8_t i = 0 ; i < benchScenarioCount ; i++) {
+    benchmark::RegisterBenchmark(benchScenarios[i].name, runScenario, &benchScenarios[i]);
+  }
+  for (uint8_t i = 0 ; i < webScenarioCount ; i++) {
+    benchmark::RegisterBenchmark(webScenarios[i].name, runScenario, &webScenarios[i]);
+  }
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+  benchmark::RunSpecifiedBenchmarks();
+  return 0;
+}
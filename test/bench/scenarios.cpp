@@ -0,0 +1,163 @@
+#include "Arduino.h"
+#include "TimeLib.h"
+#include "ClockLogic.h"
+#include "Transition.h"
+#include "scenarios.h"
+
+volatile uint32_t benchSink = 0;
+
+// Transition works on the sketch's display arrays, these stand in for them
+byte NumberArray[6] = {1, 2, 3, 4, 5, 6};
+byte displayType[6] = {FADE, FADE, FADE, FADE, FADE, FADE};
+boolean scrollback = true;
+
+// ------------------------------------------------------------------
+// Blanking: every hour against a window over midnight, and every day
+// blanking mode on each day of the week
+// ------------------------------------------------------------------
+static void runHoursBlanked(uint8_t input) {
+  benchSink += isHoursBlanked(input, 22, 7);
+}
+
+static void runDayBlanked(uint8_t input) {
+  byte mode = input / 7;
+  byte weekday = (input % 7) + 1;
+  benchSink += isDayBlanked(mode, weekday, (input & 1));
+}
+
+// ------------------------------------------------------------------
+// LDR: the moving average and the brightness mapping, over readings from
+// dark to bright
+// ------------------------------------------------------------------
+static const int ldrReadings[8] = {20, 100, 180, 350, 520, 700, 860, 1000};
+static double ldrSmoothed = 500.0;
+
+static void runSmoothSensor(uint8_t input) {
+  ldrSmoothed = smoothSensorReading(ldrSmoothed, ldrReadings[input], 10);
+  benchSink += (uint32_t) ldrSmoothed;
+}
+
+static void runBrightness(uint8_t input) {
+  benchSink += (uint32_t) getBrightnessFromSensor(ldrReadings[input], 100, 700, 999.0 / 600.0);
+}
+
+// ------------------------------------------------------------------
+// Time library: a spread of dates from 1970 to the end of the 32 bit
+// time_t
+// ------------------------------------------------------------------
+static const uint32_t dates[8] = {
+  0UL,           // 1970-01-01
+  951782400UL,   // 2000-02-29
+  1792324800UL,  // 2026-10-18 12:00
+  2114380800UL,  // 2037-01-01
+  2556143999UL,  // 2050-12-31 23:59:59
+  3029529600UL,  // 2066-01-01
+  3786912000UL,  // 2090-01-01
+  4291747199UL   // 2105-12-31 23:59:59
+};
+
+static void runBreakTime(uint8_t input) {
+  tmElements_t tm;
+  breakTime(dates[input], tm);
+  benchSink += tm.Day + tm.Month + tm.Year;
+}
+
+static tmElements_t dateElements[8];
+static boolean dateElementsReady = false;
+
+static void runMakeTime(uint8_t input) {
+  if (!dateElementsReady) {
+    for (uint8_t i = 0 ; i < 8 ; i++) breakTime(dates[i], dateElements[i]);
+    dateElementsReady = true;
+  }
+  benchSink += makeTime(dateElements[input]);
+}
+
+// ------------------------------------------------------------------
+// Display frame: the slot size and the dither for a spread of
+// brightness levels, with the sketch's default dark time, and a digit
+// fading over and over with the default fade steps
+// ------------------------------------------------------------------
+#define BENCH_DISP_COUNT      1000
+#define BENCH_SLOT_OVERHEAD   100
+#define BENCH_FADE_STEPS      50
+
+static const int onLevels[8] = {0, 50, 100, 200, 400, 700, 900, DIGIT_DISPLAY_OFF};
+static unsigned int benchDitherError = 0;
+
+static void runSlotCount(uint8_t input) {
+  benchSink += getSlotCount(BENCH_DISP_COUNT, onLevels[input] + 1, BENCH_SLOT_OVERHEAD, 0);
+}
+
+static void runDither(uint8_t input) {
+  int slotCount = getSlotCount(BENCH_DISP_COUNT, onLevels[input] + 1, BENCH_SLOT_OVERHEAD, 0);
+  float slotScale = (float) (slotCount + BENCH_SLOT_OVERHEAD) / (float) (BENCH_DISP_COUNT + BENCH_SLOT_OVERHEAD);
+  benchSink += ditherOffCount(((long) onLevels[input] * DITHER_SCALE) + input, slotScale, benchDitherError);
+}
+
+static byte benchFadeState = 0;
+
+static void runFade(uint8_t input) {
+  (void) input;
+  float fadeStep = (float) DIGIT_DISPLAY_OFF / BENCH_FADE_STEPS;
+  benchSink += stepFade(benchFadeState, true, BENCH_FADE_STEPS, fadeStep, 0.5);
+}
+
+// ------------------------------------------------------------------
+// Back light: colour cycling at full speed, so every call takes a step
+// ------------------------------------------------------------------
+static int benchColors[3] = {0, 0, 0};
+static ColourCycle benchCycle = {0, 0, 0};
+
+static void runCycleColours(uint8_t input) {
+  (void) input;
+  cycleColours3(benchColors, benchCycle, 0);
+  benchSink += benchColors[0] + benchColors[1] + benchColors[2];
+}
+
+// ------------------------------------------------------------------
+// Transition: the sketch's message effect (500ms in, 3s hold, 1s out),
+// at every 250ms through it
+// ------------------------------------------------------------------
+#define BENCH_TRANSITION_START 1000UL
+
+static Transition benchTransition(500, 1000, 3000);
+static boolean benchTransitionReady = false;
+
+static void startTransition() {
+  if (!benchTransitionReady) {
+    benchTransition.setAlternateValues();
+    benchTransition.setRegularValues();
+    benchTransition.start(BENCH_TRANSITION_START);
+    benchTransitionReady = true;
+  }
+}
+
+static void runScrollInScrambleOut(uint8_t input) {
+  startTransition();
+  benchSink += benchTransition.scrollInScrambleOut(BENCH_TRANSITION_START + input * 250UL);
+  benchSink += NumberArray[0];
+}
+
+static void runScrambleMsg(uint8_t input) {
+  startTransition();
+  benchSink += benchTransition.scrambleMsg(BENCH_TRANSITION_START + input * 250UL);
+  benchSink += NumberArray[0];
+}
+
+const BenchScenario benchScenarios[] = {
+  {"isHoursBlanked",          24, runHoursBlanked},
+  {"isDayBlanked",            63, runDayBlanked},
+  {"smoothSensorReading",      8, runSmoothSensor},
+  {"getBrightnessFromSensor",  8, runBrightness},
+  {"breakTime",                8, runBreakTime},
+  {"makeTime",                 8, runMakeTime},
+  {"getSlotCount",             8, runSlotCount},
+  {"ditherOffCount",           8, runDither},
+  {"stepFade",      BENCH_FADE_STEPS, runFade},
+  {"cycleColours3",            1, runCycleColours},
+  {"scrollInScrambleOut",     24, runScrollInScrambleOut},
+  {"scrambleMsg",             24, runScrambleMsg},
+};
+
+const uint8_t benchScenarioCount = sizeof(benchScenarios) / sizeof(BenchScenario);
@@ -0,0 +1,33 @@
+// The workloads the benchmark suites share: logic_bench times them with
+// Google Benchmark on the host, avr/cycles.cpp counts their cycles on an
+// ATmega328P under simavr. Both build this code unchanged, so the two sets
+// of numbers are for the same work.
+//
+// A scenario is one call of the code under test on one of its inputs. The
+// suites go round the inputs in turn, so a result is the average over all
+// of them.
+#ifndef scenarios_h
+#define scenarios_h
+
+#include <stdint.h>
+
+typedef void (*BenchRun)(uint8_t input);
+
+struct BenchScenario {
+  const char* name;
+  uint8_t inputs;
+  BenchRun run;
+};
+
+extern const BenchScenario benchScenarios[];
+extern const uint8_t benchScenarioCount;
+
+// The WiFi module's parsing and page building (web_scenarios.cpp). That
+// code never runs on an AVR, so only the host suite has these.
+extern const BenchScenario webScenarios[];
+extern const uint8_t webScenarioCount;
+
+// Results go here, so the compiler can't drop the calls
+extern volatile uint32_t benchSink;
+
+#endif
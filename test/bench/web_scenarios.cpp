@@ -0,0 +1,50 @@
+#include "Arduino.h"
+#include "WebLogic.h"
+#include "scenarios.h"
+
+// ------------------------------------------------------------------
+// Parsing: each field of a time server answer, as the sync reads them
+// ------------------------------------------------------------------
+static const String timeAnswer = "2026,10,18,12,34,56";
+
+static void runGetIntValue(uint8_t input) {
+  benchSink += getIntValue(timeAnswer, ',', input);
+}
+
+// ------------------------------------------------------------------
+// Page building: the fragments a settings page is made of
+// ------------------------------------------------------------------
+static void runTableRow(uint8_t input) {
+  benchSink += getTableRow2Col("Uptime", input * 1000).length();
+}
+
+static void runNumberInput(uint8_t input) {
+  benchSink += getNumberInput("Fade steps", "fadeSteps", 20, 200, 50 + input, (input & 1)).length();
+}
+
+static void runRadioGroup(uint8_t input) {
+  String group = getRadioGroupHeader("12/24 hour mode");
+  group += getRadioButton("12h", "12H", "12h", (input & 1));
+  group += getRadioButton("12h", "24H", "24h", !(input & 1));
+  group += getRadioGroupFooter();
+  benchSink += group.length();
+}
+
+static void runDropDown(uint8_t input) {
+  String dropDown = getDropDownHeader("Back light mode", "backLight", false);
+  for (uint8_t i = 0 ; i < 6 ; i++) {
+    dropDown += getDropDownOption(String(i), "Mode " + String(i), (i == input));
+  }
+  dropDown += getDropDownFooter();
+  benchSink += dropDown.length();
+}
+
+const BenchScenario webScenarios[] = {
+  {"getIntValue",              6, runGetIntValue},
+  {"getTableRow2Col",          8, runTableRow},
+  {"getNumberInput",           8, runNumberInput},
+  {"radioGroup",               2, runRadioGroup},
+  {"dropDown",                 6, runDropDown},
+};
+
+const uint8_t webScenarioCount = sizeof(webScenarios) / sizeof(BenchScenario);
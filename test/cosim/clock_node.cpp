@@ -0,0 +1,33 @@
+#include "clock_firmware.h"
+#include "cosim.h"
+
+namespace clocknode {
+  void powerOn() { clockhost::powerOn(); }
+
+  // Power on again. The host build keeps the globals, so lose by hand
+  // what the clock keeps in RAM about the WiFi module.
+  void restart() {
+    clockfw::i2cFastMode = false;
+    clockfw::i2cOptionsReceived = 0;
+    clockfw::i2cOptionsApplied = 0;
+    clockhost::powerOn();
+  }
+  void loop() { clockfw::loop(); }
+  uint8_t slaveAddress() { return I2C_SLAVE_ADDR; }
+  long now() { return clockfw::now(); }
+  int year() { return clockfw::year(); }
+  int month() { return clockfw::month(); }
+  int day() { return clockfw::day(); }
+  int hour() { return clockfw::hour(); }
+  int minute() { return clockfw::minute(); }
+  int second() { return clockfw::second(); }
+  uint8_t dateFormat() { return clockfw::dateFormat; }
+  uint8_t fadeSteps() { return clockfw::fadeSteps; }
+  uint8_t scrollSteps() { return clockfw::scrollSteps; }
+  uint8_t backlightMode() { return clockfw::backlightMode; }
+  uint8_t redCnl() { return clockfw::redCnl; }
+  uint8_t eepromDateFormat() { return clockfw::EEPROM.read(EE_DATE_FORMAT); }
+  uint8_t eepromFadeSteps() { return clockfw::EEPROM.read(EE_FADE_STEPS); }
+  uint64_t displayTicks() { return clockhost::ticks; }
+  bool fastMode() { return clockfw::i2cFastMode; }
+}
@@ -0,0 +1,469 @@
+// Runs the clock and the WiFi module firmware against each other on one
+// virtual I2C bus and reports what each scenario costs the bus and the
+// display.
+//
+// The two processors each keep their own time. The scheduler always runs
+// whichever is behind for one loop(), and a delay() on one side runs the
+// other until the delay is over, so polling loops like waitForClockToApply()
+// see the clock make progress. Time the clock spends in its TWI interrupt is
+// time its display loop doesn't get, so it is added to the clock's time and
+// reported as display stall.
+//
+// With --serve the scenarios are skipped: once the two have booted and
+// synced, the WiFi module's pages are served over TCP on localhost for
+// load/page_load.py. See serve() for what that measures.
+//
+// usage: cosim [--error-rate R] [--seed N] [--max-clock HZ] [--stretch US]
+//              [--stretch-limit US] [--report-only] [--serve PORT [--serve-secs S]]
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <time.h>
+#include <unistd.h>
+#include <poll.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include "Arduino.h"
+#include "I2CBus.h"
+#include "ESP8266HTTPClient.h"
+#include "cosim.h"
+
+#define NODE_CLOCK 0
+#define NODE_ESP   1
+
+struct Node {
+  const char* name;
+  uint64_t micros;
+  bool running;
+  void (*loop)();
+};
+
+static Node nodes[2] = {
+  { "clock", 0, false, clocknode::loop },
+  { "esp",   0, false, espnode::loop },
+};
+
+static int current = -1;
+static bool yielding = false;
+static uint64_t stallApplied = 0;
+static bool reportOnly = false;
+static int failures = 0;
+
+// ------------------------------------------------------------------
+// Scheduling
+// ------------------------------------------------------------------
+// The clock pays for the interrupts the WiFi module's transactions caused
+static void applyStall() {
+  uint64_t stall = hostI2CBus.at(clocknode::slaveAddress()).serviceMicros;
+  nodes[NODE_CLOCK].micros += stall - stallApplied;
+  stallApplied = stall;
+}
+
+static void enter(int n) {
+  current = n;
+  if (n == NODE_CLOCK) applyStall();
+  hostMicros = nodes[n].micros;
+}
+
+static void leave() {
+  nodes[current].micros = hostMicros;
+  current = -1;
+}
+
+static void step(int n) {
+  enter(n);
+  nodes[n].loop();
+  leave();
+}
+
+// Run the other processor while this one waits
+static void onDelay(uint64_t until) {
+  if (yielding || (current < 0)) return;
+  int self = current;
+  int other = 1 - self;
+  if (!nodes[other].running) return;
+
+  yielding = true;
+  nodes[self].micros = until;
+  while (nodes[other].micros < until) step(other);
+  current = self;
+  hostMicros = until;
+  yielding = false;
+}
+
+// The clock's TWI interrupt runs on the clock, at the clock's time. Whatever
+// it costs is charged as display stall, not here.
+static uint64_t interruptedMicros = 0;
+
+static void onDevice(uint8_t address, bool entering) {
+  if ((address != clocknode::slaveAddress()) || (current != NODE_ESP)) return;
+  if (entering) {
+    interruptedMicros = hostMicros;
+    hostMicros = nodes[NODE_CLOCK].micros;
+  } else {
+    hostMicros = interruptedMicros;
+  }
+}
+
+// Run something on one processor outside its loop(), e.g. a web request
+template <class F> static void runOn(int n, F f) {
+  enter(n);
+  f();
+  leave();
+}
+
+static void runUntil(uint64_t target) {
+  for (;;) {
+    int next = -1;
+    for (int n = 0 ; n < 2 ; n++) {
+      if (nodes[n].running && (nodes[n].micros < target) && ((next < 0) || (nodes[n].micros < nodes[next].micros))) next = n;
+    }
+    if (next < 0) return;
+    step(next);
+  }
+}
+
+template <class P> static bool runUntil(P done, uint64_t timeoutMicros) {
+  uint64_t target = nodes[NODE_ESP].micros + timeoutMicros;
+  while (!done()) {
+    int next = (nodes[NODE_CLOCK].micros <= nodes[NODE_ESP].micros) ? NODE_CLOCK : NODE_ESP;
+    if (nodes[next].micros >= target) return false;
+    step(next);
+  }
+  return true;
+}
+
+// ------------------------------------------------------------------
+// Reporting
+// ------------------------------------------------------------------
+struct Window {
+  I2CStats bus;
+  I2CStats clock;
+  uint64_t espMicros;
+  uint64_t clockMicros;
+  uint64_t ticks;
+};
+
+static Window mark() {
+  Window w;
+  w.bus = hostI2CBus.total();
+  w.clock = hostI2CBus.at(clocknode::slaveAddress());
+  w.espMicros = nodes[NODE_ESP].micros;
+  w.clockMicros = nodes[NODE_CLOCK].micros;
+  w.ticks = clocknode::displayTicks();
+  return w;
+}
+
+static void report(const char* scenario, const Window& from) {
+  applyStall();
+  Window to = mark();
+  uint64_t elapsed = to.espMicros - from.espMicros;
+  uint64_t clockElapsed = to.clockMicros - from.clockMicros;
+  uint64_t busy = to.bus.busyMicros - from.bus.busyMicros;
+  uint64_t stall = to.clock.serviceMicros - from.clock.serviceMicros;
+  printf("%-14s %9.1f %6u %6u %4u %9.1f %6.2f%% %9.2f %6.3f%% %6u\n",
+         scenario,
+         elapsed / 1000.0,
+         to.bus.transactions - from.bus.transactions,
+         to.bus.bytes - from.bus.bytes,
+         to.bus.errors - from.bus.errors,
+         busy / 1000.0,
+         elapsed ? 100.0 * busy / elapsed : 0.0,
+         stall / 1000.0,
+         clockElapsed ? 100.0 * stall / clockElapsed : 0.0,
+         to.clock.maxServiceMicros);
+
+  // Start the next window's worst case afresh
+  hostI2CBus.resetStats();
+  stallApplied = 0;
+}
+
+static void check(bool ok, const char* what) {
+  if (!ok) {
+    printf("  %s: %s\n", reportOnly ? "note" : "FAIL", what);
+    if (!reportOnly) failures++;
+  }
+}
+
+// ------------------------------------------------------------------
+// Scenarios
+// ------------------------------------------------------------------
+static void bootDiscovery() {
+  runOn(NODE_CLOCK, clocknode::powerOn);
+  nodes[NODE_CLOCK].running = true;
+
+  Window w = mark();
+  runOn(NODE_ESP, espnode::powerOn);
+  nodes[NODE_ESP].running = true;
+  report("boot", w);
+
+  check(espnode::clockAddress() == clocknode::slaveAddress(), "WiFi module did not find the clock");
+  check(espnode::fastMode(), "fast mode was not negotiated");
+  check(espnode::clockHasStatus(), "clock did not report its status block");
+}
+
+static void timeSync() {
+  HTTPClient::hostHttpPayload = "2026,10,18,12,34,56";
+  Window w = mark();
+  espnode::requestSync();
+  bool synced = runUntil([] { return espnode::synced() && (clocknode::year() == 2026); }, 5000000);
+  report("time sync", w);
+
+  check(synced, "time sync did not finish");
+  check((clocknode::month() == 10) && (clocknode::day() == 18), "clock has the wrong date");
+  check((clocknode::hour() == 12) && (clocknode::minute() == 34), "clock has the wrong time");
+}
+
+static void configSave() {
+  static const char* const args[] = {
+    "dateFormat", "2",
+    "fadeSteps", "40",
+    "scrollSteps", "10",
+    "backLight", "3",
+    "redCnl", "5",
+    NULL
+  };
+
+  Window w = mark();
+  runOn(NODE_ESP, [] { espnode::request("/clockconfig", args); });
+  runUntil(nodes[NODE_ESP].micros + 100000);
+  report("config save", w);
+
+  check(espnode::optionWriteFailures() == 0, "clock did not confirm every option");
+  check((clocknode::dateFormat() == 2) && (clocknode::fadeSteps() == 40) && (clocknode::scrollSteps() == 10) &&
+        (clocknode::backlightMode() == 3) && (clocknode::redCnl() == 5), "clock is not running the new options");
+  check((clocknode::eepromDateFormat() == 2) && (clocknode::eepromFadeSteps() == 40), "clock did not save the options");
+  check((espnode::configDateFormat() == 2) && (espnode::configFadeSteps() == 40) && (espnode::configScrollSteps() == 10) &&
+        (espnode::configBacklightMode() == 3) && (espnode::configRedCnl() == 5), "WiFi module reads back different options");
+}
+
+static void configUpload() {
+  std::string snap;
+  runOn(NODE_ESP, [&snap] { snap = espnode::snapshotWithOptions(1, 30); });
+
+  Window w = mark();
+  int code = 0;
+  runOn(NODE_ESP, [&snap, &code] { code = espnode::upload("/config.bin", snap); });
+  runUntil(nodes[NODE_ESP].micros + 100000);
+  report("config upload", w);
+
+  check(code == 200, "snapshot was not accepted");
+  check((clocknode::dateFormat() == 1) && (clocknode::fadeSteps() == 30), "clock is not running the uploaded options");
+  check((clocknode::eepromDateFormat() == 1) && (clocknode::eepromFadeSteps() == 30), "clock did not save the uploaded options");
+}
+
+// The clock comes back up at standard speed. The WiFi module sees its
+// status sequence go back on the next option write, and agrees fast
+// mode with it again.
+static void clockRestart() {
+  // Something the WiFi module will have to write
+  char fadeSteps[4];
+  snprintf(fadeSteps, sizeof(fadeSteps), "%d", (espnode::configFadeSteps() == 40) ? 45 : 40);
+  const char* const args[] = {
+    "fadeSteps", fadeSteps,
+    NULL
+  };
+
+  Window w = mark();
+  runOn(NODE_CLOCK, clocknode::restart);
+  bool restarted = !clocknode::fastMode();
+  runOn(NODE_ESP, [&args] { espnode::request("/clockconfig", args); });
+  bool agreed = runUntil([] { return clocknode::fastMode() && espnode::fastMode(); }, 1000000);
+  report("clock restart", w);
+
+  check(restarted, "clock kept fast mode over the restart");
+  check(agreed, "fast mode was not agreed again after the clock restarted");
+}
+
+// Errors drop the bus to standard speed. Once it has been quiet for
+// I2C_RENEGOTIATE_MS the WiFi module tries fast mode again.
+static void fastModeRetry() {
+  static const char* const args[] = {
+    "dateFormat", "0",
+    "fadeSteps", "50",
+    "scrollSteps", "20",
+    "backLight", "1",
+    "redCnl", "7",
+    NULL
+  };
+
+  // Enough errors in a row to fall back, the rest of the writes go through
+  hostI2CBus.failNext(3, I2C_RESULT_DATA_NACK);
+  runOn(NODE_ESP, [] { espnode::request("/clockconfig", args); });
+  bool fellBack = !espnode::fastMode() && !clocknode::fastMode();
+
+  Window w = mark();
+  bool agreed = runUntil([] { return clocknode::fastMode() && espnode::fastMode(); }, 400000000ULL);
+  report("fast retry", w);
+
+  check(fellBack, "errors did not drop the bus to standard speed");
+  check(agreed, "fast mode was not agreed again after the errors stopped");
+}
+
+static void idle() {
+  Window w = mark();
+  runUntil(nodes[NODE_ESP].micros + 10000000);
+  report("idle 10s", w);
+}
+
+// ------------------------------------------------------------------
+// Serving the pages
+// ------------------------------------------------------------------
+static uint64_t wallMicros() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+// The path from the request line, "" if it isn't a GET we understand.
+// Query strings are dropped: page_load.py only fetches plain pages.
+static std::string readRequestPath(int fd) {
+  std::string request;
+  char buf[1024];
+  while (request.find("\r\n\r\n") == std::string::npos) {
+    struct pollfd pfd = { fd, POLLIN, 0 };
+    if ((poll(&pfd, 1, 1000) <= 0) || (request.size() > 8192)) return "";
+    ssize_t n = recv(fd, buf, sizeof(buf), 0);
+    if (n <= 0) return "";
+    request.append(buf, n);
+  }
+
+  if (request.compare(0, 4, "GET ") != 0) return "";
+  size_t end = request.find_first_of(" ?", 4);
+  if (end == std::string::npos) return "";
+  return request.substr(4, end - 4);
+}
+
+static void sendAll(int fd, const std::string& data) {
+  size_t pos = 0;
+  while (pos < data.size()) {
+    ssize_t n = send(fd, data.data() + pos, data.size() - pos, MSG_NOSIGNAL);
+    if (n <= 0) return;
+    pos += n;
+  }
+}
+
+// Serve the WiFi module's pages on localhost. Virtual time is kept in step
+// with the wall clock: between requests both firmwares run until they
+// catch up with it, and an answer goes out once the wall clock has caught
+// up with the virtual time the module took over it. Like the real server,
+// the module takes one request at a time from its loop(), the others wait
+// in the listen queue.
+//
+// So the times page_load.py sees include the I2C traffic, the delays and
+// the rest of the loop on the module, and the queueing behind other
+// clients. They don't include the ESP8266's own CPU time or its WiFi, so
+// they are a lower bound for a real module.
+static int serve(int port, int seconds) {
+  int listener = socket(AF_INET, SOCK_STREAM, 0);
+  int on = 1;
+  setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr.sin_port = htons(port);
+  if ((bind(listener, (struct sockaddr*) &addr, sizeof(addr)) != 0) || (listen(listener, 16) != 0)) {
+    perror("cosim: can't listen");
+    return 1;
+  }
+  printf("serving on http://127.0.0.1:%d for %d s\n", port, seconds);
+  fflush(stdout);
+
+  uint64_t wallStart = wallMicros();
+  uint64_t simStart = nodes[NODE_ESP].micros;
+  uint32_t served = 0;
+  while (wallMicros() - wallStart < seconds * 1000000ULL) {
+    runUntil(simStart + (wallMicros() - wallStart));
+
+    struct pollfd pfd = { listener, POLLIN, 0 };
+    if (poll(&pfd, 1, 1) <= 0) continue;
+    int fd = accept(listener, NULL, NULL);
+    if (fd < 0) continue;
+
+    std::string path = readRequestPath(fd);
+    if (path.empty()) {
+      sendAll(fd, "HTTP/1.0 400 Bad Request\r\nConnection: close\r\n\r\n");
+      close(fd);
+      continue;
+    }
+
+    uint32_t handled = espnode::requestsHandled();
+    espnode::queueRequest(path.c_str());
+    bool answered = runUntil([handled] { return espnode::requestsHandled() != handled; }, 10000000);
+    int code = answered ? espnode::responseCode() : 503;
+    std::string body = answered ? espnode::response() : std::string();
+
+    uint64_t due = wallStart + (nodes[NODE_ESP].micros - simStart);
+    uint64_t wallNow = wallMicros();
+    if (due > wallNow) usleep(due - wallNow);
+
+    char head[160];
+    snprintf(head, sizeof(head), "HTTP/1.0 %d %s\r\nContent-Type: %s\r\nContent-Length: %u\r\nConnection: close\r\n\r\n",
+             code ? code : 500, (code == 200) ? "OK" : "Error", espnode::responseType().c_str(), (unsigned) body.size());
+    sendAll(fd, head + body);
+    close(fd);
+    served++;
+  }
+
+  close(listener);
+  printf("served %u requests, %u I2C errors\n", served, espnode::i2cErrors());
+  return 0;
+}
+
+int main(int argc, char** argv) {
+  double errorRate = 0.0;
+  uint32_t seed = 1;
+  int servePort = 0;
+  int serveSecs = 60;
+
+  for (int i = 1 ; i < argc ; i++) {
+    if ((strcmp(argv[i], "--error-rate") == 0) && (i + 1 < argc)) {
+      errorRate = atof(argv[++i]);
+    } else if ((strcmp(argv[i], "--seed") == 0) && (i + 1 < argc)) {
+      seed = strtoul(argv[++i], NULL, 10);
+    } else if ((strcmp(argv[i], "--max-clock") == 0) && (i + 1 < argc)) {
+      hostI2CBus.setMaxClock(strtoul(argv[++i], NULL, 10));
+    } else if ((strcmp(argv[i], "--stretch") == 0) && (i + 1 < argc)) {
+      hostI2CBus.setStretch(clocknode::slaveAddress(), strtoul(argv[++i], NULL, 10));
+    } else if ((strcmp(argv[i], "--stretch-limit") == 0) && (i + 1 < argc)) {
+      hostI2CBus.setStretchLimit(strtoul(argv[++i], NULL, 10));
+    } else if (strcmp(argv[i], "--report-only") == 0) {
+      reportOnly = true;
+    } else if ((strcmp(argv[i], "--serve") == 0) && (i + 1 < argc)) {
+      servePort = atoi(argv[++i]);
+    } else if ((strcmp(argv[i], "--serve-secs") == 0) && (i + 1 < argc)) {
+      serveSecs = atoi(argv[++i]);
+    } else {
+      fprintf(stderr, "usage: %s [--error-rate R] [--seed N] [--max-clock HZ] [--stretch US] [--stretch-limit US] [--report-only] [--serve PORT [--serve-secs S]]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  hostDelayHook = onDelay;
+  hostI2CBus.setDeviceHook(onDevice);
+  hostI2CBus.setErrorRate(errorRate, seed);
+  espnode::joinNetwork("clocknet", "nixie1234");
+
+  printf("%-14s %9s %6s %6s %4s %9s %7s %9s %7s %6s\n",
+         "scenario", "ms", "xfers", "bytes", "errs", "bus ms", "bus", "stall ms", "stall", "max us");
+  bootDiscovery();
+  timeSync();
+  if (servePort > 0) {
+    return serve(servePort, serveSecs);
+  }
+  configSave();
+  configUpload();
+  clockRestart();
+  fastModeRetry();
+  idle();
+
+  if (failures > 0) {
+    printf("%d check(s) failed\n", failures);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,62 @@
+// Co-simulation of the clock and the WiFi module on one virtual I2C bus.
+//
+// Each firmware is its own translation unit (clock_node.cpp, esp_node.cpp),
+// so the two sketches' macros never meet. This is everything the scenarios
+// need from each side.
+#ifndef cosim_h
+#define cosim_h
+
+#include <stdint.h>
+#include <string>
+
+namespace clocknode {
+  void powerOn();
+  void restart();
+  void loop();
+  uint8_t slaveAddress();
+  long now();
+  int year();
+  int month();
+  int day();
+  int hour();
+  int minute();
+  int second();
+  uint8_t dateFormat();
+  uint8_t fadeSteps();
+  uint8_t scrollSteps();
+  uint8_t backlightMode();
+  uint8_t redCnl();
+  uint8_t eepromDateFormat();
+  uint8_t eepromFadeSteps();
+  uint64_t displayTicks();
+  bool fastMode();
+}
+
+namespace espnode {
+  void joinNetwork(const char* ssid, const char* password);
+  void powerOn();
+  void loop();
+  uint8_t clockAddress();
+  bool fastMode();
+  bool clockHasStatus();
+  uint32_t i2cErrors();
+  uint32_t optionWriteFailures();
+  int request(const char* uri, const char* const* args);
+  int upload(const char* uri, const std::string& body);
+  std::string download(const char* uri);
+  void queueRequest(const char* uri);
+  uint32_t requestsHandled();
+  int responseCode();
+  std::string responseType();
+  std::string response();
+  std::string snapshotWithOptions(uint8_t dateFormat, uint8_t fadeSteps);
+  uint8_t configDateFormat();
+  uint8_t configFadeSteps();
+  uint8_t configScrollSteps();
+  uint8_t configBacklightMode();
+  uint8_t configRedCnl();
+  bool synced();
+  void requestSync();
+}
+
+#endif
@@ -0,0 +1,72 @@
+#include "esp_firmware.h"
+#include "cosim.h"
+
+namespace espnode {
+  // Put the network in range and its credentials in EEPROM, as if the
+  // module had been set up through its web page before
+  void joinNetwork(const char* ssid, const char* password) {
+    WiFiClass::HostNetwork network;
+    network.ssid = ssid;
+    network.password = password;
+    network.rssi = -60;
+    WiFi.hostNetworks.push_back(network);
+    WiFi.hostConnectMicros = 1500000;
+    espfw::EEPROM.begin(512);
+    espfw::storeCredentialsInEEPROM(ssid, password);
+  }
+
+  void powerOn() { espfw::setup(); }
+  void loop() { espfw::loop(); }
+  uint8_t clockAddress() { return espfw::preferredI2CSlaveAddress; }
+  bool fastMode() { return espfw::i2cFastMode; }
+  bool clockHasStatus() { return espfw::clockHasStatus; }
+  uint32_t i2cErrors() { return espfw::i2cErrorCount; }
+  uint32_t optionWriteFailures() { return espfw::optionWriteFailures; }
+
+  // args is name, value, name, value, ..., NULL
+  int request(const char* uri, const char* const* args) {
+    std::vector<std::pair<String, String> > argList;
+    for (int i = 0 ; args && args[i] && args[i + 1] ; i += 2) {
+      argList.push_back(std::make_pair(String(args[i]), String(args[i + 1])));
+    }
+    return espfw::server.request(argList.empty() ? HTTP_GET : HTTP_POST, uri, argList);
+  }
+
+  int upload(const char* uri, const std::string& body) {
+    return espfw::server.upload(uri, body);
+  }
+
+  // What the handler wrote, whether through send() or straight to the client
+  std::string download(const char* uri) {
+    espfw::server.request(HTTP_GET, uri);
+    return espfw::server.responseBody + espfw::server.connections.back().sent;
+  }
+
+  // Leave a request for the module's own loop() to pick up, as a client
+  // on the network would
+  void queueRequest(const char* uri) { espfw::server.queue(HTTP_GET, uri); }
+  uint32_t requestsHandled() { return espfw::server.handled; }
+  int responseCode() { return espfw::server.responseCode; }
+  std::string responseType() { return espfw::server.responseType.c_str(); }
+  std::string response() { return espfw::server.responseBody + espfw::server.connections.back().sent; }
+
+  // The current config snapshot with two options changed, CRC and all
+  std::string snapshotWithOptions(uint8_t dateFormat, uint8_t fadeSteps) {
+    std::string snap = download("/config.bin");
+    if (snap.size() != SNAP_SIZE) return snap;
+    snap[SNAP_OPTIONS_OFFSET + I2C_OPT_DATE_FORMAT] = dateFormat;
+    snap[SNAP_OPTIONS_OFFSET + I2C_OPT_FADE_STEPS] = fadeSteps;
+    unsigned int crc = espfw::getCRC16((byte*) &snap[0], SNAP_CRC_OFFSET);
+    snap[SNAP_CRC_OFFSET] = crc / 256;
+    snap[SNAP_CRC_OFFSET + 1] = crc % 256;
+    return snap;
+  }
+
+  uint8_t configDateFormat() { return espfw::configDateFormat; }
+  uint8_t configFadeSteps() { return espfw::configFadeSteps; }
+  uint8_t configScrollSteps() { return espfw::configScrollSteps; }
+  uint8_t configBacklightMode() { return espfw::configBacklightMode; }
+  uint8_t configRedCnl() { return espfw::configRedCnl; }
+  bool synced() { return espfw::lastI2CUpdateTime != 0; }
+  void requestSync() { espfw::timeSyncRequested = true; }
+}
@@ -0,0 +1,95 @@
+// The sigma-delta dither in outputDisplay(): the fraction of a tick in
+// digitOffCountFine is carried from frame to frame, so the tubes take
+// 1/DITHER_SCALE tick brightness steps even where the slot is cut short.
+//
+// We run frames at each brightness and add up how long the tube was lit,
+// which is what the eye sees. The steps have to come out in order and in
+// proportion, and each frame's on time has to be one of two whole ticks.
+#include "clock_firmware.h"
+#include "HostCheck.h"
+
+using namespace clockfw;
+
+#define TUBE   0
+#define FRAMES 1024
+
+struct Luminance {
+  double duty;       // fraction of its sixth of the time the tube is lit
+  double expected;   // level / (dispCount + dark time), as a full slot gives
+  uint64_t minOn;    // shortest and longest on time in a frame, in ticks
+  uint64_t maxOn;
+};
+
+// Run the frames at this brightness, with gapMicros of the rest of the loop
+// between them
+static Luminance luminanceAt(int levelFine, uint32_t gapMicros) {
+  digitOffCountFine = levelFine;
+  digitOffCount = levelFine >> DITHER_SHIFT;
+
+  // Let the dark time average settle
+  for (int i = 0 ; i < 64 ; i++) {
+    outputDisplay();
+    hostAdvanceMicros(gapMicros);
+  }
+
+  clockhost::resetTicks();
+  Luminance l;
+  l.minOn = UINT64_MAX;
+  l.maxOn = 0;
+  uint64_t start = hostMicros;
+  for (int i = 0 ; i < FRAMES ; i++) {
+    uint64_t before = clockhost::litTicks[TUBE];
+    outputDisplay();
+    hostAdvanceMicros(gapMicros);
+    uint64_t on = clockhost::litTicks[TUBE] - before;
+    if (on < l.minOn) l.minOn = on;
+    if (on > l.maxOn) l.maxOn = on;
+  }
+  double elapsed = (double) (hostMicros - start);
+  double tickMicros = clockhost::tickNanos / 1000.0;
+  double darkTicks = (elapsed / tickMicros - clockhost::ticks) / (FRAMES * 6.0);
+  l.duty = 6.0 * clockhost::litTicks[TUBE] * tickMicros / elapsed;
+  l.expected = levelFine / (double) DITHER_SCALE / (dispCount + darkTicks);
+  return l;
+}
+
+// Every 1/DITHER_SCALE step from the level up to the level plus one tick
+static void testSteps(int level, uint32_t gapMicros) {
+  double last = 0.0;
+  double worst = 0.0;
+  int ordered = 0;
+  uint64_t spread = 0;
+  for (int step = 0 ; step <= DITHER_SCALE ; step++) {
+    Luminance l = luminanceAt(level * DITHER_SCALE + step, gapMicros);
+    double err = fabs(l.duty - l.expected) / l.expected;
+    if (err > worst) worst = err;
+    if ((step == 0) || (l.duty > last)) ordered++;
+    if (l.maxOn - l.minOn > spread) spread = l.maxOn - l.minOn;
+    last = l.duty;
+  }
+  printf("  level %3d, %3u us between frames: %2d of %2d steps in order, worst %.3f%% out, on time spread %u tick\n",
+         level, gapMicros, ordered, DITHER_SCALE + 1, worst * 100.0, (unsigned) spread);
+  CHECK(ordered == DITHER_SCALE + 1, "level %d: only %d steps in order", level, ordered);
+  CHECK(worst < 0.005, "level %d: %.3f%% from the level", level, worst * 100.0);
+  CHECK(spread <= 1, "level %d: on times %u ticks apart", level, (unsigned) spread);
+}
+
+int main() {
+  clockhost::powerOn();
+  uint64_t until = hostMicros + 5000000ULL;
+  while (hostMicros < until) loop();
+
+  // Back to back, and with the dark time of the rest of a loop
+  uint32_t gaps[2] = {0, 300};
+  for (int g = 0 ; g < 2 ; g++) {
+    testSteps(minDim, gaps[g]);
+    testSteps(101, gaps[g]);
+    testSteps(500, gaps[g]);
+    testSteps(DIGIT_DISPLAY_OFF - 1, gaps[g]);
+  }
+
+  printf("  %d brightness levels, %.1f bits\n", DIGIT_DISPLAY_COUNT * DITHER_SCALE,
+         log2((double) DIGIT_DISPLAY_COUNT * DITHER_SCALE));
+
+  return hostCheckExit("dither_test");
+}
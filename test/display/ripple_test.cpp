@@ -0,0 +1,182 @@
+// Sub slots and the interleaved scan order in outputDisplay(), against a
+// model of what the multiplexing does to the tubes and the HV supply.
+//
+// We record when each anode goes on and off, then:
+//
+//  - count how often each tube is lit a second, and its duty
+//  - pass each tube's light through a first order low pass with its corner
+//    at FUSION_HZ, a rough stand-in for the eye, and take the peak to peak
+//    of what is left against the mean: the flicker you would see
+//  - feed the tube current into the HV output capacitor, against the
+//    converter's average current, and take the peak to peak voltage: the
+//    ripple the boost converter sees
+//
+// More sub slots have to give a faster per tube refresh, the same duty, and
+// less flicker and ripple.
+#include <vector>
+
+#include "clock_firmware.h"
+#include "HostCheck.h"
+
+using namespace clockfw;
+
+#define FUSION_HZ       60.0
+#define TUBE_AMPS       0.002   // one IN-14 at its rated current
+#define HV_FARADS       4.7e-6  // HV output capacitor
+#define GAP_MICROS      300     // the rest of the loop between frames
+#define SETTLE_MICROS   100000ULL
+#define MEASURE_MICROS  500000ULL
+
+struct Edge {
+  double micros;   // to the nanosecond, the ticks are 1.6us
+  uint8_t lit;     // a bit for each tube
+};
+
+static std::vector<Edge> edges;
+static uint8_t lastLit = 0xff;
+static bool recording = false;
+
+static void recordTick() {
+  uint8_t lit = 0;
+  for (int i = 0 ; i < 6 ; i++) {
+    if ((PORTC & clockhost::anodeMaskC[i]) || (PORTD & clockhost::anodeMaskD[i])) lit |= (1 << i);
+  }
+  if (recording && (lit != lastLit)) {
+    Edge e = {hostMicros + clockhost::tickNanosCarry / 1000.0, lit};
+    edges.push_back(e);
+    lastLit = lit;
+  }
+  clockhost::tick();
+}
+
+struct Scan {
+  double refreshHz[6];
+  double duty[6];
+  double flicker[6];
+  double rippleVolts;
+};
+
+static Scan model(uint64_t start, uint64_t end) {
+  Scan s;
+  double seconds = (end - start) / 1e6;
+  double tau = 1.0 / (2.0 * M_PI * FUSION_HZ);
+
+  // Duty and refresh
+  double load = 0.0;
+  for (int t = 0 ; t < 6 ; t++) {
+    double lit = 0.0;
+    long onsets = 0;
+    for (size_t e = 0 ; e + 1 < edges.size() ; e++) {
+      bool on = (edges[e].lit >> t) & 1;
+      bool wasOn = (e > 0) && ((edges[e - 1].lit >> t) & 1);
+      if (on) lit += edges[e + 1].micros - edges[e].micros;
+      if (on && !wasOn) onsets++;
+    }
+    s.duty[t] = 6.0 * lit / (end - start);
+    s.refreshHz[t] = onsets / seconds;
+    load += lit;
+  }
+  double meanAmps = TUBE_AMPS * load / (end - start);
+
+  // Flicker: the eye's low pass, exact over each piece where the light is
+  // constant. Start it at the mean and skip the first 50ms so it has settled.
+  for (int t = 0 ; t < 6 ; t++) {
+    double y = s.duty[t] / 6.0;
+    double lo = 1e9;
+    double hi = -1e9;
+    for (size_t e = 0 ; e + 1 < edges.size() ; e++) {
+      double x = (edges[e].lit >> t) & 1;
+      double dt = (edges[e + 1].micros - edges[e].micros) / 1e6;
+      y += (x - y) * (1.0 - exp(-dt / tau));
+      if (edges[e + 1].micros - start > 50000.0) {
+        if (y < lo) lo = y;
+        if (y > hi) hi = y;
+      }
+    }
+    s.flicker[t] = (hi - lo) / (s.duty[t] / 6.0);
+  }
+
+  // Ripple: the capacitor takes the difference between the converter's
+  // average and the tube current
+  double v = 0.0;
+  double lo = 0.0;
+  double hi = 0.0;
+  for (size_t e = 0 ; e + 1 < edges.size() ; e++) {
+    double amps = 0.0;
+    for (int t = 0 ; t < 6 ; t++) if ((edges[e].lit >> t) & 1) amps += TUBE_AMPS;
+    v += (meanAmps - amps) * ((edges[e + 1].micros - edges[e].micros) / 1e6) / HV_FARADS;
+    if (v < lo) lo = v;
+    if (v > hi) hi = v;
+  }
+  s.rippleVolts = hi - lo;
+  return s;
+}
+
+static Scan scanAt(int level, byte slots) {
+  subSlots = slots;
+  digitOffCountFine = level * DITHER_SCALE;
+  digitOffCount = level;
+
+  uint64_t until = hostMicros + SETTLE_MICROS;
+  while (hostMicros < until) {
+    outputDisplay();
+    hostAdvanceMicros(GAP_MICROS);
+  }
+
+  edges.clear();
+  lastLit = 0xff;
+  recording = true;
+  uint64_t start = hostMicros;
+  until = start + MEASURE_MICROS;
+  while (hostMicros < until) {
+    outputDisplay();
+    hostAdvanceMicros(GAP_MICROS);
+  }
+  recordTick();
+  recording = false;
+  Edge last = {(double) hostMicros, 0};
+  edges.push_back(last);
+  return model(start, hostMicros);
+}
+
+static void testSubSlots(int level) {
+  Scan base;
+  for (byte slots = SUB_SLOTS_MIN ; slots <= SUB_SLOTS_MAX ; slots++) {
+    Scan s = scanAt(level, slots);
+    double worstFlicker = 0.0;
+    for (int t = 0 ; t < 6 ; t++) if (s.flicker[t] > worstFlicker) worstFlicker = s.flicker[t];
+    printf("  level %3d, %d sub slot(s): tube 0 %6.1f Hz duty %.4f, tube 5 %6.1f Hz duty %.4f, flicker %5.2f%%, ripple %6.3f V\n",
+           level, slots, s.refreshHz[0], s.duty[0], s.refreshHz[5], s.duty[5], worstFlicker * 100.0, s.rippleVolts);
+
+    if (slots == SUB_SLOTS_MIN) {
+      base = s;
+      continue;
+    }
+    for (int t = 0 ; t < 6 ; t++) {
+      CHECK(s.refreshHz[t] > (slots - 0.2) * base.refreshHz[t], "level %d, %d sub slots: tube %d refreshed at %.1f Hz, %.1f Hz with one",
+            level, slots, t, s.refreshHz[t], base.refreshHz[t]);
+      CHECK(fabs(s.duty[t] - base.duty[t]) < 0.01 * base.duty[t] + 0.001, "level %d, %d sub slots: tube %d duty %.4f, %.4f with one",
+            level, slots, t, s.duty[t], base.duty[t]);
+      CHECK(s.flicker[t] < base.flicker[t], "level %d, %d sub slots: tube %d flicker %.4f, %.4f with one",
+            level, slots, t, s.flicker[t], base.flicker[t]);
+    }
+    // Full on, one tube or another is always lit and the ripple is all
+    // from the dark time between frames, which sub slots don't change
+    CHECK(s.rippleVolts < 1.01 * base.rippleVolts, "level %d, %d sub slots: ripple %.3fV, %.3fV with one",
+          level, slots, s.rippleVolts, base.rippleVolts);
+  }
+}
+
+int main() {
+  clockhost::powerOn();
+  uint64_t until = hostMicros + 5000000ULL;
+  while (hostMicros < until) loop();
+
+  hostDisplayTickHook = recordTick;
+  testSubSlots(DIGIT_DISPLAY_OFF);
+  testSubSlots(500);
+  testSubSlots(minDim);
+  subSlots = SUB_SLOTS_DEFAULT;
+
+  return hostCheckExit("ripple_test");
+}
@@ -0,0 +1,79 @@
+// Digit slot sizing in outputDisplay(): cutting the slots down must raise
+// the refresh rate without changing how bright the tubes are.
+//
+// The reference is the full slot: dispCount ticks for each tube plus its
+// share of the dark time outside the digit loops, which we measure here
+// from the virtual time the ticks don't account for.
+#include "clock_firmware.h"
+#include "HostCheck.h"
+
+using namespace clockfw;
+
+// The tube we look at: the hours tens, which doesn't change while we measure
+#define TUBE 0
+
+struct FrameStats {
+  double duty;       // fraction of its sixth of the time the tube is lit
+  double fullDuty;   // what a full slot would give, with the same dark time
+  double hz;         // frames a second
+  double darkTicks;  // dark time a slot, in ticks
+};
+
+static void runFor(uint32_t ms) {
+  uint64_t until = hostMicros + ms * 1000ULL;
+  while (hostMicros < until) loop();
+}
+
+static FrameStats measure(uint32_t ms) {
+  clockhost::resetTicks();
+  uint64_t start = hostMicros;
+  uint64_t until = start + ms * 1000ULL;
+  long frames = 0;
+  while (hostMicros < until) {
+    loop();
+    frames++;
+  }
+  double elapsed = (double) (hostMicros - start);
+  double tickMicros = clockhost::tickNanos / 1000.0;
+
+  FrameStats s;
+  s.duty = 6.0 * clockhost::litTicks[TUBE] * tickMicros / elapsed;
+  s.darkTicks = (elapsed / tickMicros - clockhost::ticks) / (frames * 6.0);
+  double onTicks = (displayType[TUBE] == BRIGHT) ? DIGIT_DISPLAY_OFF : digitOffCountFine / (double) DITHER_SCALE;
+  s.fullDuty = onTicks / (dispCount + s.darkTicks);
+  s.hz = frames * 1e6 / elapsed;
+  return s;
+}
+
+static void setAntiGhost(byte value) {
+  antiGhost = value;
+  dispCount = DIGIT_DISPLAY_COUNT + antiGhost;
+}
+
+static void testBrightness(const char* name, bool ldr, int light, byte ghost) {
+  useLDR = ldr;
+  hostAnalogIn[LDRPin] = 1023 - light;
+  setAntiGhost(ghost);
+  runFor(3000);
+  FrameStats s = measure(2000);
+  printf("  %-7s ghost %2d: on %6.1f  duty %6.4f  full slot %6.4f  %6.1f Hz  dark %5.1f ticks (estimate %d)\n",
+         name, ghost, digitOffCountFine / (double) DITHER_SCALE, s.duty, s.fullDuty, s.hz, s.darkTicks, slotOverhead8 / 8);
+  CHECK(fabs(s.duty - s.fullDuty) < 0.02 * s.fullDuty, "%s: duty %.4f, full slot %.4f", name, s.duty, s.fullDuty);
+  CHECK(fabs(slotOverhead8 / 8 - s.darkTicks) <= 0.1 * s.darkTicks + 2, "%s: dark time estimate %d, measured %.1f", name, slotOverhead8 / 8, s.darkTicks);
+  CHECK(s.hz > 60.0, "%s: %.1f Hz", name, s.hz);
+}
+
+int main() {
+  clockhost::powerOn();
+  runFor(5000);
+
+  byte ghosts[2] = {ANTI_GHOST_DEFAULT, 50};
+  for (int g = 0 ; g < 2 ; g++) {
+    testBrightness("bright", false, 0, ghosts[g]);
+    testBrightness("day", true, 600, ghosts[g]);
+    testBrightness("evening", true, 400, ghosts[g]);
+    testBrightness("night", true, 0, ghosts[g]);
+  }
+
+  return hostCheckExit("slot_test");
+}
@@ -0,0 +1,244 @@
+#include <stdarg.h>
+#include <ctype.h>
+#include <string>
+
+#include "Arduino.h"
+
+// ------------------------------------------------------------------
+// Virtual time
+// ------------------------------------------------------------------
+uint64_t hostMicros = 0;
+uint32_t hostTimeCallMicros = 1;
+uint32_t hostAnalogReadMicros = 112;
+
+// 32 bits, as on both boards: the Time library keeps it in a uint32_t and
+// would spin for ever once a 64 bit millis() passed 49.7 days
+unsigned long millis() {
+  hostAdvanceMicros(hostTimeCallMicros);
+  return (uint32_t) (hostMicros / 1000);
+}
+
+unsigned long micros() {
+  hostAdvanceMicros(hostTimeCallMicros);
+  return (unsigned long) hostMicros;
+}
+
+void (*hostDelayHook)(uint64_t untilMicros) = NULL;
+
+void delay(unsigned long ms) {
+  uint64_t until = hostMicros + (uint64_t) ms * 1000;
+  if (hostDelayHook) hostDelayHook(until);
+  if (hostMicros < until) hostMicros = until;
+}
+
+void delayMicroseconds(unsigned int us) {
+  hostAdvanceMicros(us);
+}
+
+void yield() {
+}
+
+void hostAdvanceMicros(uint64_t us) {
+  hostMicros += us;
+}
+
+void hostAdvanceMillis(uint64_t ms) {
+  hostAdvanceMicros(ms * 1000);
+}
+
+// ------------------------------------------------------------------
+// Pins
+// ------------------------------------------------------------------
+int hostPinMode[HOST_PIN_COUNT];
+int hostPinLevel[HOST_PIN_COUNT];
+int hostAnalogIn[HOST_PIN_COUNT];
+int hostAnalogOut[HOST_PIN_COUNT];
+
+void pinMode(int pin, int mode) {
+  if ((pin >= 0) && (pin < HOST_PIN_COUNT)) {
+    hostPinMode[pin] = mode;
+    if (mode == INPUT_PULLUP) hostPinLevel[pin] = HIGH;
+  }
+}
+
+void digitalWrite(int pin, int level) {
+  if ((pin >= 0) && (pin < HOST_PIN_COUNT)) hostPinLevel[pin] = level;
+}
+
+int digitalRead(int pin) {
+  return ((pin >= 0) && (pin < HOST_PIN_COUNT)) ? hostPinLevel[pin] : LOW;
+}
+
+int analogRead(int pin) {
+  hostAdvanceMicros(hostAnalogReadMicros);
+  // The sketches read both A6 and 6 style pin numbers
+  if ((pin >= 0) && (pin < 8)) pin += A0;
+  return ((pin >= 0) && (pin < HOST_PIN_COUNT)) ? hostAnalogIn[pin] : 0;
+}
+
+void analogWrite(int pin, int value) {
+  if ((pin >= 0) && (pin < HOST_PIN_COUNT)) hostAnalogOut[pin] = value;
+}
+
+// Deterministic, so runs can be compared
+static unsigned long hostRandomState = 1;
+
+static unsigned long hostRandomNext() {
+  hostRandomState = hostRandomState * 1103515245UL + 12345UL;
+  return (hostRandomState >> 16) & 0x7fff;
+}
+
+long random(long howBig) {
+  if (howBig <= 0) return 0;
+  return (long) (((hostRandomNext() << 15) | hostRandomNext()) % (unsigned long) howBig);
+}
+
+long random(long howSmall, long howBig) {
+  if (howSmall >= howBig) return howSmall;
+  return howSmall + random(howBig - howSmall);
+}
+
+void randomSeed(unsigned long seed) {
+  hostRandomState = seed;
+}
+
+// ------------------------------------------------------------------
+// AVR registers
+// ------------------------------------------------------------------
+volatile uint8_t PORTB, PORTC, PORTD, DDRB, DDRC, DDRD, PINB, PINC, PIND;
+volatile uint8_t TCCR1A, TCCR1B, TCCR2A, TCCR2B, TIMSK0, TIFR0, OCR0A, OCR0B, OCR2A, OCR2B, TCNT0, SREG;
+volatile uint16_t ICR1, OCR1A, TCNT1;
+
+void hostReset() {
+  hostMicros = 0;
+  for (int i = 0 ; i < HOST_PIN_COUNT ; i++) {
+    hostPinMode[i] = INPUT;
+    hostPinLevel[i] = HIGH;
+    hostAnalogIn[i] = 0;
+    hostAnalogOut[i] = 0;
+  }
+  PORTB = PORTC = PORTD = DDRB = DDRC = DDRD = PINB = PINC = PIND = 0;
+  TCCR1A = TCCR1B = TCCR2A = TCCR2B = TIMSK0 = TIFR0 = OCR0A = OCR0B = OCR2A = OCR2B = TCNT0 = SREG = 0;
+  ICR1 = OCR1A = TCNT1 = 0;
+  hostRandomState = 1;
+}
+
+// Inputs float high, like the buttons with their pull ups
+static struct HostPowerOn {
+  HostPowerOn() { hostReset(); }
+} hostPowerOn;
+
+void (*hostDisplayTickHook)() = NULL;
+
+// ------------------------------------------------------------------
+// String
+// ------------------------------------------------------------------
+String String::substring(unsigned int from, unsigned int to) const {
+  if (from > to) {
+    unsigned int t = from;
+    from = to;
+    to = t;
+  }
+  if (from >= s.size()) return String();
+  return String(s.substr(from, to - from));
+}
+
+void String::trim() {
+  size_t b = 0;
+  while ((b < s.size()) && isspace((unsigned char) s[b])) b++;
+  size_t e = s.size();
+  while ((e > b) && isspace((unsigned char) s[e - 1])) e--;
+  s = s.substr(b, e - b);
+}
+
+void String::toLowerCase() {
+  for (size_t i = 0; i < s.size(); i++) s[i] = tolower((unsigned char) s[i]);
+}
+
+void String::toUpperCase() {
+  for (size_t i = 0; i < s.size(); i++) s[i] = toupper((unsigned char) s[i]);
+}
+
+void String::replace(const String& from, const String& to) {
+  if (from.s.empty()) return;
+  size_t p = 0;
+  while ((p = s.find(from.s, p)) != std::string::npos) {
+    s.replace(p, from.s.size(), to.s);
+    p += to.s.size();
+  }
+}
+
+void String::getBytes(unsigned char* buf, unsigned int len) const {
+  if (len == 0) return;
+  size_t n = s.size();
+  if (n > len - 1) n = len - 1;
+  memcpy(buf, s.data(), n);
+  buf[n] = 0;
+}
+
+std::string String::toBase(unsigned long long v, unsigned char base) {
+  if ((base < 2) || (base > 36)) base = 10;
+  std::string r;
+  do {
+    int d = v % base;
+    r.insert(r.begin(), (char) ((d < 10) ? ('0' + d) : ('a' + d - 10)));
+    v /= base;
+  } while (v > 0);
+  return r;
+}
+
+std::string String::toBase(long long v, unsigned char base) {
+  if ((base == 10) && (v < 0)) return "-" + toBase((unsigned long long) -v, base);
+  return toBase((unsigned long long) v, base);
+}
+
+std::string String::toFixed(double v, unsigned char decimals) {
+  char buf[64];
+  snprintf(buf, sizeof(buf), "%.*f", decimals, v);
+  return buf;
+}
+
+String operator+(const String& a, const String& b) { return String(a.s + b.s); }
+String operator+(const String& a, const char* b) { return String(a.s + b); }
+String operator+(const char* a, const String& b) { return String(std::string(a) + b.s); }
+String operator+(const String& a, char b) { return String(a.s + b); }
+String operator+(const String& a, int b) { return a + String(b); }
+String operator+(const String& a, unsigned int b) { return a + String(b); }
+String operator+(const String& a, long b) { return a + String(b); }
+String operator+(const String& a, unsigned long b) { return a + String(b); }
+String operator+(const String& a, double b) { return a + String(b); }
+
+// ------------------------------------------------------------------
+// Print and Serial
+// ------------------------------------------------------------------
+size_t Print::write(const uint8_t* buf, size_t len) {
+  size_t n = 0;
+  while (len--) n += write(*buf++);
+  return n;
+}
+
+size_t Print::printf(const char* format, ...) {
+  char buf[256];
+  va_list args;
+  va_start(args, format);
+  int len = vsnprintf(buf, sizeof(buf), format, args);
+  va_end(args);
+  if (len < 0) return 0;
+  if (len >= (int) sizeof(buf)) len = sizeof(buf) - 1;
+  return write((const uint8_t*) buf, len);
+}
+
+// Serial output is dropped unless HOST_SERIAL is set in the environment
+size_t HardwareSerial::write(uint8_t c) {
+  static int echo = -1;
+  if (echo < 0) echo = (getenv("HOST_SERIAL") != NULL) ? 1 : 0;
+  if (echo) fputc(c, stderr);
+  return 1;
+}
+
+HardwareSerial Serial;
+
+char* dtostrf(double val, signed char width, unsigned char prec, char* buf) {
+  sprintf(buf, "%*.*f", width, prec, val);
+  return buf;
+}
@@ -0,0 +1,253 @@
+// Host build of the bits of the Arduino and ESP8266 cores the firmware uses.
+//
+// Time is virtual: millis() and micros() only move when the test moves them,
+// or when something that takes time on the real hardware (delay(), a display
+// tick, an I2C transaction) runs. Pins, ports and timer registers are plain
+// variables the tests can look at.
+#ifndef Arduino_h
+#define Arduino_h
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+// The stubs use these, and they have to come before min() and max()
+#include <string>
+#include <vector>
+#include <deque>
+#include <algorithm>
+#include <utility>
+
+#include "binary.h"
+
+#ifndef F_CPU
+#define F_CPU 16000000L
+#endif
+
+typedef uint8_t byte;
+typedef bool boolean;
+typedef unsigned int word;
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+
+#define A0 14
+#define A1 15
+#define A2 16
+#define A3 17
+#define A4 18
+#define A5 19
+#define A6 20
+#define A7 21
+
+#define HOST_PIN_COUNT 32
+
+#include "host_pgmspace.h"
+
+#define min(a,b) ((a)<(b)?(a):(b))
+#define max(a,b) ((a)>(b)?(a):(b))
+#define abs(x) ((x)>0?(x):-(x))
+#define constrain(amt,low,high) ((amt)<(low)?(low):((amt)>(high)?(high):(amt)))
+#define lowByte(w) ((uint8_t) ((w) & 0xff))
+#define highByte(w) ((uint8_t) ((w) >> 8))
+
+// ------------------------------------------------------------------
+// Virtual time
+// ------------------------------------------------------------------
+extern uint64_t hostMicros;
+extern uint32_t hostTimeCallMicros;     // what a millis() or micros() call costs, so busy waits end
+extern uint32_t hostAnalogReadMicros;   // one ADC conversion
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+void hostAdvanceMicros(uint64_t us);
+void hostAdvanceMillis(uint64_t ms);
+
+// If set, delay() hands the wait to this, so a co-simulation can run the
+// other firmware in the meantime. It gets the time the delay ends.
+extern void (*hostDelayHook)(uint64_t untilMicros);
+
+// Back to power on: time, pins and registers
+void hostReset();
+
+// ------------------------------------------------------------------
+// Pins
+// ------------------------------------------------------------------
+extern int hostPinMode[HOST_PIN_COUNT];
+extern int hostPinLevel[HOST_PIN_COUNT];     // what digitalWrite() set, or what digitalRead() returns, HIGH to start with
+extern int hostAnalogIn[HOST_PIN_COUNT];     // what analogRead() returns
+extern int hostAnalogOut[HOST_PIN_COUNT];    // last analogWrite()
+void pinMode(int pin, int mode);
+void digitalWrite(int pin, int level);
+int digitalRead(int pin);
+int analogRead(int pin);
+void analogWrite(int pin, int value);
+
+long random(long howBig);
+long random(long howSmall, long howBig);
+void randomSeed(unsigned long seed);
+
+// ------------------------------------------------------------------
+// AVR registers the clock pokes directly
+// ------------------------------------------------------------------
+extern volatile uint8_t PORTB, PORTC, PORTD, DDRB, DDRC, DDRD, PINB, PINC, PIND;
+extern volatile uint8_t TCCR1A, TCCR1B, TCCR2A, TCCR2B, TIMSK0, TIFR0, OCR0A, OCR0B, OCR2A, OCR2B, TCNT0, SREG;
+extern volatile uint16_t ICR1, OCR1A, TCNT1;
+
+#define WGM10 0
+#define WGM11 1
+#define WGM12 3
+#define WGM13 4
+#define WGM20 0
+#define WGM21 1
+#define CS10 0
+#define CS11 1
+#define CS12 2
+#define CS20 0
+#define CS21 1
+#define CS22 2
+#define COM1A0 6
+#define COM1A1 7
+#define COM2B0 4
+#define COM2B1 5
+#define OCIE0A 1
+#define OCF0A 1
+
+// ESP8266 only
+#define ADC_MODE(mode)
+#define ADC_VCC 1
+
+#define ISR(vector) void vector()
+inline void cli() {}
+inline void sei() {}
+
+// The display loop calls this once per tick. Tests that model the tubes set
+// the hook, otherwise a tick costs nothing.
+extern void (*hostDisplayTickHook)();
+inline void hostDisplayTick() { if (hostDisplayTickHook) hostDisplayTickHook(); }
+#define DISPLAY_TICK() hostDisplayTick()
+
+// ------------------------------------------------------------------
+// String, Print and Serial, enough for the WiFi module
+// ------------------------------------------------------------------
+class String {
+  public:
+    String() {}
+    String(const char* c) : s(c ? c : "") {}
+    String(const std::string& x) : s(x) {}
+    String(char c) : s(1, c) {}
+    String(unsigned char v, unsigned char base = 10) : s(toBase(v, base)) {}
+    String(int v, unsigned char base = 10) : s(toBase(v, base)) {}
+    String(unsigned int v, unsigned char base = 10) : s(toBase(v, base)) {}
+    String(long v, unsigned char base = 10) : s(toBase(v, base)) {}
+    String(unsigned long v, unsigned char base = 10) : s(toBase(v, base)) {}
+    String(long long v) : s(std::to_string(v)) {}
+    String(unsigned long long v) : s(std::to_string(v)) {}
+    String(double v, unsigned char decimals = 2) : s(toFixed(v, decimals)) {}
+    String(float v, unsigned char decimals = 2) : s(toFixed(v, decimals)) {}
+
+    unsigned int length() const { return s.size(); }
+    const char* c_str() const { return s.c_str(); }
+    char charAt(unsigned int i) const { return (i < s.size()) ? s[i] : 0; }
+    char operator[](unsigned int i) const { return charAt(i); }
+    char& operator[](unsigned int i) { return s[i]; }
+    String substring(unsigned int from) const { return (from < s.size()) ? s.substr(from) : ""; }
+    String substring(unsigned int from, unsigned int to) const;
+    bool startsWith(const String& o) const { return s.compare(0, o.s.size(), o.s) == 0; }
+    bool endsWith(const String& o) const { return (s.size() >= o.s.size()) && (s.compare(s.size() - o.s.size(), o.s.size(), o.s) == 0); }
+    int indexOf(char c, unsigned int from = 0) const { size_t p = s.find(c, from); return (p == std::string::npos) ? -1 : (int) p; }
+    int indexOf(const String& c, unsigned int from = 0) const { size_t p = s.find(c.s, from); return (p == std::string::npos) ? -1 : (int) p; }
+    long toInt() const { return atol(s.c_str()); }
+    float toFloat() const { return atof(s.c_str()); }
+    void trim();
+    void toLowerCase();
+    void toUpperCase();
+    void replace(const String& from, const String& to);
+    bool reserve(unsigned int) { return true; }
+    bool equals(const String& o) const { return s == o.s; }
+    void getBytes(unsigned char* buf, unsigned int len) const;
+    void toCharArray(char* buf, unsigned int len) const { getBytes((unsigned char*) buf, len); }
+
+    bool operator==(const String& o) const { return s == o.s; }
+    bool operator!=(const String& o) const { return s != o.s; }
+    bool operator==(const char* o) const { return s == o; }
+    bool operator!=(const char* o) const { return s != o; }
+    bool operator<(const String& o) const { return s < o.s; }
+
+    String& operator+=(const String& o) { s += o.s; return *this; }
+    String& operator+=(const char* o) { s += o; return *this; }
+    String& operator+=(char c) { s += c; return *this; }
+    String& operator+=(unsigned char v) { s += std::to_string(v); return *this; }
+    String& operator+=(int v) { s += std::to_string(v); return *this; }
+    String& operator+=(unsigned int v) { s += std::to_string(v); return *this; }
+    String& operator+=(long v) { s += std::to_string(v); return *this; }
+    String& operator+=(unsigned long v) { s += std::to_string(v); return *this; }
+    String& operator+=(long long v) { s += std::to_string(v); return *this; }
+    String& operator+=(unsigned long long v) { s += std::to_string(v); return *this; }
+    String& operator+=(double v) { s += toFixed(v, 2); return *this; }
+
+    std::string s;
+
+  private:
+    static std::string toBase(unsigned long long v, unsigned char base);
+    static std::string toBase(long long v, unsigned char base);
+    static std::string toBase(int v, unsigned char base) { return toBase((long long) v, base); }
+    static std::string toBase(long v, unsigned char base) { return toBase((long long) v, base); }
+    static std::string toBase(unsigned char v, unsigned char base) { return toBase((unsigned long long) v, base); }
+    static std::string toBase(unsigned int v, unsigned char base) { return toBase((unsigned long long) v, base); }
+    static std::string toBase(unsigned long v, unsigned char base) { return toBase((unsigned long long) v, base); }
+    static std::string toFixed(double v, unsigned char decimals);
+};
+
+String operator+(const String& a, const String& b);
+String operator+(const String& a, const char* b);
+String operator+(const char* a, const String& b);
+String operator+(const String& a, char b);
+String operator+(const String& a, int b);
+String operator+(const String& a, unsigned int b);
+String operator+(const String& a, long b);
+String operator+(const String& a, unsigned long b);
+String operator+(const String& a, double b);
+
+class Print {
+  public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* buf, size_t len);
+    size_t write(const char* str) { return write((const uint8_t*) str, strlen(str)); }
+    size_t print(const String& s) { return write((const uint8_t*) s.c_str(), s.length()); }
+    size_t print(const char* s) { return write(s); }
+    size_t print(char c) { return write((uint8_t) c); }
+    size_t print(int v) { return print(String(v)); }
+    size_t print(unsigned int v) { return print(String(v)); }
+    size_t print(long v) { return print(String(v)); }
+    size_t print(unsigned long v) { return print(String(v)); }
+    size_t print(double v) { return print(String(v)); }
+    size_t println() { return write("\r\n"); }
+    template <class T> size_t println(T v) { return print(v) + println(); }
+    size_t printf(const char* format, ...);
+};
+
+class HardwareSerial : public Print {
+  public:
+    void begin(unsigned long) {}
+    void end() {}
+    int available() { return 0; }
+    int read() { return -1; }
+    void flush() {}
+    size_t write(uint8_t c);
+    using Print::write;
+    operator bool() { return true; }
+};
+
+extern HardwareSerial Serial;
+
+char* dtostrf(double val, signed char width, unsigned char prec, char* buf);
+
+#endif
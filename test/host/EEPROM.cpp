@@ -0,0 +1,38 @@
+#include <string.h>
+
+#include "Arduino.h"
+#include "EEPROM.h"
+
+EEPROMClass::EEPROMClass(uint32_t writeMicros, uint32_t commitMicros) {
+  this->writeMicros = writeMicros;
+  this->commitMicros = commitMicros;
+  erase();
+}
+
+void EEPROMClass::erase() {
+  memset(data, 0xff, sizeof(data));
+  writes = 0;
+  commits = 0;
+}
+
+uint8_t EEPROMClass::read(int address) {
+  return ((address >= 0) && (address < HOST_EEPROM_SIZE)) ? data[address] : 0xff;
+}
+
+void EEPROMClass::write(int address, uint8_t value) {
+  if ((address >= 0) && (address < HOST_EEPROM_SIZE)) {
+    data[address] = value;
+    writes++;
+    hostAdvanceMicros(writeMicros);
+  }
+}
+
+void EEPROMClass::update(int address, uint8_t value) {
+  if (read(address) != value) write(address, value);
+}
+
+bool EEPROMClass::commit() {
+  commits++;
+  hostAdvanceMicros(commitMicros);
+  return true;
+}
@@ -0,0 +1,34 @@
+// Host EEPROM: 1k of memory that starts erased, as a new chip would. Writes
+// take the time they take on the chip: about 3.3ms a byte on the AVR, while
+// the ESP8266 only pays when commit() flashes the whole sector.
+#ifndef EEPROM_h
+#define EEPROM_h
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define HOST_EEPROM_SIZE 1024
+#define AVR_EEPROM_WRITE_MICROS 3300
+
+class EEPROMClass {
+  public:
+    explicit EEPROMClass(uint32_t writeMicros = AVR_EEPROM_WRITE_MICROS, uint32_t commitMicros = 0);
+
+    uint8_t read(int address);
+    void write(int address, uint8_t value);
+    void update(int address, uint8_t value);
+    void begin(size_t size) { (void) size; }
+    bool commit();
+    void end() {}
+    uint16_t length() { return HOST_EEPROM_SIZE; }
+
+    // Test side
+    void erase();
+    uint32_t writeMicros;
+    uint32_t commitMicros;
+    uint32_t writes;
+    uint32_t commits;
+    uint8_t data[HOST_EEPROM_SIZE];
+};
+
+#endif
@@ -0,0 +1,50 @@
+#include "ESP8266HTTPClient.h"
+
+int HTTPClient::hostHttpCode = HTTP_CODE_OK;
+std::string HTTPClient::hostHttpPayload = "2017,1,1,0,0,0";
+uint32_t HTTPClient::hostHttpConnectMicros = 60000;
+uint32_t HTTPClient::hostHttpRoundTripMicros = 40000;
+uint32_t HTTPClient::hostHttpGets = 0;
+uint32_t HTTPClient::hostHttpConnects = 0;
+std::string HTTPClient::hostHttpLastURL;
+
+bool HTTPClient::begin(WiFiClient& client, const String& url) {
+  currentURL = url.s;
+  this->client = &client;
+  return true;
+}
+
+// With reuse the socket stays open between GETs and only the first pays for
+// the TCP handshake
+int HTTPClient::GET() {
+  hostHttpGets++;
+  hostHttpLastURL = currentURL;
+  if (!client->connected()) {
+    if (client->connection() == NULL) *client = WiFiClient(&ownConnection);
+    *client->connection() = HostConnection();
+    hostHttpConnects++;
+    hostAdvanceMicros(hostHttpConnectMicros);
+  }
+  if (hostHttpCode == HTTPC_ERROR_READ_TIMEOUT) {
+    hostAdvanceMicros((uint64_t) timeoutMs * 1000);
+    client->stop();
+    return hostHttpCode;
+  }
+  hostAdvanceMicros(hostHttpRoundTripMicros);
+  return hostHttpCode;
+}
+
+void HTTPClient::end() {
+  if (!reuse) client->stop();
+}
+
+String HTTPClient::errorToString(int error) {
+  switch (error) {
+    case HTTPC_ERROR_CONNECTION_REFUSED:
+      return "connection refused";
+    case HTTPC_ERROR_READ_TIMEOUT:
+      return "read Timeout";
+    default:
+      return String();
+  }
+}
@@ -0,0 +1,50 @@
+// Host HTTPClient. Every GET gets the same canned answer, after a
+// configurable round trip of virtual time.
+#ifndef ESP8266HTTPClient_h
+#define ESP8266HTTPClient_h
+
+#include <string>
+
+#include "ESP8266WiFi.h"
+
+#define HTTP_CODE_OK 200
+#define HTTP_CODE_NOT_MODIFIED 304
+#define HTTPC_ERROR_CONNECTION_REFUSED (-1)
+#define HTTPC_ERROR_READ_TIMEOUT (-11)
+
+class HTTPClient {
+  public:
+    HTTPClient() : client(&defaultClient), reuse(false), timeoutMs(5000) {}
+
+    bool begin(const String& url) { currentURL = url.s; client = &defaultClient; return true; }
+    bool begin(WiFiClient& client, const String& url);
+    void end();
+    void addHeader(const String& name, const String& value) { (void) name; (void) value; }
+    void setReuse(bool reuse) { this->reuse = reuse; }
+    void setTimeout(uint16_t timeout) { timeoutMs = timeout; }
+    int GET();
+    String getString() { return String(hostHttpPayload); }
+    int getSize() { return hostHttpPayload.size(); }
+    bool connected() { return client->connected(); }
+    static String errorToString(int error);
+
+    // Test side, shared by every client
+    static int hostHttpCode;
+    static std::string hostHttpPayload;
+    static uint32_t hostHttpConnectMicros;
+    static uint32_t hostHttpRoundTripMicros;
+    static uint32_t hostHttpGets;
+    static uint32_t hostHttpConnects;
+    static std::string hostHttpLastURL;
+
+  private:
+    std::string currentURL;
+    // Like the real one, we work on the caller's client
+    WiFiClient* client;
+    WiFiClient defaultClient;
+    HostConnection ownConnection;
+    bool reuse;
+    uint16_t timeoutMs;
+};
+
+#endif
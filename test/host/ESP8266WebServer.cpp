@@ -0,0 +1,146 @@
+#include "ESP8266WebServer.h"
+
+ESP8266WebServer::ESP8266WebServer(int port) {
+  (void) port;
+  notFoundHandler = NULL;
+  currentMethod = HTTP_GET;
+  contentLength = CONTENT_LENGTH_UNKNOWN;
+  responseCode = 0;
+  handled = 0;
+  started = false;
+  connections.push_back(HostConnection());
+}
+
+void ESP8266WebServer::on(const char* uri, HTTPMethod method, THandlerFunction handler, THandlerFunction uploadHandler) {
+  Route route;
+  route.uri = uri;
+  route.method = method;
+  route.handler = handler;
+  route.uploadHandler = uploadHandler;
+  routes.push_back(route);
+}
+
+const ESP8266WebServer::Route* ESP8266WebServer::find(HTTPMethod method, const String& uri) const {
+  for (size_t i = 0 ; i < routes.size() ; i++) {
+    if ((routes[i].uri == uri.s) && ((routes[i].method == HTTP_ANY) || (routes[i].method == method))) {
+      return &routes[i];
+    }
+  }
+  return NULL;
+}
+
+void ESP8266WebServer::reset(HTTPMethod method, const String& uri) {
+  currentMethod = method;
+  currentUri = uri;
+  responseCode = 0;
+  responseType = "";
+  responseBody.clear();
+  responseHeaders.clear();
+  contentLength = CONTENT_LENGTH_UNKNOWN;
+  connections.push_back(HostConnection());
+}
+
+int ESP8266WebServer::request(HTTPMethod method, const String& uri, const std::vector<std::pair<String, String> >& args) {
+  reset(method, uri);
+  argList = args;
+  const Route* route = find(method, uri);
+  if (route != NULL) {
+    route->handler();
+  } else if (notFoundHandler != NULL) {
+    notFoundHandler();
+  } else {
+    send(404, "text/plain", "Not found");
+  }
+  handled++;
+  return responseCode;
+}
+
+int ESP8266WebServer::upload(const String& uri, const std::string& body, size_t bufferSize) {
+  reset(HTTP_POST, uri);
+  argList.clear();
+  const Route* route = find(HTTP_POST, uri);
+  if ((route == NULL) || (route->uploadHandler == NULL)) return request(HTTP_POST, uri);
+  if (bufferSize > HTTP_UPLOAD_BUFLEN) bufferSize = HTTP_UPLOAD_BUFLEN;
+
+  currentUpload.filename = "upload.bin";
+  currentUpload.name = "file";
+  currentUpload.type = "application/octet-stream";
+  currentUpload.totalSize = 0;
+  currentUpload.currentSize = 0;
+  currentUpload.status = UPLOAD_FILE_START;
+  route->uploadHandler();
+
+  for (size_t pos = 0 ; pos < body.size() ; pos += bufferSize) {
+    size_t n = body.size() - pos;
+    if (n > bufferSize) n = bufferSize;
+    memcpy(currentUpload.buf, body.data() + pos, n);
+    currentUpload.currentSize = n;
+    currentUpload.totalSize += n;
+    currentUpload.status = UPLOAD_FILE_WRITE;
+    route->uploadHandler();
+  }
+
+  currentUpload.currentSize = 0;
+  currentUpload.status = UPLOAD_FILE_END;
+  route->uploadHandler();
+
+  route->handler();
+  handled++;
+  return responseCode;
+}
+
+void ESP8266WebServer::queue(HTTPMethod method, const String& uri, const std::vector<std::pair<String, String> >& args) {
+  Pending p;
+  p.method = method;
+  p.uri = uri;
+  p.args = args;
+  pending.push_back(p);
+}
+
+// One request per call, as the real server does
+void ESP8266WebServer::handleClient() {
+  if (pending.empty()) return;
+  Pending p = pending.front();
+  pending.erase(pending.begin());
+  request(p.method, p.uri, p.args);
+}
+
+bool ESP8266WebServer::hasArg(const String& name) {
+  for (size_t i = 0 ; i < argList.size() ; i++) {
+    if (argList[i].first == name) return true;
+  }
+  return false;
+}
+
+String ESP8266WebServer::arg(const String& name) {
+  for (size_t i = 0 ; i < argList.size() ; i++) {
+    if (argList[i].first == name) return argList[i].second;
+  }
+  return String();
+}
+
+String ESP8266WebServer::arg(int i) {
+  return ((i >= 0) && (i < (int) argList.size())) ? argList[i].second : String();
+}
+
+String ESP8266WebServer::argName(int i) {
+  return ((i >= 0) && (i < (int) argList.size())) ? argList[i].first : String();
+}
+
+void ESP8266WebServer::send(int code, const char* contentType, const String& content) {
+  responseCode = code;
+  responseType = contentType ? contentType : "";
+  responseBody += content.s;
+}
+
+void ESP8266WebServer::sendHeader(const String& name, const String& value, bool first) {
+  if (first) {
+    responseHeaders.insert(responseHeaders.begin(), std::make_pair(name, value));
+  } else {
+    responseHeaders.push_back(std::make_pair(name, value));
+  }
+}
+
+void ESP8266WebServer::sendContent(const String& content) {
+  responseBody += content.s;
+}
@@ -0,0 +1,107 @@
+// Host ESP8266WebServer. Handlers are registered as usual; the test then
+// calls request() to run one, and looks at what was sent back.
+#ifndef ESP8266WebServer_h
+#define ESP8266WebServer_h
+
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "ESP8266WiFi.h"
+
+enum HTTPMethod { HTTP_ANY, HTTP_GET, HTTP_POST, HTTP_PUT, HTTP_PATCH, HTTP_DELETE, HTTP_OPTIONS };
+enum HTTPUploadStatus { UPLOAD_FILE_START, UPLOAD_FILE_WRITE, UPLOAD_FILE_END, UPLOAD_FILE_ABORTED };
+
+#define HTTP_UPLOAD_BUFLEN 2048
+#define CONTENT_LENGTH_UNKNOWN ((size_t) -1)
+
+struct HTTPUpload {
+  HTTPUploadStatus status;
+  String filename;
+  String name;
+  String type;
+  size_t totalSize;
+  size_t currentSize;
+  uint8_t buf[HTTP_UPLOAD_BUFLEN];
+};
+
+typedef void (*THandlerFunction)();
+
+class ESP8266WebServer {
+  public:
+    explicit ESP8266WebServer(int port = 80);
+
+    void on(const char* uri, THandlerFunction handler) { on(uri, HTTP_ANY, handler); }
+    void on(const char* uri, HTTPMethod method, THandlerFunction handler) { on(uri, method, handler, NULL); }
+    void on(const char* uri, HTTPMethod method, THandlerFunction handler, THandlerFunction uploadHandler);
+    void onNotFound(THandlerFunction handler) { notFoundHandler = handler; }
+    void begin() { started = true; }
+    void handleClient();
+
+    bool hasArg(const String& name);
+    String arg(const String& name);
+    String arg(int i);
+    String argName(int i);
+    int args() { return argList.size(); }
+    String uri() { return currentUri; }
+    HTTPMethod method() { return currentMethod; }
+    String header(const char* name) { (void) name; return String(); }
+
+    void send(int code, const char* contentType = NULL, const String& content = String());
+    void send(int code, const String& contentType, const String& content) { send(code, contentType.c_str(), content); }
+    void send_P(int code, const char* contentType, const char* content) { send(code, contentType, String(content)); }
+    void setContentLength(size_t length) { contentLength = length; }
+    void sendHeader(const String& name, const String& value, bool first = false);
+    void sendContent(const String& content);
+    void sendContent(const char* content, size_t length) { sendContent(String(std::string(content, length))); }
+    void sendContent_P(const char* content) { sendContent(String(content)); }
+    WiFiClient client() { return WiFiClient(&connections.back()); }
+    HTTPUpload& upload() { return currentUpload; }
+
+    // Test side. Runs the handler for this request and returns the status
+    // code, or 404 if nothing handles it.
+    int request(HTTPMethod method, const String& uri, const std::vector<std::pair<String, String> >& args = std::vector<std::pair<String, String> >());
+
+    // Same, with a body sent as a file upload in bufferSize chunks
+    int upload(const String& uri, const std::string& body, size_t bufferSize = HTTP_UPLOAD_BUFLEN);
+
+    // Queue a request for the next handleClient() to pick up
+    void queue(HTTPMethod method, const String& uri, const std::vector<std::pair<String, String> >& args = std::vector<std::pair<String, String> >());
+    size_t queued() const { return pending.size(); }
+
+    int responseCode;
+    String responseType;
+    std::string responseBody;
+    std::vector<std::pair<String, String> > responseHeaders;
+    // One per request, kept so clients the firmware holds on to stay valid
+    std::deque<HostConnection> connections;
+    uint32_t handled;
+    bool started;
+
+  private:
+    struct Route {
+      std::string uri;
+      HTTPMethod method;
+      THandlerFunction handler;
+      THandlerFunction uploadHandler;
+    };
+    struct Pending {
+      HTTPMethod method;
+      String uri;
+      std::vector<std::pair<String, String> > args;
+    };
+
+    const Route* find(HTTPMethod method, const String& uri) const;
+    void reset(HTTPMethod method, const String& uri);
+
+    std::vector<Route> routes;
+    std::vector<Pending> pending;
+    THandlerFunction notFoundHandler;
+    std::vector<std::pair<String, String> > argList;
+    String currentUri;
+    HTTPMethod currentMethod;
+    HTTPUpload currentUpload;
+    size_t contentLength;
+};
+
+#endif
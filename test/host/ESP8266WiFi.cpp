@@ -0,0 +1,136 @@
+#include "ESP8266WiFi.h"
+
+WiFiClass WiFi;
+EspClass ESP;
+
+String IPAddress::toString() const {
+  char buf[16];
+  snprintf(buf, sizeof(buf), "%u.%u.%u.%u", octets[0], octets[1], octets[2], octets[3]);
+  return String(buf);
+}
+
+bool IPAddress::fromString(const String& address) {
+  unsigned int a, b, c, d;
+  if (sscanf(address.c_str(), "%u.%u.%u.%u", &a, &b, &c, &d) != 4) return false;
+  if ((a > 255) || (b > 255) || (c > 255) || (d > 255)) return false;
+  octets[0] = a;
+  octets[1] = b;
+  octets[2] = c;
+  octets[3] = d;
+  return true;
+}
+
+// ------------------------------------------------------------------
+// WiFiClient
+// ------------------------------------------------------------------
+uint8_t WiFiClient::connected() {
+  return (conn != NULL) && conn->open;
+}
+
+void WiFiClient::stop() {
+  if (conn != NULL) conn->open = false;
+}
+
+void WiFiClient::setNoDelay(bool noDelay) {
+  if (conn != NULL) conn->noDelay = noDelay;
+}
+
+size_t WiFiClient::write(uint8_t c) {
+  if (!connected()) return 0;
+  conn->sent += (char) c;
+  return 1;
+}
+
+size_t WiFiClient::write(const uint8_t* buf, size_t len) {
+  if (!connected()) return 0;
+  conn->sent.append((const char*) buf, len);
+  return len;
+}
+
+// ------------------------------------------------------------------
+// WiFi
+// ------------------------------------------------------------------
+WiFiClass::WiFiClass() {
+  hostConnectMicros = 3000000;
+  hostScanMicros = 2000000;
+  beginCount = 0;
+  wifiMode = WIFI_STA;
+  connecting = false;
+  joined = false;
+  connectStartedMicros = 0;
+  scanState = WIFI_SCAN_FAILED;
+  scanStartedMicros = 0;
+  sleepMode = WIFI_NONE_SLEEP;
+}
+
+int WiFiClass::status() {
+  if (joined) return WL_CONNECTED;
+  if (!connecting) return WL_DISCONNECTED;
+  if ((hostMicros - connectStartedMicros) < hostConnectMicros) return WL_DISCONNECTED;
+
+  // Long enough: either we get on, or the ESP8266 goes on retrying quietly
+  for (size_t i = 0 ; i < hostNetworks.size() ; i++) {
+    if ((hostNetworks[i].ssid == lastBeginSSID) && (hostNetworks[i].password == lastBeginPassword)) {
+      joined = true;
+      connecting = false;
+      joinedSSID = lastBeginSSID;
+      return WL_CONNECTED;
+    }
+  }
+  return WL_DISCONNECTED;
+}
+
+bool WiFiClass::mode(int m) {
+  wifiMode = m;
+  if ((m == WIFI_STA) || (m == WIFI_OFF)) apSSID = "";
+  return true;
+}
+
+bool WiFiClass::softAP(const char* ssid, const char* password) {
+  (void) password;
+  if ((wifiMode & WIFI_AP) == 0) return false;
+  apSSID = ssid;
+  return true;
+}
+
+int WiFiClass::begin(const char* ssid, const char* password) {
+  lastBeginSSID = ssid ? ssid : "";
+  lastBeginPassword = password ? password : "";
+  joined = false;
+  joinedSSID = "";
+  connecting = true;
+  connectStartedMicros = hostMicros;
+  beginCount++;
+  return WL_DISCONNECTED;
+}
+
+bool WiFiClass::disconnect(bool wifiOff) {
+  joined = false;
+  connecting = false;
+  joinedSSID = "";
+  if (wifiOff) wifiMode = WIFI_OFF;
+  return true;
+}
+
+int WiFiClass::scanNetworks(bool async) {
+  scanState = WIFI_SCAN_RUNNING;
+  scanStartedMicros = hostMicros;
+  if (!async) {
+    hostAdvanceMicros(hostScanMicros);
+    return scanComplete();
+  }
+  return WIFI_SCAN_RUNNING;
+}
+
+int WiFiClass::scanComplete() {
+  if ((scanState == WIFI_SCAN_RUNNING) && ((hostMicros - scanStartedMicros) >= hostScanMicros)) {
+    scanState = hostNetworks.size();
+  }
+  return scanState;
+}
+
+bool WiFiClass::setSleepMode(WiFiSleepType_t type, uint8_t listenInterval) {
+  (void) listenInterval;
+  sleepMode = type;
+  return true;
+}
@@ -0,0 +1,142 @@
+// Host ESP8266WiFi. The radio is a little state machine the tests drive:
+// begin() only connects if the credentials match the network the test says
+// is in range, and then only after hostWiFiConnectMicros of virtual time.
+#ifndef ESP8266WiFi_h
+#define ESP8266WiFi_h
+
+#include <string>
+#include <vector>
+
+#include "Arduino.h"
+#include "IPAddress.h"
+
+#define WL_IDLE_STATUS     0
+#define WL_NO_SSID_AVAIL   1
+#define WL_SCAN_COMPLETED  2
+#define WL_CONNECTED       3
+#define WL_CONNECT_FAILED  4
+#define WL_CONNECTION_LOST 5
+#define WL_DISCONNECTED    6
+
+#define WIFI_OFF    0
+#define WIFI_STA    1
+#define WIFI_AP     2
+#define WIFI_AP_STA 3
+
+#define ENC_TYPE_WEP  5
+#define ENC_TYPE_TKIP 2
+#define ENC_TYPE_CCMP 4
+#define ENC_TYPE_NONE 7
+#define ENC_TYPE_AUTO 8
+
+#define WIFI_SCAN_RUNNING (-1)
+#define WIFI_SCAN_FAILED  (-2)
+
+enum WiFiSleepType_t { WIFI_NONE_SLEEP = 0, WIFI_LIGHT_SLEEP = 1, WIFI_MODEM_SLEEP = 2 };
+
+// One end of a TCP connection. The test owns it; WiFiClient copies all point
+// at the same one, as they share the socket on the ESP8266.
+struct HostConnection {
+  HostConnection() : open(true), noDelay(false) {}
+  bool open;
+  bool noDelay;
+  std::string sent;
+};
+
+class WiFiClient : public Print {
+  public:
+    WiFiClient() : conn(NULL) {}
+    explicit WiFiClient(HostConnection* connection) : conn(connection) {}
+
+    uint8_t connected();
+    void stop();
+    void setNoDelay(bool noDelay);
+    void setSync(bool) {}
+    int available() { return 0; }
+    int read() { return -1; }
+    operator bool() { return connected(); }
+    IPAddress remoteIP() { return IPAddress(192, 168, 4, 2); }
+    uint16_t remotePort() { return 50000; }
+    size_t write(uint8_t c);
+    size_t write(const uint8_t* buf, size_t len);
+    using Print::write;
+
+    HostConnection* connection() const { return conn; }
+
+  private:
+    HostConnection* conn;
+};
+
+class WiFiClass {
+  public:
+    WiFiClass();
+
+    int status();
+    bool mode(int m);
+    int getMode() { return wifiMode; }
+    bool softAP(const char* ssid, const char* password = NULL);
+    IPAddress softAPIP() { return IPAddress(192, 168, 4, 1); }
+    IPAddress localIP() { return (status() == WL_CONNECTED) ? IPAddress(192, 168, 1, 50) : IPAddress(); }
+    String macAddress() { return "5C:CF:7F:00:00:01"; }
+    String softAPmacAddress() { return "5E:CF:7F:00:00:01"; }
+    String SSID() { return (status() == WL_CONNECTED) ? String(joinedSSID) : String(); }
+    String SSID(int i) { return ((i >= 0) && (i < (int) hostNetworks.size())) ? String(hostNetworks[i].ssid) : String(); }
+    int32_t RSSI(int i) { return ((i >= 0) && (i < (int) hostNetworks.size())) ? hostNetworks[i].rssi : 0; }
+    uint8_t encryptionType(int i) { return ((i >= 0) && (i < (int) hostNetworks.size()) && !hostNetworks[i].password.empty()) ? ENC_TYPE_CCMP : ENC_TYPE_NONE; }
+    int scanNetworks(bool async = false);
+    int scanComplete();
+    void scanDelete() { scanState = WIFI_SCAN_FAILED; }
+    int begin(const char* ssid, const char* password = NULL);
+    bool disconnect(bool wifiOff = false);
+    bool setSleepMode(WiFiSleepType_t type, uint8_t listenInterval = 0);
+    WiFiSleepType_t getSleepMode() { return sleepMode; }
+    bool isConnecting() const { return connecting; }
+
+    // Test side: the networks in range, and how long joining one takes
+    struct HostNetwork {
+      std::string ssid;
+      std::string password;
+      int32_t rssi;
+    };
+    std::vector<HostNetwork> hostNetworks;
+    uint32_t hostConnectMicros;
+    uint32_t hostScanMicros;
+
+    // What the firmware did
+    std::string joinedSSID;
+    std::string lastBeginSSID;
+    std::string lastBeginPassword;
+    std::string apSSID;
+    uint32_t beginCount;
+
+  private:
+    int wifiMode;
+    bool connecting;
+    bool joined;
+    uint64_t connectStartedMicros;
+    int scanState;
+    uint64_t scanStartedMicros;
+    WiFiSleepType_t sleepMode;
+};
+
+extern WiFiClass WiFi;
+
+class EspClass {
+  public:
+    uint32_t getChipId() { return 0x00abcdef; }
+    uint32_t getSketchSize() { return 400000; }
+    uint32_t getFreeSketchSpace() { return 600000; }
+    uint32_t getFreeHeap() { return 30000; }
+    uint8_t getBootVersion() { return 6; }
+    uint8_t getCpuFreqMHz() { return 80; }
+    const char* getSdkVersion() { return "host"; }
+    uint32_t getFlashChipId() { return 0x1640ef; }
+    uint32_t getFlashChipRealSize() { return 4194304; }
+    uint16_t getVcc() { return 3300; }
+    uint32_t getCycleCount() { return (uint32_t) (hostMicros * 80); }
+    void restart() {}
+};
+
+extern EspClass ESP;
+
+#endif
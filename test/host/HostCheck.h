@@ -0,0 +1,29 @@
+// Checks for the host tests: each failure is printed with where it came
+// from, and hostCheckExit() turns the count into the exit code.
+#ifndef HostCheck_h
+#define HostCheck_h
+
+#include <stdio.h>
+
+static int hostCheckFailures = 0;
+
+#define CHECK(cond, ...) \
+  do { \
+    if (!(cond)) { \
+      printf("  FAIL %s:%d: %s: ", __FILE__, __LINE__, #cond); \
+      printf(__VA_ARGS__); \
+      printf("\n"); \
+      hostCheckFailures++; \
+    } \
+  } while (0)
+
+static inline int hostCheckExit(const char* suite) {
+  if (hostCheckFailures > 0) {
+    printf("%s: %d check(s) failed\n", suite, hostCheckFailures);
+    return 1;
+  }
+  printf("%s: ok\n", suite);
+  return 0;
+}
+
+#endif
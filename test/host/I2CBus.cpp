@@ -0,0 +1,144 @@
+#include <string.h>
+
+#include "Arduino.h"
+#include "I2CBus.h"
+
+I2CBus hostI2CBus;
+
+I2CBus::I2CBus() {
+  memset(devices, 0, sizeof(devices));
+  memset(extraStretch, 0, sizeof(extraStretch));
+  clockHz = 100000;
+  maxClockHz = 0;
+  deviceHook = NULL;
+  stretchLimitMicros = 0;
+  failCount = 0;
+  failResult = I2C_RESULT_OK;
+  errorRate = 0.0;
+  errorState = 1;
+  resetStats();
+}
+
+void I2CBus::attach(uint8_t address, I2CDevice* device) {
+  devices[address & 0x7f] = device;
+}
+
+void I2CBus::detach(uint8_t address) {
+  devices[address & 0x7f] = NULL;
+}
+
+void I2CBus::failNext(uint32_t count, uint8_t result) {
+  failCount = count;
+  failResult = result;
+}
+
+void I2CBus::setErrorRate(double rate, uint32_t seed) {
+  errorRate = rate;
+  errorState = seed ? seed : 1;
+}
+
+void I2CBus::resetStats() {
+  memset(stats, 0, sizeof(stats));
+  memset(&totals, 0, sizeof(totals));
+}
+
+// Start, address byte, the data bytes, each with its ACK bit, and stop
+uint32_t I2CBus::transferMicros(size_t bytes) const {
+  uint64_t bits = (1 + bytes) * 9 + 2;
+  return (uint32_t) ((bits * 1000000ULL + clockHz - 1) / clockHz);
+}
+
+bool I2CBus::injectFault(uint8_t& result) {
+  if (failCount > 0) {
+    failCount--;
+    result = failResult;
+    return true;
+  }
+  if (errorRate > 0.0) {
+    // xorshift32, so a seed always gives the same faults
+    errorState ^= errorState << 13;
+    errorState ^= errorState >> 17;
+    errorState ^= errorState << 5;
+    if ((errorState / 4294967296.0) < errorRate) {
+      result = I2C_RESULT_OTHER;
+      return true;
+    }
+  }
+  return false;
+}
+
+void I2CBus::account(uint8_t address, size_t bytes, uint32_t micros, uint32_t service, bool error) {
+  I2CStats* targets[2] = { &stats[address & 0x7f], &totals };
+  for (int i = 0 ; i < 2 ; i++) {
+    targets[i]->transactions++;
+    targets[i]->bytes += bytes;
+    targets[i]->busyMicros += micros;
+    targets[i]->serviceMicros += service;
+    if (service > targets[i]->maxServiceMicros) targets[i]->maxServiceMicros = service;
+    if (error) targets[i]->errors++;
+  }
+  hostAdvanceMicros(micros);
+}
+
+bool I2CBus::deviceWrite(uint8_t address, I2CDevice* device, const uint8_t* data, size_t len) {
+  if (deviceHook) deviceHook(address, true);
+  bool acked = device->i2cWrite(data, len);
+  if (deviceHook) deviceHook(address, false);
+  return acked;
+}
+
+size_t I2CBus::deviceRead(uint8_t address, I2CDevice* device, uint8_t* data, size_t len) {
+  if (deviceHook) deviceHook(address, true);
+  size_t n = device->i2cRead(data, len);
+  if (deviceHook) deviceHook(address, false);
+  return n;
+}
+
+uint8_t I2CBus::write(uint8_t address, const uint8_t* data, size_t len) {
+  I2CDevice* device = devices[address & 0x7f];
+  uint8_t result = I2C_RESULT_OK;
+
+  if (injectFault(result)) {
+    account(address, 0, transferMicros(0), 0, true);
+    return result;
+  }
+
+  if (device == NULL) {
+    account(address, 0, transferMicros(0), 0, true);
+    return I2C_RESULT_ADDRESS_NACK;
+  }
+
+  uint32_t stretch = device->stretchMicros(len) + extraStretch[address & 0x7f];
+  if ((stretchLimitMicros > 0) && (stretch > stretchLimitMicros)) {
+    account(address, len, transferMicros(len) + stretchLimitMicros, device->serviceMicros(len), true);
+    return I2C_RESULT_TIMEOUT;
+  }
+
+  bool acked = deviceWrite(address, device, data, len);
+  account(address, len, transferMicros(len) + stretch, device->serviceMicros(len), !acked);
+  return acked ? I2C_RESULT_OK : I2C_RESULT_DATA_NACK;
+}
+
+size_t I2CBus::read(uint8_t address, uint8_t* data, size_t len) {
+  I2CDevice* device = devices[address & 0x7f];
+  uint8_t result = I2C_RESULT_OK;
+
+  memset(data, 0xff, len);
+
+  if ((device == NULL) || injectFault(result)) {
+    account(address, 0, transferMicros(0), 0, true);
+    return 0;
+  }
+
+  uint32_t stretch = device->stretchMicros(len) + extraStretch[address & 0x7f];
+  if ((stretchLimitMicros > 0) && (stretch > stretchLimitMicros)) {
+    account(address, 0, transferMicros(0) + stretchLimitMicros, device->serviceMicros(len), true);
+    return 0;
+  }
+
+  // The master clocks out all the bytes it asked for whatever the device
+  // has, so count the full length on the wire
+  deviceRead(address, device, data, len);
+  account(address, len, transferMicros(len) + stretch, device->serviceMicros(len), false);
+  return len;
+}
@@ -0,0 +1,119 @@
+// A virtual I2C bus shared by everything in a host test.
+//
+// Masters (TwoWire in master mode) start transactions, devices (the DS3231
+// model, TwoWire in slave mode) answer them. Each transaction takes the time
+// its bits would take at the configured clock, plus any clock stretching the
+// device asks for, and virtual time moves on by that much. The bus counts
+// what went over it so the tests can report occupancy.
+#ifndef I2CBus_h
+#define I2CBus_h
+
+#include <stdint.h>
+#include <stddef.h>
+
+// endTransmission() results, as the Arduino Wire libraries report them
+#define I2C_RESULT_OK            0
+#define I2C_RESULT_TOO_LONG      1
+#define I2C_RESULT_ADDRESS_NACK  2
+#define I2C_RESULT_DATA_NACK     3
+#define I2C_RESULT_OTHER         4
+#define I2C_RESULT_TIMEOUT       5
+
+#define I2C_ADDRESS_COUNT        128
+
+class I2CDevice {
+  public:
+    virtual ~I2CDevice() {}
+
+    // The master wrote len bytes (len may be 0 for a probe). Return false to
+    // NACK.
+    virtual bool i2cWrite(const uint8_t* data, size_t len) = 0;
+
+    // The master wants len bytes. Fill what you have and return how many.
+    virtual size_t i2cRead(uint8_t* data, size_t len) = 0;
+
+    // How long the device holds SCL low over a transaction of this many
+    // bytes
+    virtual uint32_t stretchMicros(size_t bytes) { (void) bytes; return 0; }
+
+    // How long servicing the transaction keeps the device's own CPU away from
+    // whatever it was doing
+    virtual uint32_t serviceMicros(size_t bytes) { (void) bytes; return 0; }
+};
+
+struct I2CStats {
+  uint32_t transactions;
+  uint32_t bytes;
+  uint32_t errors;
+  uint64_t busyMicros;
+  uint64_t serviceMicros;
+  uint32_t maxServiceMicros;
+};
+
+class I2CBus {
+  public:
+    I2CBus();
+
+    void attach(uint8_t address, I2CDevice* device);
+    void detach(uint8_t address);
+    I2CDevice* deviceAt(uint8_t address) const { return devices[address & 0x7f]; }
+
+    // Master side, returns one of the I2C_RESULT_* codes
+    uint8_t write(uint8_t address, const uint8_t* data, size_t len);
+
+    // Master side, returns how many bytes the device supplied, 0 on a NACK.
+    // Bytes the device did not supply read as 0xFF, as an idle bus would.
+    size_t read(uint8_t address, uint8_t* data, size_t len);
+
+    // Masters ask for a speed, the wiring may not manage it
+    void setClock(uint32_t hz) { clockHz = ((maxClockHz > 0) && (hz > maxClockHz)) ? maxClockHz : hz; }
+    uint32_t getClock() const { return clockHz; }
+    void setMaxClock(uint32_t hz) { maxClockHz = hz; setClock(clockHz); }
+
+    // Extra clock stretching by the device at this address, per transaction
+    void setStretch(uint8_t address, uint32_t us) { extraStretch[address & 0x7f] = us; }
+
+    // The ESP8266 gives up on a slave that stretches for longer than this,
+    // 0 means wait for ever
+    void setStretchLimit(uint32_t us) { stretchLimitMicros = us; }
+
+    // Called around every call into a device, so a co-simulation can run
+    // the device's code on its own processor's time
+    void setDeviceHook(void (*hook)(uint8_t address, bool entering)) { deviceHook = hook; }
+
+    // Fail the next count transactions with this result
+    void failNext(uint32_t count, uint8_t result);
+
+    // Fail each transaction with this probability, repeatably for a seed
+    void setErrorRate(double rate, uint32_t seed);
+
+    void resetStats();
+    const I2CStats& total() const { return totals; }
+    const I2CStats& at(uint8_t address) const { return stats[address & 0x7f]; }
+
+    // How long a transaction of this many bytes takes on the wire
+    uint32_t transferMicros(size_t bytes) const;
+
+  private:
+    bool injectFault(uint8_t& result);
+    bool deviceWrite(uint8_t address, I2CDevice* device, const uint8_t* data, size_t len);
+    size_t deviceRead(uint8_t address, I2CDevice* device, uint8_t* data, size_t len);
+    void account(uint8_t address, size_t bytes, uint32_t micros, uint32_t service, bool error);
+
+    I2CDevice* devices[I2C_ADDRESS_COUNT];
+    I2CStats stats[I2C_ADDRESS_COUNT];
+    I2CStats totals;
+    uint32_t extraStretch[I2C_ADDRESS_COUNT];
+    void (*deviceHook)(uint8_t address, bool entering);
+    uint32_t clockHz;
+    uint32_t maxClockHz;
+    uint32_t stretchLimitMicros;
+    uint32_t failCount;
+    uint8_t failResult;
+    double errorRate;
+    uint32_t errorState;
+};
+
+extern I2CBus hostI2CBus;
+
+#endif
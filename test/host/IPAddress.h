@@ -0,0 +1,20 @@
+#ifndef IPAddress_h
+#define IPAddress_h
+
+#include "Arduino.h"
+
+class IPAddress {
+  public:
+    IPAddress() { octets[0] = octets[1] = octets[2] = octets[3] = 0; }
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) { octets[0] = a; octets[1] = b; octets[2] = c; octets[3] = d; }
+    uint8_t operator[](int i) const { return octets[i & 3]; }
+    uint8_t& operator[](int i) { return octets[i & 3]; }
+    operator uint32_t() const { return octets[0] | (octets[1] << 8) | (octets[2] << 16) | ((uint32_t) octets[3] << 24); }
+    String toString() const;
+    bool fromString(const String& address);
+
+  private:
+    uint8_t octets[4];
+};
+
+#endif
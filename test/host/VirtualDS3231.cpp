@@ -0,0 +1,374 @@
+#include <math.h>
+#include <string.h>
+
+#include "Arduino.h"
+#include "VirtualDS3231.h"
+
+#define SECS_PER_DAY_64   86400LL
+#define UNIX_2000         946684800LL
+#define DAYS_1970_TO_2000 10957LL
+
+// ------------------------------------------------------------------
+// Calendar, kept apart from the Time library that is under test
+// ------------------------------------------------------------------
+static int64_t floorDiv(int64_t a, int64_t b) {
+  return (a >= 0) ? (a / b) : -((-a + b - 1) / b);
+}
+
+// Days since 1 Jan 1970 for a proleptic Gregorian date
+static int64_t daysFromCivil(int64_t y, int m, int d) {
+  y -= (m <= 2);
+  int64_t era = floorDiv(y, 400);
+  int64_t yoe = y - era * 400;
+  int64_t doy = (153 * (m + ((m > 2) ? -3 : 9)) + 2) / 5 + d - 1;
+  int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return era * 146097 + doe - 719468;
+}
+
+static void civilFromDays(int64_t z, int64_t& y, int& m, int& d) {
+  z += 719468;
+  int64_t era = floorDiv(z, 146097);
+  int64_t doe = z - era * 146097;
+  int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  int64_t mp = (5 * doy + 2) / 153;
+  d = (int) (doy - (153 * mp + 2) / 5 + 1);
+  m = (int) ((mp < 10) ? mp + 3 : mp - 9);
+  y = yoe + era * 400 + (m <= 2);
+}
+
+static uint8_t toBcd(int v) {
+  return (uint8_t) (((v / 10) << 4) | (v % 10));
+}
+
+static int fromBcd(uint8_t v) {
+  return (v >> 4) * 10 + (v & 0x0f);
+}
+
+// An hour register, or the hour of an alarm register, in 24h
+static int decodeHour(uint8_t v) {
+  if (v & 0x40) {
+    int h = fromBcd(v & 0x1f) % 12;
+    return (v & 0x20) ? h + 12 : h;
+  }
+  return fromBcd(v & 0x3f);
+}
+
+// ------------------------------------------------------------------
+// Chip
+// ------------------------------------------------------------------
+VirtualDS3231::VirtualDS3231() {
+  memset(regs, 0, sizeof(regs));
+  regs[DS3231_REG_CONTROL] = DS3231_CTL_INTCN | DS3231_CTL_RS;
+  regs[DS3231_REG_STATUS] = DS3231_STAT_OSF | DS3231_STAT_EN32KHZ;
+  pointer = 0;
+  reads = 0;
+  writes = 0;
+  conversions = 0;
+
+  seconds = 0;
+  phase = 0.0;
+  dayOfWeek = 1;
+  mode12h = false;
+
+  driftPpm = 0.0;
+  tempCoeffPpm = 0.0;
+  turnoverC_ = 25.0;
+  tempMeanC = 25.0;
+  tempSwingC = 0.0;
+  tempPeriodSecs = 86400;
+  lastTempC = 25.0;
+  currentPpm = 0.0;
+
+  vcc = true;
+  batteryFlat = false;
+  running = true;
+
+  // The chip does a conversion as soon as it has power
+  syncedMicros = hostMicros;
+  nextConversionMicros = syncedMicros + DS3231_CONVERSION_SECS * 1000000ULL;
+  converting = false;
+  finishConversion();
+}
+
+void VirtualDS3231::setTemperatureCycle(double meanC, double swingC, uint32_t periodSecs) {
+  sync();
+  tempMeanC = meanC;
+  tempSwingC = swingC;
+  tempPeriodSecs = periodSecs ? periodSecs : 1;
+}
+
+double VirtualDS3231::temperatureAt(uint64_t micros) const {
+  if (tempSwingC == 0.0) return tempMeanC;
+  double cycles = (micros / 1000000.0) / tempPeriodSecs;
+  return tempMeanC + tempSwingC * sin(2.0 * M_PI * cycles);
+}
+
+void VirtualDS3231::updatePpm() {
+  double dt = lastTempC - turnoverC_;
+  currentPpm = driftPpm + tempCoeffPpm * dt * dt - DS3231_AGING_PPM_PER_STEP * (int8_t) regs[DS3231_REG_AGING];
+}
+
+void VirtualDS3231::updateOscillator() {
+  bool powered = vcc || !batteryFlat;
+  bool run = powered && (vcc || !(regs[DS3231_REG_CONTROL] & DS3231_CTL_EOSC));
+  if (running && !run) regs[DS3231_REG_STATUS] |= DS3231_STAT_OSF;
+  running = run;
+}
+
+// Bring the chip up to the current virtual time, one conversion at a time,
+// as the oscillator's rate only changes on a conversion
+void VirtualDS3231::sync() {
+  uint64_t now = hostMicros;
+  while (syncedMicros < now) {
+    uint64_t until = now;
+    if (nextConversionMicros < until) until = nextConversionMicros;
+    if (converting && (conversionDoneMicros < until)) until = conversionDoneMicros;
+
+    advanceChip(until - syncedMicros);
+    syncedMicros = until;
+
+    if (converting && (syncedMicros == conversionDoneMicros)) finishConversion();
+    if (syncedMicros == nextConversionMicros) {
+      nextConversionMicros += DS3231_CONVERSION_SECS * 1000000ULL;
+      if (!converting) startConversion();
+    }
+  }
+}
+
+void VirtualDS3231::advanceChip(uint64_t micros) {
+  if (!running) return;
+  phase += micros * 1e-6 * (1.0 + currentPpm * 1e-6);
+  double whole = floor(phase);
+  phase -= whole;
+  tickSeconds((uint64_t) whole);
+}
+
+void VirtualDS3231::tickSeconds(uint64_t n) {
+  uint8_t bothFlags = DS3231_STAT_A1F | DS3231_STAT_A2F;
+  if ((regs[DS3231_REG_STATUS] & bothFlags) == bothFlags) {
+    // Nothing left for the alarms to do, skip straight there
+    int64_t days = floorDiv(seconds + n, SECS_PER_DAY_64) - floorDiv(seconds, SECS_PER_DAY_64);
+    seconds += n;
+    dayOfWeek = (uint8_t) ((dayOfWeek - 1 + days) % 7 + 1);
+    return;
+  }
+
+  while (n-- > 0) {
+    seconds++;
+    if (floorDiv(seconds, SECS_PER_DAY_64) * SECS_PER_DAY_64 == seconds) {
+      dayOfWeek = (dayOfWeek % 7) + 1;
+    }
+    checkAlarms();
+  }
+}
+
+void VirtualDS3231::checkAlarms() {
+  int64_t days = floorDiv(seconds, SECS_PER_DAY_64);
+  int64_t sod = seconds - days * SECS_PER_DAY_64;
+  int64_t y;
+  int m, date;
+  civilFromDays(days + DAYS_1970_TO_2000, y, m, date);
+  int h = (int) (sod / 3600);
+  int mi = (int) ((sod / 60) % 60);
+  int s = (int) (sod % 60);
+
+  const uint8_t* a1 = &regs[DS3231_REG_A1_SECONDS];
+  int a1Day = fromBcd(a1[3] & 0x3f);
+  bool a1Match = ((a1[0] & 0x80) || (fromBcd(a1[0] & 0x7f) == s)) &&
+                 ((a1[1] & 0x80) || (fromBcd(a1[1] & 0x7f) == mi)) &&
+                 ((a1[2] & 0x80) || (decodeHour(a1[2] & 0x7f) == h)) &&
+                 ((a1[3] & 0x80) || (a1Day == ((a1[3] & 0x40) ? dayOfWeek : date)));
+  if (a1Match) regs[DS3231_REG_STATUS] |= DS3231_STAT_A1F;
+
+  // Alarm 2 has no seconds, it goes off at the top of the minute
+  const uint8_t* a2 = &regs[DS3231_REG_A2_MINUTES];
+  int a2Day = fromBcd(a2[2] & 0x3f);
+  bool a2Match = (s == 0) &&
+                 ((a2[0] & 0x80) || (fromBcd(a2[0] & 0x7f) == mi)) &&
+                 ((a2[1] & 0x80) || (decodeHour(a2[1] & 0x7f) == h)) &&
+                 ((a2[2] & 0x80) || (a2Day == ((a2[2] & 0x40) ? dayOfWeek : date)));
+  if (a2Match) regs[DS3231_REG_STATUS] |= DS3231_STAT_A2F;
+}
+
+void VirtualDS3231::startConversion() {
+  converting = true;
+  conversionDoneMicros = syncedMicros + DS3231_CONVERSION_MICROS;
+  regs[DS3231_REG_STATUS] |= DS3231_STAT_BSY;
+}
+
+// Read the temperature and retune the oscillator for it and the aging
+// offset
+void VirtualDS3231::finishConversion() {
+  lastTempC = temperatureAt(syncedMicros);
+  int t4 = (int) floor(lastTempC * 4.0);
+  regs[DS3231_REG_TEMP_MSB] = (uint8_t) (t4 >> 2);
+  regs[DS3231_REG_TEMP_LSB] = (uint8_t) ((t4 & 3) << 6);
+  updatePpm();
+
+  regs[DS3231_REG_CONTROL] &= ~DS3231_CTL_CONV;
+  regs[DS3231_REG_STATUS] &= ~DS3231_STAT_BSY;
+  converting = false;
+  conversions++;
+}
+
+void VirtualDS3231::buildTimeRegisters(uint8_t* out) const {
+  int64_t days = floorDiv(seconds, SECS_PER_DAY_64);
+  int64_t sod = seconds - days * SECS_PER_DAY_64;
+  int64_t y;
+  int m, d;
+  civilFromDays(days + DAYS_1970_TO_2000, y, m, d);
+  int h = (int) (sod / 3600);
+  int yy = (int) (y - 2000);
+
+  out[0] = toBcd((int) (sod % 60));
+  out[1] = toBcd((int) ((sod / 60) % 60));
+  if (mode12h) {
+    int h12 = (h % 12 == 0) ? 12 : h % 12;
+    out[2] = 0x40 | ((h >= 12) ? 0x20 : 0) | toBcd(h12);
+  } else {
+    out[2] = toBcd(h);
+  }
+  out[3] = dayOfWeek;
+  out[4] = toBcd(d);
+  out[5] = toBcd(m) | ((yy >= 100) ? 0x80 : 0);
+  out[6] = toBcd(yy % 100);
+}
+
+// Nonsense dates (the 42nd of July) roll on into the next month rather than
+// doing whatever the chip would do with them
+void VirtualDS3231::loadTimeRegisters(const uint8_t* in) {
+  int s = fromBcd(in[0] & 0x7f);
+  int mi = fromBcd(in[1] & 0x7f);
+  int h = decodeHour(in[2]);
+  int d = fromBcd(in[4] & 0x3f);
+  int m = fromBcd(in[5] & 0x1f);
+  int64_t y = 2000 + fromBcd(in[6]) + ((in[5] & 0x80) ? 100 : 0);
+  if (m < 1) m = 1;
+  if (m > 12) m = 12;
+
+  mode12h = (in[2] & 0x40) != 0;
+  dayOfWeek = in[3] & 0x07;
+  seconds = (daysFromCivil(y, m, d) - DAYS_1970_TO_2000) * SECS_PER_DAY_64 + h * 3600 + mi * 60 + s;
+}
+
+void VirtualDS3231::writeRegister(uint8_t address, uint8_t value, uint8_t* timeImage, bool& timeWritten, bool& secondsWritten) {
+  if (address <= DS3231_REG_YEAR) {
+    timeImage[address] = value;
+    timeWritten = true;
+    if (address == DS3231_REG_SECONDS) secondsWritten = true;
+    return;
+  }
+
+  switch (address) {
+    case DS3231_REG_CONTROL:
+      regs[address] = value;
+      if ((value & DS3231_CTL_CONV) && !converting) {
+        startConversion();
+      }
+      updateOscillator();
+      break;
+    case DS3231_REG_STATUS: {
+      // OSF and the alarm flags can only be cleared, BSY is read only
+      uint8_t clearable = DS3231_STAT_OSF | DS3231_STAT_A1F | DS3231_STAT_A2F;
+      uint8_t old = regs[address];
+      regs[address] = (old & clearable & value) | (value & DS3231_STAT_EN32KHZ) | (old & DS3231_STAT_BSY);
+      break;
+    }
+    case DS3231_REG_TEMP_MSB:
+    case DS3231_REG_TEMP_LSB:
+      break;
+    default:
+      // Alarms and aging; the aging offset waits for the next conversion
+      regs[address] = value;
+      break;
+  }
+}
+
+bool VirtualDS3231::i2cWrite(const uint8_t* data, size_t len) {
+  sync();
+  writes++;
+  if (len == 0) return true;
+
+  pointer = (data[0] < DS3231_REG_COUNT) ? data[0] : 0;
+
+  uint8_t timeImage[DS3231_REG_YEAR + 1];
+  buildTimeRegisters(timeImage);
+  bool timeWritten = false;
+  bool secondsWritten = false;
+
+  for (size_t i = 1 ; i < len ; i++) {
+    writeRegister(pointer, data[i], timeImage, timeWritten, secondsWritten);
+    pointer = (pointer + 1) % DS3231_REG_COUNT;
+  }
+
+  if (timeWritten) loadTimeRegisters(timeImage);
+
+  // Writing the seconds resets the countdown chain
+  if (secondsWritten) phase = 0.0;
+  return true;
+}
+
+size_t VirtualDS3231::i2cRead(uint8_t* data, size_t len) {
+  sync();
+  reads++;
+
+  // The time is copied to the read buffers at the START, so a burst read
+  // can't see it roll over
+  uint8_t timeImage[DS3231_REG_YEAR + 1];
+  buildTimeRegisters(timeImage);
+
+  for (size_t i = 0 ; i < len ; i++) {
+    data[i] = (pointer <= DS3231_REG_YEAR) ? timeImage[pointer] : regs[pointer];
+    pointer = (pointer + 1) % DS3231_REG_COUNT;
+  }
+  return len;
+}
+
+uint8_t VirtualDS3231::reg(uint8_t address) {
+  sync();
+  if (address >= DS3231_REG_COUNT) return 0xff;
+  if (address <= DS3231_REG_YEAR) {
+    uint8_t timeImage[DS3231_REG_YEAR + 1];
+    buildTimeRegisters(timeImage);
+    return timeImage[address];
+  }
+  return regs[address];
+}
+
+void VirtualDS3231::setUnixTime(int64_t t) {
+  sync();
+  seconds = t - UNIX_2000;
+  phase = 0.0;
+  // Sunday is 1, as the firmware writes it
+  dayOfWeek = (uint8_t) ((floorDiv(t, SECS_PER_DAY_64) + 4) % 7 + 1);
+}
+
+int64_t VirtualDS3231::unixTime() {
+  sync();
+  return seconds + UNIX_2000;
+}
+
+double VirtualDS3231::unixTimeExact() {
+  sync();
+  return seconds + UNIX_2000 + phase;
+}
+
+bool VirtualDS3231::sqw() {
+  sync();
+  uint8_t control = regs[DS3231_REG_CONTROL];
+  uint8_t status = regs[DS3231_REG_STATUS];
+
+  if (control & DS3231_CTL_INTCN) {
+    bool active = ((status & DS3231_STAT_A1F) && (control & DS3231_CTL_A1IE)) ||
+                  ((status & DS3231_STAT_A2F) && (control & DS3231_CTL_A2IE));
+    return !active;
+  }
+
+  // No square wave on battery unless BBSQW is set, the pin is pulled up
+  if (!running || (!vcc && !(control & DS3231_CTL_BBSQW))) return true;
+
+  static const double rates[4] = {1.0, 1024.0, 4096.0, 8192.0};
+  double cycles = phase * rates[(control & DS3231_CTL_RS) >> 3];
+  return (cycles - floor(cycles)) >= 0.5;
+}
@@ -0,0 +1,154 @@
+// A DS3231 on the virtual I2C bus.
+//
+// The whole register map is there: time and date (24h or 12h, century
+// bit), both alarms with their mask bits, control, status, aging offset and
+// temperature. The register pointer works as on the chip: a write sets it,
+// reads and writes step it on, and it wraps from 0x12 to 0x00. A read sees
+// the time as it was at the start of the transaction.
+//
+// The oscillator runs off virtual time. Its error in ppm is
+//
+//   driftPpm + tempCoeffPpm * (T - turnoverC)^2 - 0.1 * agingOffset
+//
+// where T and the aging offset are the ones the last temperature
+// conversion saw, as on the chip's TCXO. Conversions run every 64 seconds,
+// or when CONV is set, and take 125ms with BSY set. T follows the
+// temperature curve (a mean and a daily swing). The oscillator stop flag is
+// set at power-up and whenever the oscillator stops (flat battery, or EOSC
+// set while on battery), and can only be cleared by writing 0 to it.
+//
+// The INT/SQW pin is available through sqw(): the square wave when INTCN is
+// 0, the active low alarm interrupt when it is 1. At 1Hz the falling edge is
+// when the seconds register changes.
+#ifndef VirtualDS3231_h
+#define VirtualDS3231_h
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "I2CBus.h"
+
+#define DS3231_I2C_ADDRESS           0x68
+
+#define DS3231_REG_SECONDS           0x00
+#define DS3231_REG_MINUTES           0x01
+#define DS3231_REG_HOURS             0x02
+#define DS3231_REG_DAY               0x03
+#define DS3231_REG_DATE              0x04
+#define DS3231_REG_MONTH             0x05
+#define DS3231_REG_YEAR              0x06
+#define DS3231_REG_A1_SECONDS        0x07
+#define DS3231_REG_A2_MINUTES        0x0b
+#define DS3231_REG_CONTROL           0x0e
+#define DS3231_REG_STATUS            0x0f
+#define DS3231_REG_AGING             0x10
+#define DS3231_REG_TEMP_MSB          0x11
+#define DS3231_REG_TEMP_LSB          0x12
+#define DS3231_REG_COUNT             0x13
+
+// Control register
+#define DS3231_CTL_EOSC              0x80
+#define DS3231_CTL_BBSQW             0x40
+#define DS3231_CTL_CONV              0x20
+#define DS3231_CTL_RS                0x18
+#define DS3231_CTL_INTCN             0x04
+#define DS3231_CTL_A2IE              0x02
+#define DS3231_CTL_A1IE              0x01
+
+// Status register
+#define DS3231_STAT_OSF              0x80
+#define DS3231_STAT_EN32KHZ          0x08
+#define DS3231_STAT_BSY              0x04
+#define DS3231_STAT_A2F              0x02
+#define DS3231_STAT_A1F              0x01
+
+#define DS3231_CONVERSION_SECS       64
+#define DS3231_CONVERSION_MICROS     125000UL
+#define DS3231_AGING_PPM_PER_STEP    0.1
+
+class VirtualDS3231 : public I2CDevice {
+  public:
+    // Powered up for the first time: registers at their reset values, OSF
+    // set, 1 Jan 2000
+    VirtualDS3231();
+
+    // I2CDevice
+    bool i2cWrite(const uint8_t* data, size_t len);
+    size_t i2cRead(uint8_t* data, size_t len);
+
+    // Oscillator error, see above
+    void setDrift(double ppm) { sync(); driftPpm = ppm; updatePpm(); }
+    void setTempCoeff(double ppmPerC2, double turnoverC = 25.0) { sync(); tempCoeffPpm = ppmPerC2; turnoverC_ = turnoverC; updatePpm(); }
+
+    // Ambient temperature: a fixed value, or a mean with a sine swing over
+    // the period (a day by default)
+    void setTemperature(double celsius) { setTemperatureCycle(celsius, 0.0); }
+    void setTemperatureCycle(double meanC, double swingC, uint32_t periodSecs = 86400);
+    double temperatureAt(uint64_t micros) const;
+
+    // Power: without Vcc the chip runs off the battery, where EOSC stops
+    // the oscillator. A flat battery stops it too.
+    void setVcc(bool on) { sync(); vcc = on; updateOscillator(); }
+    void setBatteryFlat(bool flat) { sync(); batteryFlat = flat; updateOscillator(); }
+
+    // Test side view of the time, in seconds since 1 Jan 1970
+    void setUnixTime(int64_t t);
+    int64_t unixTime();
+    double unixTimeExact();
+
+    // The current error of the oscillator, as of the last conversion
+    double ppm() { sync(); return currentPpm; }
+
+    // Level of the INT/SQW pin now
+    bool sqw();
+
+    // Registers as they are now, without a bus transaction
+    uint8_t reg(uint8_t address);
+
+    uint32_t reads;
+    uint32_t writes;
+    uint32_t conversions;
+
+  private:
+    void sync();
+    void advanceChip(uint64_t micros);
+    void tickSeconds(uint64_t n);
+    void checkAlarms();
+    void startConversion();
+    void finishConversion();
+    void updateOscillator();
+    void updatePpm();
+    void buildTimeRegisters(uint8_t* out) const;
+    void loadTimeRegisters(const uint8_t* in);
+    void writeRegister(uint8_t address, uint8_t value, uint8_t* timeImage, bool& timeWritten, bool& secondsWritten);
+
+    uint8_t regs[DS3231_REG_COUNT];
+    uint8_t pointer;
+
+    // Time since 1 Jan 2000 and how far through the current second the
+    // countdown chain is
+    int64_t seconds;
+    double phase;
+    uint8_t dayOfWeek;
+    bool mode12h;
+
+    uint64_t syncedMicros;
+    uint64_t nextConversionMicros;
+    uint64_t conversionDoneMicros;
+    bool converting;
+
+    double driftPpm;
+    double tempCoeffPpm;
+    double turnoverC_;
+    double tempMeanC;
+    double tempSwingC;
+    uint32_t tempPeriodSecs;
+    double lastTempC;
+    double currentPpm;
+
+    bool vcc;
+    bool batteryFlat;
+    bool running;
+};
+
+#endif
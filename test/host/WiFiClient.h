@@ -0,0 +1 @@
+#include "ESP8266WiFi.h"
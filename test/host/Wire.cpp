@@ -0,0 +1,138 @@
+#include <string.h>
+
+#include "Arduino.h"
+#include "Wire.h"
+
+TwoWire::TwoWire(size_t bufferLength) {
+  this->bufferLength = (bufferLength > sizeof(rxBuffer)) ? sizeof(rxBuffer) : bufferLength;
+  rxIndex = 0;
+  rxLength = 0;
+  txLength = 0;
+  txAddress = 0;
+  transmitting = false;
+  inRequest = false;
+  slaveAddress = 0;
+  clockHz = 100000;
+  receiveHandler = NULL;
+  requestHandler = NULL;
+}
+
+// Like the real libraries, begin() puts the bus back to 100kHz
+void TwoWire::begin() {
+  end();
+  clockHz = 100000;
+  hostI2CBus.setClock(clockHz);
+}
+
+void TwoWire::begin(uint8_t address) {
+  begin();
+  slaveAddress = address;
+  hostI2CBus.attach(address, this);
+}
+
+void TwoWire::end() {
+  if (slaveAddress != 0) {
+    if (hostI2CBus.deviceAt(slaveAddress) == this) hostI2CBus.detach(slaveAddress);
+    slaveAddress = 0;
+  }
+  rxIndex = rxLength = txLength = 0;
+  transmitting = false;
+}
+
+void TwoWire::setClock(uint32_t hz) {
+  clockHz = hz;
+  hostI2CBus.setClock(hz);
+}
+
+void TwoWire::setClockStretchLimit(uint32_t us) {
+  hostI2CBus.setStretchLimit(us);
+}
+
+void TwoWire::beginTransmission(uint8_t address) {
+  transmitting = true;
+  txAddress = address;
+  txLength = 0;
+}
+
+uint8_t TwoWire::endTransmission(uint8_t sendStop) {
+  (void) sendStop;
+  hostI2CBus.setClock(clockHz);
+  uint8_t result = hostI2CBus.write(txAddress, txBuffer, txLength);
+  txLength = 0;
+  transmitting = false;
+  return result;
+}
+
+uint8_t TwoWire::requestFrom(uint8_t address, uint8_t quantity, uint8_t sendStop) {
+  (void) sendStop;
+  if (quantity > bufferLength) quantity = bufferLength;
+  hostI2CBus.setClock(clockHz);
+  rxLength = hostI2CBus.read(address, rxBuffer, quantity);
+  rxIndex = 0;
+  return rxLength;
+}
+
+size_t TwoWire::write(uint8_t data) {
+  if (!transmitting && !inRequest) return 0;
+  if (txLength >= bufferLength) return 0;
+  txBuffer[txLength++] = data;
+  return 1;
+}
+
+size_t TwoWire::write(const uint8_t* data, size_t quantity) {
+  size_t n = 0;
+  while ((n < quantity) && write(data[n])) n++;
+  return n;
+}
+
+int TwoWire::available() {
+  return rxLength - rxIndex;
+}
+
+int TwoWire::read() {
+  return (rxIndex < rxLength) ? rxBuffer[rxIndex++] : -1;
+}
+
+int TwoWire::peek() {
+  return (rxIndex < rxLength) ? rxBuffer[rxIndex] : -1;
+}
+
+void TwoWire::onReceive(void (*handler)(int)) {
+  receiveHandler = handler;
+}
+
+void TwoWire::onRequest(void (*handler)()) {
+  requestHandler = handler;
+}
+
+// The AVR slave NACKs once its buffer is full and drops the message
+bool TwoWire::i2cWrite(const uint8_t* data, size_t len) {
+  if (len > bufferLength) return false;
+  if (len == 0) return true;
+  memcpy(rxBuffer, data, len);
+  rxLength = len;
+  rxIndex = 0;
+  if (receiveHandler) receiveHandler(len);
+  return true;
+}
+
+size_t TwoWire::i2cRead(uint8_t* data, size_t len) {
+  txLength = 0;
+  inRequest = true;
+  if (requestHandler) requestHandler();
+  inRequest = false;
+  size_t n = (txLength < len) ? txLength : len;
+  memcpy(data, txBuffer, n);
+  txLength = 0;
+  return n;
+}
+
+// The TWI hardware holds SCL low from each byte's ACK until the interrupt has
+// dealt with it
+uint32_t TwoWire::stretchMicros(size_t bytes) {
+  return (uint32_t) (bytes + 1) * WIRE_SLAVE_BYTE_MICROS;
+}
+
+uint32_t TwoWire::serviceMicros(size_t bytes) {
+  return (uint32_t) (bytes + 1) * WIRE_SLAVE_BYTE_MICROS;
+}
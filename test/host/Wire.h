@@ -0,0 +1,77 @@
+// Host TwoWire on top of the virtual I2C bus.
+//
+// As a master it runs its transactions on hostI2CBus. After begin(address)
+// it is also a device on the bus and calls the onReceive and onRequest
+// handlers the way the AVR TWI interrupt would.
+#ifndef TwoWire_h
+#define TwoWire_h
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "I2CBus.h"
+
+// The AVR library's buffer, the ESP8266 one is 128
+#define BUFFER_LENGTH 32
+
+// What the AVR TWI interrupt costs per byte when we are the slave
+#define WIRE_SLAVE_BYTE_MICROS 6
+
+class TwoWire : public I2CDevice {
+  public:
+    explicit TwoWire(size_t bufferLength = BUFFER_LENGTH);
+
+    void begin();
+    void begin(uint8_t address);
+    void begin(int address) { begin((uint8_t) address); }
+    void begin(int sda, int scl) { (void) sda; (void) scl; begin(); }
+    void end();
+    void setClock(uint32_t hz);
+    void setClockStretchLimit(uint32_t us);
+
+    void beginTransmission(uint8_t address);
+    void beginTransmission(int address) { beginTransmission((uint8_t) address); }
+    uint8_t endTransmission(uint8_t sendStop = true);
+    uint8_t requestFrom(uint8_t address, uint8_t quantity, uint8_t sendStop = true);
+    uint8_t requestFrom(int address, int quantity) { return requestFrom((uint8_t) address, (uint8_t) quantity); }
+    uint8_t requestFrom(int address, int quantity, int sendStop) { return requestFrom((uint8_t) address, (uint8_t) quantity, (uint8_t) sendStop); }
+
+    size_t write(uint8_t data);
+    size_t write(const uint8_t* data, size_t quantity);
+    size_t write(int data) { return write((uint8_t) data); }
+    size_t write(unsigned int data) { return write((uint8_t) data); }
+    size_t write(long data) { return write((uint8_t) data); }
+    size_t write(unsigned long data) { return write((uint8_t) data); }
+    int available();
+    int read();
+    int peek();
+    void flush() {}
+
+    void onReceive(void (*handler)(int));
+    void onRequest(void (*handler)());
+
+    // I2CDevice, used while we are a slave
+    bool i2cWrite(const uint8_t* data, size_t len);
+    size_t i2cRead(uint8_t* data, size_t len);
+    uint32_t stretchMicros(size_t bytes);
+    uint32_t serviceMicros(size_t bytes);
+
+    bool isSlave() const { return slaveAddress != 0; }
+
+  private:
+    size_t bufferLength;
+    uint8_t rxBuffer[128];
+    size_t rxIndex;
+    size_t rxLength;
+    uint8_t txBuffer[128];
+    size_t txLength;
+    uint8_t txAddress;
+    bool transmitting;
+    bool inRequest;
+    uint8_t slaveAddress;
+    uint32_t clockHz;
+    void (*receiveHandler)(int);
+    void (*requestHandler)();
+};
+
+#endif
@@ -0,0 +1,2 @@
+// The AVR registers live in the host Arduino.h
+#include "Arduino.h"
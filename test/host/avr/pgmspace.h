@@ -0,0 +1,2 @@
+// Flash and RAM are the same thing on the host, see Arduino.h
+#include "Arduino.h"
@@ -0,0 +1,97 @@
+// The clock firmware built for the host, in namespace clockfw.
+//
+// Every header the sketch and its libraries use is pulled in here first, so
+// when they are included again from inside the namespace the guards make
+// them no-ops and only the firmware's own code lands in clockfw. The sketch
+// itself is clock_sketch.cpp, generated from the .ino by ino2cpp.py.
+#ifndef clock_firmware_h
+#define clock_firmware_h
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <inttypes.h>
+#include <sys/types.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "Arduino.h"
+#include "Wire.h"
+#include "EEPROM.h"
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+#include <util/atomic.h>
+
+namespace clockfw {
+  TwoWire Wire;
+  EEPROMClass EEPROM;
+}
+
+namespace clockfw {
+#include "Time.cpp"
+#undef PGM_P
+#undef pgm_read_byte
+#undef pgm_read_word
+#undef strcpy_P
+#include "DateStrings.cpp"
+#include "host_pgmspace.h"
+#include "DS3231.cpp"
+#include "ClockButton.cpp"
+#include "Transition.cpp"
+#include "ClockLogic.cpp"
+#include "clock_sketch.cpp"
+}
+
+// ------------------------------------------------------------------
+// Things every clock test needs
+// ------------------------------------------------------------------
+namespace clockhost {
+
+// One pass of the multiplexing loop: three compares and a counter, about
+// 26 cycles at 16MHz
+#define CLOCK_TICK_NANOS 1600
+
+// Anode bits per tube, as digitOn() sets them
+static const uint8_t anodeMaskC[6] = {B00001000, B00000100, 0, 0, 0, 0};
+static const uint8_t anodeMaskD[6] = {0, 0, B00010000, B00000100, B00000010, B00000001};
+
+static uint64_t ticks = 0;
+static uint64_t litTicks[6] = {0, 0, 0, 0, 0, 0};
+static uint32_t tickNanos = CLOCK_TICK_NANOS;
+static uint32_t tickNanosCarry = 0;
+
+// Count the tick, note which tube has its anode on, and let the time pass
+inline void tick() {
+  ticks++;
+  for (int i = 0 ; i < 6 ; i++) {
+    if ((PORTC & anodeMaskC[i]) || (PORTD & anodeMaskD[i])) litTicks[i]++;
+  }
+  tickNanosCarry += tickNanos;
+  hostAdvanceMicros(tickNanosCarry / 1000);
+  tickNanosCarry %= 1000;
+}
+
+inline void resetTicks() {
+  ticks = 0;
+  for (int i = 0 ; i < 6 ; i++) litTicks[i] = 0;
+}
+
+// Power the clock up as if it had been through its first boot already:
+// defaults in EEPROM, the HV divider reading the target voltage, and the
+// button not pressed
+inline void powerOn() {
+  hostDisplayTickHook = tick;
+  clockfw::EEPROM.erase();
+  clockfw::factoryReset();
+  clockfw::EEPROM.write(EE_NEED_SETUP, false);
+  clockfw::EEPROM.write(EE_HVG_NEED_CALIB, false);
+  hostAnalogIn[A0] = clockfw::getRawHVADCThreshold(clockfw::hvTargetVoltage);
+  clockfw::setup();
+}
+
+}
+
+#endif
@@ -0,0 +1,44 @@
+// The WiFi module firmware built for the host, in namespace espfw. See
+// clock_firmware.h for how the unity build works; the sketch itself is
+// esp_sketch.cpp, generated from the .ino by ino2cpp.py.
+#ifndef esp_firmware_h
+#define esp_firmware_h
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <inttypes.h>
+#include <sys/types.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "Arduino.h"
+#include "Wire.h"
+#include "EEPROM.h"
+#include "ESP8266WiFi.h"
+#include "WiFiClient.h"
+#include "ESP8266WebServer.h"
+#include "ESP8266HTTPClient.h"
+
+// The ESP8266 Wire library has a bigger buffer than the AVR one
+#define ESP_WIRE_BUFFER_LENGTH 128
+
+// EEPROM is a RAM copy, commit() erases and writes a 4k flash sector
+#define ESP_EEPROM_COMMIT_MICROS 30000
+
+namespace espfw {
+  TwoWire Wire(ESP_WIRE_BUFFER_LENGTH);
+  EEPROMClass EEPROM(0, ESP_EEPROM_COMMIT_MICROS);
+}
+
+namespace espfw {
+#include "DS3231.cpp"
+#include "WebLogic.cpp"
+#include "esp_sketch.cpp"
+}
+
+#endif
@@ -0,0 +1,20 @@
+// Flash and RAM are the same thing on the host. No include guard: the Time
+// library's DateStrings.cpp defines its own (wrong for word reads) versions
+// off AVR, so the firmware builds include this again after it.
+#undef PROGMEM
+#undef PGM_P
+#undef PSTR
+#undef F
+#undef pgm_read_byte
+#undef pgm_read_word
+#undef pgm_read_ptr
+#undef strcpy_P
+
+#define PROGMEM
+#define PGM_P const char *
+#define PSTR(x) x
+#define F(x) x
+#define pgm_read_byte(p) (*(const uint8_t*)(p))
+#define pgm_read_word(p) (*(const uint16_t*)(p))
+#define pgm_read_ptr(p) (*(void* const*)(p))
+#define strcpy_P strcpy
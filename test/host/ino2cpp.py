@@ -0,0 +1,42 @@
+#!/usr/bin/env python3
+"""Turn a sketch into C++ the way the Arduino IDE does: forward declare
+every function after the last #include, so the host compiler sees the same
+program the IDE builds.
+
+usage: ino2cpp.py <sketch.ino> <out.cpp>
+"""
+import re
+import sys
+
+KEYWORDS = ('else', 'return', 'switch', 'if', 'while', 'for', 'do', 'ISR')
+
+FUNCTION = re.compile(r'^([A-Za-z_][\w<>\*&\s]*?\s+\**)([A-Za-z_]\w*)\s*\(([^;{)]*)\)\s*\{', re.M)
+
+
+def prototypes(src):
+    found = []
+    for m in FUNCTION.finditer(src):
+        ret, name, args = m.group(1).strip(), m.group(2), m.group(3)
+        if ret in KEYWORDS or name in KEYWORDS:
+            continue
+        if ret.startswith(('struct', 'class', 'typedef')):
+            continue
+        # Default arguments belong to the definition, the IDE drops them too
+        args = re.sub(r'=\s*[^,]+', '', args)
+        found.append('%s %s(%s);' % (ret, name, args))
+    return found
+
+
+def main():
+    sketch, out = sys.argv[1], sys.argv[2]
+    src = open(sketch).read()
+    lines = src.split('\n')
+    last = max(i for i, l in enumerate(lines) if l.startswith('#include'))
+    body = lines[:last + 1] + prototypes(src) + ['#line %d "%s"' % (last + 2, sketch)] + lines[last + 1:]
+    with open(out, 'w') as f:
+        f.write('#line 1 "%s"\n' % sketch)
+        f.write('\n'.join(body))
+
+
+if __name__ == '__main__':
+    main()
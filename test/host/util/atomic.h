@@ -0,0 +1,9 @@
+#ifndef _UTIL_ATOMIC_H_
+#define _UTIL_ATOMIC_H_
+
+// Nothing interrupts the host build, so the blocks just run once
+#define ATOMIC_BLOCK(type) for (int __atomicDone = 0; __atomicDone == 0; __atomicDone = 1)
+#define ATOMIC_RESTORESTATE
+#define ATOMIC_FORCEON
+
+#endif
@@ -0,0 +1,125 @@
+#!/usr/bin/env python3
+"""Page load times of the WiFi module's web server, as a browser sees them.
+
+Fetches each page the given number of times, from a few clients at once,
+and prints the p50, p90 and p99 time to the last byte for each page and
+overall. Run it against a module on the network, once for each power mode
+(the /power page) to see what the idle time costs:
+
+    python3 page_load.py http://192.168.1.50 --requests 100 --clients 2
+
+`make load` in test/ runs it against the host build instead, the pages
+served by the co-simulation (cosim --serve). Those times leave out the
+ESP8266's own CPU time and its WiFi, so they are a lower bound.
+
+With --max-p99 the exit code is 1 if any page's p99 is over that many ms,
+so it can gate a change. --json writes the numbers out as well.
+"""
+
+import argparse
+import json
+import math
+import sys
+import threading
+import time
+import urllib.error
+import urllib.request
+
+PAGES = ["/", "/dashboard", "/timers", "/alarms", "/clockconfig", "/power", "/local.css"]
+
+
+def percentile(samples, pct):
+    """Nearest rank percentile of a sorted list"""
+    if not samples:
+        return float("nan")
+    rank = max(1, int(math.ceil(pct / 100.0 * len(samples))))
+    return samples[rank - 1]
+
+
+def fetch(url, timeout):
+    start = time.monotonic()
+    with urllib.request.urlopen(url, timeout=timeout) as response:
+        response.read()
+    return (time.monotonic() - start) * 1000.0
+
+
+def run(base, pages, requests, clients, timeout, gap):
+    work = [page for _ in range(requests) for page in pages]
+    lock = threading.Lock()
+    times = {page: [] for page in pages}
+    errors = {page: 0 for page in pages}
+
+    def client():
+        while True:
+            with lock:
+                if not work:
+                    return
+                page = work.pop(0)
+            try:
+                ms = fetch(base + page, timeout)
+                with lock:
+                    times[page].append(ms)
+            except (urllib.error.URLError, OSError):
+                with lock:
+                    errors[page] += 1
+            if gap > 0:
+                time.sleep(gap / 1000.0)
+
+    threads = [threading.Thread(target=client) for _ in range(clients)]
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+    return times, errors
+
+
+def summary(samples, errors):
+    samples = sorted(samples)
+    return {
+        "count": len(samples),
+        "errors": errors,
+        "p50_ms": percentile(samples, 50),
+        "p90_ms": percentile(samples, 90),
+        "p99_ms": percentile(samples, 99),
+        "max_ms": samples[-1] if samples else float("nan"),
+    }
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("base", help="the module, e.g. http://192.168.4.1")
+    parser.add_argument("--pages", nargs="+", default=PAGES, help="pages to fetch")
+    parser.add_argument("--requests", type=int, default=50, help="fetches of each page")
+    parser.add_argument("--clients", type=int, default=1, help="clients fetching at once")
+    parser.add_argument("--gap", type=float, default=0.0, help="ms each client waits between fetches")
+    parser.add_argument("--timeout", type=float, default=10.0, help="seconds before a fetch counts as an error")
+    parser.add_argument("--max-p99", type=float, help="fail if a page's p99 is over this many ms")
+    parser.add_argument("--json", help="write the results to this file")
+    args = parser.parse_args()
+
+    base = args.base.rstrip("/")
+    times, errors = run(base, args.pages, args.requests, args.clients, args.timeout, args.gap)
+
+    results = {page: summary(times[page], errors[page]) for page in args.pages}
+    results["all"] = summary([ms for page in args.pages for ms in times[page]], sum(errors.values()))
+
+    print("%-14s %6s %6s %9s %9s %9s %9s" % ("page", "count", "errors", "p50 ms", "p90 ms", "p99 ms", "max ms"))
+    for page, r in results.items():
+        print("%-14s %6d %6d %9.1f %9.1f %9.1f %9.1f" %
+              (page, r["count"], r["errors"], r["p50_ms"], r["p90_ms"], r["p99_ms"], r["max_ms"]))
+
+    if args.json:
+        with open(args.json, "w") as out:
+            json.dump({"base": base, "clients": args.clients, "requests": args.requests, "pages": results}, out, indent=2)
+
+    failed = results["all"]["errors"] > 0
+    if args.max_p99 is not None:
+        for page in args.pages:
+            if results[page]["p99_ms"] > args.max_p99:
+                print("%s: p99 %.1f ms is over %.1f ms" % (page, results[page]["p99_ms"], args.max_p99))
+                failed = True
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,123 @@
+// The aging offset trim (checkRTCDrift()) against a drifting DS3231 model,
+// and how the saved offset is read back from EEPROM.
+#include "clock_firmware.h"
+#include "VirtualDS3231.h"
+#include "HostCheck.h"
+
+using namespace clockfw;
+
+#define START_TIME   1792324800L   // 2026-10-18 12:00:00
+#define SYNC_SECS    3600          // the WiFi module syncs once an hour
+#define DAYS         60
+
+static VirtualDS3231* rtc;
+
+// Set the RTC's aging offset behind the clock's back, and let it take
+static void busWriteAging(signed char offset) {
+  uint8_t data[2] = {DS3231_REG_AGING, (uint8_t) offset};
+  hostI2CBus.write(DS3231_I2C_ADDRESS, data, 2);
+  data[0] = DS3231_REG_CONTROL;
+  data[1] = rtc->reg(DS3231_REG_CONTROL) | DS3231_CTL_CONV;
+  hostI2CBus.write(DS3231_I2C_ADDRESS, data, 2);
+  hostAdvanceMicros(DS3231_CONVERSION_MICROS);
+}
+
+// The WiFi time: exact, from virtual time
+static time_t wifiTime() {
+  return START_TIME + (time_t) (hostMicros / 1000000ULL);
+}
+
+static void wifiSync() {
+  setTime(wifiTime());
+  checkRTCDrift();
+}
+
+// Run the hourly syncs for this many days, return the RTC's worst error
+// against the WiFi time over the last day
+static double runDays(int days) {
+  double worst = 0.0;
+  for (long hours = 0 ; hours < days * 24L ; hours++) {
+    hostAdvanceMicros(SYNC_SECS * 1000000ULL - (hostMicros % 1000000ULL));
+    if (hours >= (days - 1) * 24L) {
+      double err = fabs(rtc->unixTimeExact() - (START_TIME + hostMicros / 1e6));
+      if (err > worst) worst = err;
+    }
+    wifiSync();
+  }
+  return worst;
+}
+
+static void testConverges(double drift, double swing) {
+  rtc->setDrift(drift);
+  rtc->setTempCoeff(-0.034);
+  rtc->setTemperatureCycle(25.0, swing);
+  rtcAgingOffset = 0;
+  busWriteAging(0);
+  rtcDriftBaseline = 0;
+
+  double worst = runDays(DAYS);
+  // What the RTC is left with, averaged over the temperature cycle
+  double residual = drift - 0.034 * swing * swing / 2.0 - DS3231_AGING_PPM_PER_STEP * rtcAgingOffset;
+  printf("  %+5.1fppm, %4.1fC swing: aging %4d, residual %+6.2fppm, worst %.2fs on the last day\n",
+         drift, swing, rtcAgingOffset, residual, worst);
+
+  CHECK(fabs(residual) < 1.0, "%.1fppm did not converge: %.2fppm left", drift, residual);
+  CHECK(worst <= RTC_DRIFT_MAX_SECS + 1.0, "RTC was %.2fs out", worst);
+  CHECK((signed char) EEPROM.read(EE_RTC_AGING) == rtcAgingOffset, "trim not saved");
+  CHECK(EEPROM.read(EE_RTC_AGING_VALID) == RTC_AGING_VALID, "trim not marked as saved");
+  CHECK((int8_t) rtc->reg(DS3231_REG_AGING) == rtcAgingOffset, "trim not in the RTC");
+}
+
+// ------------------------------------------------------------------
+// EEPROM
+// ------------------------------------------------------------------
+static void testUnknownOffset() {
+  // Erased: take the RTC's own offset, and don't save over the 0xFF until
+  // we know it
+  busWriteAging(12);
+  EEPROM.write(EE_RTC_AGING, 0xFF);
+  EEPROM.write(EE_RTC_AGING_VALID, 0xFF);
+  readEEPROMValues();
+  CHECK(!rtcAgingKnown, "erased EEPROM taken as an offset");
+  saveEEPROMValues();
+  CHECK(EEPROM.read(EE_RTC_AGING_VALID) != RTC_AGING_VALID, "unknown offset saved");
+  getRTCTime();
+  CHECK(rtcAgingOffset == 12, "RTC offset not read back: %d", rtcAgingOffset);
+  CHECK((int8_t) rtc->reg(DS3231_REG_AGING) == 12, "RTC offset overwritten");
+
+  // Out of range
+  EEPROM.write(EE_RTC_AGING, 0x80);
+  EEPROM.write(EE_RTC_AGING_VALID, RTC_AGING_VALID);
+  readEEPROMValues();
+  CHECK(!rtcAgingKnown, "-128 taken as an offset");
+
+  // A real offset goes to the RTC
+  EEPROM.write(EE_RTC_AGING, (uint8_t) -20);
+  readEEPROMValues();
+  getRTCTime();
+  CHECK(rtcAgingOffset == -20, "saved offset not used: %d", rtcAgingOffset);
+  CHECK((int8_t) rtc->reg(DS3231_REG_AGING) == -20, "saved offset not put in the RTC");
+
+  // -1 is the same byte as erased EEPROM, and a real offset
+  EEPROM.write(EE_RTC_AGING, (uint8_t) -1);
+  readEEPROMValues();
+  CHECK(rtcAgingKnown, "saved -1 taken as unknown");
+  getRTCTime();
+  CHECK(rtcAgingOffset == -1, "saved -1 not used: %d", rtcAgingOffset);
+  CHECK((int8_t) rtc->reg(DS3231_REG_AGING) == -1, "saved -1 not put in the RTC");
+}
+
+int main() {
+  rtc = new VirtualDS3231();
+  hostI2CBus.attach(DS3231_I2C_ADDRESS, rtc);
+  clockhost::powerOn();
+  useRTC = true;
+
+  testUnknownOffset();
+  testConverges(7.3, 0.0);
+  testConverges(-12.0, 0.0);
+  testConverges(4.0, 8.0);
+  testConverges(1.5, 0.0);
+
+  return hostCheckExit("aging_test");
+}
@@ -0,0 +1,62 @@
+// getRTCTime(), setRTC() and getRTCTemp() against the DS3231 model.
+//
+// The host time per call is what Google Benchmark measures. What matters on
+// the clock is the bus, so each benchmark also reports the virtual bus time
+// and the transactions per call, at the bus speed given as the argument.
+#include <benchmark/benchmark.h>
+
+#include "clock_firmware.h"
+#include "VirtualDS3231.h"
+
+using namespace clockfw;
+
+static VirtualDS3231* rtc = NULL;
+
+static void setUp(benchmark::State& state) {
+  if (rtc == NULL) {
+    rtc = new VirtualDS3231();
+    hostI2CBus.attach(DS3231_I2C_ADDRESS, rtc);
+    clockhost::powerOn();
+    setTime(12, 0, 0, 18, 10, 2026);
+    setRTC();
+  }
+  i2cFastMode = (state.range(0) > I2C_SPEED_STANDARD);
+  hostI2CBus.resetStats();
+}
+
+static void report(benchmark::State& state) {
+  const I2CStats& s = hostI2CBus.at(DS3231_I2C_ADDRESS);
+  state.counters["bus_us"] = benchmark::Counter((double) s.busyMicros, benchmark::Counter::kAvgIterations);
+  state.counters["xfers"] = benchmark::Counter((double) s.transactions, benchmark::Counter::kAvgIterations);
+  state.counters["bytes"] = benchmark::Counter((double) s.bytes, benchmark::Counter::kAvgIterations);
+}
+
+static void BM_getRTCTime(benchmark::State& state) {
+  setUp(state);
+  for (auto _ : state) {
+    getRTCTime();
+  }
+  report(state);
+}
+
+static void BM_setRTC(benchmark::State& state) {
+  setUp(state);
+  for (auto _ : state) {
+    setRTC();
+  }
+  report(state);
+}
+
+static void BM_getRTCTemp(benchmark::State& state) {
+  setUp(state);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(getRTCTemp());
+  }
+  report(state);
+}
+
+BENCHMARK(BM_getRTCTime)->Arg(I2C_SPEED_STANDARD)->Arg(I2C_SPEED_FAST);
+BENCHMARK(BM_setRTC)->Arg(I2C_SPEED_STANDARD)->Arg(I2C_SPEED_FAST);
+BENCHMARK(BM_getRTCTemp)->Arg(I2C_SPEED_STANDARD)->Arg(I2C_SPEED_FAST);
+
+BENCHMARK_MAIN();
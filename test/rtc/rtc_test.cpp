@@ -0,0 +1,243 @@
+// The clock's RTC code (getRTCTime(), setRTC(), getRTCTemp()) against the
+// DS3231 model, and the model itself.
+#include "clock_firmware.h"
+#include "VirtualDS3231.h"
+#include "HostCheck.h"
+
+using namespace clockfw;
+
+static VirtualDS3231* rtc;
+
+static time_t timeOf(int yr, int mo, int dy, int hr, int mi, int se) {
+  tmElements_t tm;
+  tm.Year = CalendarYrToTm(yr);
+  tm.Month = mo;
+  tm.Day = dy;
+  tm.Hour = hr;
+  tm.Minute = mi;
+  tm.Second = se;
+  return makeTime(tm);
+}
+
+static void busWrite(uint8_t reg, uint8_t value) {
+  uint8_t data[2] = {reg, value};
+  hostI2CBus.write(DS3231_I2C_ADDRESS, data, 2);
+}
+
+// ------------------------------------------------------------------
+// Firmware against the model
+// ------------------------------------------------------------------
+static void testBoot() {
+  CHECK(useRTC, "setup() did not find the RTC");
+
+  // A new RTC has OSF set, so the clock keeps its own time and starts the
+  // oscillator with the 1Hz square wave
+  CHECK(year() == 2017, "clock took the time of a stopped RTC: %d", year());
+  uint8_t control = rtc->reg(DS3231_REG_CONTROL);
+  CHECK(!(control & (DS3231_CTL_EOSC | DS3231_CTL_INTCN | DS3231_CTL_RS)), "control 0x%02x", control);
+  CHECK((control & DS3231_CTL_BBSQW), "no square wave on battery");
+  CHECK((int8_t) rtc->reg(DS3231_REG_AGING) == rtcAgingOffset, "aging offset not set");
+}
+
+static void testSetRTC() {
+  time_t t = timeOf(2026, 10, 18, 12, 34, 56);
+  setTime(t);
+  setRTC();
+
+  CHECK(rtc->unixTime() == t, "RTC has %lld, wanted %ld", (long long) rtc->unixTime(), (long) t);
+  CHECK(!(rtc->reg(DS3231_REG_STATUS) & DS3231_STAT_OSF), "setRTC() left OSF set");
+  CHECK(rtc->reg(DS3231_REG_DAY) == weekday(t), "day register %d", rtc->reg(DS3231_REG_DAY));
+  CHECK(!(rtc->reg(DS3231_REG_HOURS) & 0x40), "RTC left in 12h mode");
+}
+
+static void testGetRTCTime() {
+  time_t t = timeOf(2031, 2, 28, 23, 59, 58);
+  rtc->setUnixTime(t);
+  setTime(timeOf(2020, 1, 1, 0, 0, 0));
+  getRTCTime();
+  CHECK(now() == t, "clock has %ld, RTC had %ld", (long) now(), (long) t);
+
+  // Across the end of February and into March
+  hostAdvanceMillis(3000);
+  getRTCTime();
+  CHECK((month() == 3) && (day() == 1) && (hour() == 0) && (minute() == 0) && (second() == 1),
+        "%d-%d %d:%d:%d", month(), day(), hour(), minute(), second());
+
+  // The RTC lost our aging offset: put it back
+  busWrite(DS3231_REG_AGING, 17);
+  getRTCTime();
+  CHECK((int8_t) rtc->reg(DS3231_REG_AGING) == rtcAgingOffset, "aging offset not restored");
+}
+
+static void testOscillatorStop() {
+  time_t t = timeOf(2026, 10, 18, 12, 0, 0);
+  setTime(t);
+  setRTC();
+
+  // Power off with a flat battery: the RTC stops and flags it
+  rtc->setVcc(false);
+  rtc->setBatteryFlat(true);
+  hostAdvanceMillis(60000);
+  rtc->setVcc(true);
+  CHECK((rtc->reg(DS3231_REG_STATUS) & DS3231_STAT_OSF), "OSF not set by the stop");
+  CHECK(rtc->unixTime() == t, "stopped RTC kept time");
+
+  setTime(t + 3600);
+  getRTCTime();
+  CHECK(now() == t + 3600, "clock took the stopped RTC's time");
+  rtc->setBatteryFlat(false);
+}
+
+static void testTemperature() {
+  rtc->setTemperature(31.6);
+  hostAdvanceMillis(DS3231_CONVERSION_SECS * 1000L + 200);
+  getRTCTime();
+  CHECK(getRTCTemp() == 31.5f, "got %.2f", getRTCTemp());
+
+  // getRTCTemp() must not touch the bus, the clock is a slave there
+  uint32_t before = hostI2CBus.at(DS3231_I2C_ADDRESS).transactions;
+  getRTCTemp();
+  CHECK(hostI2CBus.at(DS3231_I2C_ADDRESS).transactions == before, "getRTCTemp() used the bus");
+  rtc->setTemperature(25.0);
+  hostAdvanceMillis(DS3231_CONVERSION_SECS * 1000L + 200);
+}
+
+// ------------------------------------------------------------------
+// The model
+// ------------------------------------------------------------------
+static void testDrift() {
+  rtc->setUnixTime(timeOf(2026, 1, 1, 0, 0, 0));
+  double start = rtc->unixTimeExact();
+  rtc->setDrift(20.0);
+  hostAdvanceMillis(86400000UL);
+  double gained = rtc->unixTimeExact() - start - 86400.0;
+  CHECK(fabs(gained - 1.728) < 0.01, "20ppm gained %.4fs in a day", gained);
+
+  // Aging offset: 0.1ppm a step, positive slows down. It applies from the
+  // next conversion.
+  busWrite(DS3231_REG_AGING, 50);
+  busWrite(DS3231_REG_CONTROL, rtc->reg(DS3231_REG_CONTROL) | DS3231_CTL_CONV);
+  CHECK((rtc->reg(DS3231_REG_STATUS) & DS3231_STAT_BSY), "no BSY during the conversion");
+  hostAdvanceMillis(200);
+  CHECK(!(rtc->reg(DS3231_REG_CONTROL) & DS3231_CTL_CONV), "CONV did not clear");
+  CHECK(fabs(rtc->ppm() - 15.0) < 1e-9, "ppm %.3f with aging 50", rtc->ppm());
+
+  // Crystal curve: at 45C, 20C off the turnover
+  rtc->setTempCoeff(-0.034);
+  rtc->setTemperature(45.0);
+  hostAdvanceMillis(DS3231_CONVERSION_SECS * 1000L + 200);
+  CHECK(fabs(rtc->ppm() - (20.0 - 0.034 * 400.0 - 5.0)) < 1e-9, "ppm %.3f at 45C", rtc->ppm());
+
+  rtc->setDrift(0.0);
+  rtc->setTempCoeff(0.0);
+  rtc->setTemperature(25.0);
+  busWrite(DS3231_REG_AGING, (uint8_t) rtcAgingOffset);
+  hostAdvanceMillis(DS3231_CONVERSION_SECS * 1000L + 200);
+}
+
+static void testSquareWave() {
+  // Set up by getRTCTime() at boot: 1Hz, falling edge on the seconds change
+  rtc->setUnixTime(timeOf(2026, 1, 1, 0, 0, 0));
+  bool last = rtc->sqw();
+  int falling = 0;
+  int onChange = 0;
+  int64_t lastSecs = rtc->unixTime();
+  for (int i = 0 ; i < 5000 ; i++) {
+    hostAdvanceMillis(1);
+    bool level = rtc->sqw();
+    int64_t secs = rtc->unixTime();
+    if (last && !level) {
+      falling++;
+      if (secs != lastSecs) onChange++;
+    }
+    last = level;
+    lastSecs = secs;
+  }
+  CHECK(falling == 5, "%d falling edges in 5s", falling);
+  CHECK(onChange == falling, "only %d of the edges were on a seconds change", onChange);
+}
+
+static void testAlarmAndRegisters() {
+  uint8_t control = rtc->reg(DS3231_REG_CONTROL);
+
+  // Alarm 1 once a second, on the interrupt pin
+  for (uint8_t r = 0x07 ; r <= 0x0a ; r++) busWrite(r, 0x80);
+  busWrite(DS3231_REG_STATUS, 0x00);
+  busWrite(DS3231_REG_CONTROL, DS3231_CTL_INTCN | DS3231_CTL_A1IE);
+  CHECK(rtc->sqw(), "INT active before the alarm");
+  hostAdvanceMillis(1000);
+  CHECK((rtc->reg(DS3231_REG_STATUS) & DS3231_STAT_A1F), "alarm 1 did not go off");
+  CHECK(!rtc->sqw(), "INT not active");
+
+  // Alarm 2 when the minutes match, so once an hour
+  busWrite(0x0b, 0x31);
+  busWrite(0x0c, 0x80);
+  busWrite(0x0d, 0x80);
+  rtc->setUnixTime(timeOf(2026, 1, 1, 10, 30, 58));
+  busWrite(DS3231_REG_STATUS, 0x00);
+  hostAdvanceMillis(1000);
+  CHECK(!(rtc->reg(DS3231_REG_STATUS) & DS3231_STAT_A2F), "alarm 2 went off early");
+  hostAdvanceMillis(1000);
+  CHECK((rtc->reg(DS3231_REG_STATUS) & DS3231_STAT_A2F), "alarm 2 did not go off");
+  busWrite(DS3231_REG_STATUS, 0x00);
+  hostAdvanceMillis(60000);
+  CHECK(!(rtc->reg(DS3231_REG_STATUS) & DS3231_STAT_A2F), "alarm 2 went off on the wrong minute");
+
+  // OSF can't be set by writing it
+  busWrite(DS3231_REG_STATUS, 0xff);
+  CHECK(!(rtc->reg(DS3231_REG_STATUS) & DS3231_STAT_OSF), "OSF set by a write");
+
+  // 12h mode, with the century bit and the pointer wrapping past 0x12
+  uint8_t burst[8] = {DS3231_REG_SECONDS, 0x00, 0x15, 0x40 | 0x20 | 0x11, 0x05, 0x31, 0x80 | 0x12, 0x01};
+  hostI2CBus.write(DS3231_I2C_ADDRESS, burst, 8);
+  CHECK(rtc->unixTime() == timeOf(2101, 12, 31, 23, 15, 0), "12h/century time wrong");
+  uint8_t ptr = DS3231_REG_TEMP_LSB;
+  uint8_t back[2];
+  hostI2CBus.write(DS3231_I2C_ADDRESS, &ptr, 1);
+  hostI2CBus.read(DS3231_I2C_ADDRESS, back, 2);
+  CHECK(back[1] == 0x00, "pointer did not wrap to the seconds");
+
+  busWrite(DS3231_REG_CONTROL, control);
+}
+
+// ------------------------------------------------------------------
+// What the RTC costs on the bus
+// ------------------------------------------------------------------
+static void reportBusCost(uint32_t hz) {
+  i2cFastMode = (hz > I2C_SPEED_STANDARD);
+  const char* names[3] = {"getRTCTime", "setRTC", "getRTCTemp"};
+  for (int i = 0 ; i < 3 ; i++) {
+    hostI2CBus.resetStats();
+    uint64_t start = hostMicros;
+    if (i == 0) getRTCTime();
+    else if (i == 1) setRTC();
+    else getRTCTemp();
+    const I2CStats& s = hostI2CBus.at(DS3231_I2C_ADDRESS);
+    printf("  %-10s %6u Hz %3u xfers %4u bytes %7.1f us on the bus %7.1f us in all\n",
+           names[i], hz, s.transactions, s.bytes, (double) s.busyMicros, (double) (hostMicros - start));
+    if (i == 0) CHECK(s.busyMicros < ((hz > I2C_SPEED_STANDARD) ? 1000 : 3000), "getRTCTime() is slow on the bus");
+  }
+  i2cFastMode = false;
+}
+
+int main() {
+  rtc = new VirtualDS3231();
+  hostI2CBus.attach(DS3231_I2C_ADDRESS, rtc);
+  clockhost::powerOn();
+
+  testBoot();
+  testSetRTC();
+  testGetRTCTime();
+  testOscillatorStop();
+  testTemperature();
+  testDrift();
+  testSquareWave();
+  testAlarmAndRegisters();
+
+  setTime(timeOf(2026, 10, 18, 12, 0, 0));
+  setRTC();
+  reportBusCost(I2C_SPEED_STANDARD);
+  reportBusCost(I2C_SPEED_FAST);
+
+  return hostCheckExit("rtc_test");
+}
@@ -0,0 +1,66 @@
+// Joining a new WLAN from the config page, against the host radio: when the
+// new network doesn't work out, the module has to stay reachable.
+#include "esp_firmware.h"
+#include "HostCheck.h"
+
+using namespace espfw;
+
+static void addNetwork(const char* ssid, const char* password) {
+  WiFiClass::HostNetwork network;
+  network.ssid = ssid;
+  network.password = password;
+  network.rssi = -60;
+  WiFi.hostNetworks.push_back(network);
+}
+
+static void runFor(uint32_t ms) {
+  uint64_t until = hostMicros + ms * 1000ULL;
+  while (hostMicros < until) {
+    loop();
+    hostAdvanceMicros(10000);
+  }
+}
+
+static void connectTo(const char* ssid, const char* password) {
+  std::vector<std::pair<String, String> > args;
+  args.push_back(std::make_pair(String("ssid"), String(ssid)));
+  args.push_back(std::make_pair(String("password"), String(password)));
+  server.request(HTTP_POST, "/wlan_config", args);
+}
+
+// A good network works, and is saved
+static void testJoin() {
+  connectTo("home", "secret");
+  CHECK(wlanConnectPending, "connect not started");
+  runFor(WLAN_CONNECT_TIMEOUT_MS / 2);
+  CHECK(!wlanConnectPending && !wlanConnectFailed, "did not join");
+  CHECK(getSSIDFromEEPROM() == "home", "credentials not saved");
+  CHECK(WiFi.status() == WL_CONNECTED, "not connected");
+}
+
+// A wrong password times out: back on the saved network, and the soft AP
+// up in case that doesn't come back either
+static void testTimeout() {
+  WiFi.mode(WIFI_STA);
+  connectTo("home", "wrong");
+  runFor(WLAN_CONNECT_TIMEOUT_MS + 1000);
+  CHECK(wlanConnectFailed, "timeout not reported");
+  CHECK(getPasswordFromEEPROM() == "secret", "bad credentials saved");
+  CHECK(WiFi.getMode() == WIFI_AP_STA, "soft AP not back, mode %d", WiFi.getMode());
+  CHECK(WiFi.apSSID == ap_ssid, "soft AP not started");
+  CHECK((WiFi.lastBeginSSID == "home") && (WiFi.lastBeginPassword == "secret"), "not back on the saved network");
+  runFor(WiFi.hostConnectMicros / 1000 + 1000);
+  CHECK(WiFi.status() == WL_CONNECTED, "did not get back on the saved network");
+}
+
+int main() {
+  addNetwork("home", "secret");
+  WiFi.hostConnectMicros = 1500000;
+  setup();
+  CHECK(WiFi.getMode() == WIFI_AP_STA, "no soft AP without credentials");
+
+  testJoin();
+  testTimeout();
+
+  return hostCheckExit("wlan_test");
+}